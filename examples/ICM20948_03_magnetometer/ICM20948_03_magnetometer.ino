@@ -59,6 +59,19 @@ void loop()
     myIMU.readSensor();
     xyzFloat magValue = myIMU.getMagValues(); // returns magnetic flux density [µT]
 
+    /* isNewMagData() tells you if readSensor() fetched a new magnetometer sample. The
+     * magnetometer measures with max. 100 Hz, so if you read faster you will see the
+     * same values several times. getMagSequence() counts the new samples.
+     * isMagOverflow() returns true if the magnetic field exceeded the measurement
+     * range. In this case the values are not valid.
+     */
+    Serial.print("Magnetometer sample no.: ");
+    Serial.print(myIMU.getMagSequence());
+    Serial.print("   new: ");
+    Serial.print(myIMU.isNewMagData());
+    Serial.print("   overflow: ");
+    Serial.println(myIMU.isMagOverflow());
+
     Serial.println("Magnetometer Data in µTesla: ");
     Serial.print(magValue.x);
     Serial.print("   ");
@@ -183,6 +183,10 @@ void setup()
 void loop()
 {
     if (dataReady) {
+        /* Alternative: ICM20948_intSnapshot snap = myIMU.readInterruptSnapshot(true);
+         * reads the interrupt status and the sensor data (like readSensor()) in one
+         * transaction if the Wire buffer is large enough (>= 45 bytes, e.g. ESP32).
+         * The interrupt source is snap.source. */
         byte source = myIMU.readAndClearInterrupts();
         if (myIMU.checkInterrupt(source, ICM20948_DATA_READY_INT)) {
             Serial.println("Interrupt Type: Data Ready");
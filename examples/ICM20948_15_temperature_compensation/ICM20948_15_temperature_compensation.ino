@@ -0,0 +1,99 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch shows how to compensate the temperature drift of the gyroscope and
+ * accelerometer offsets. The offsets you determine with autoOffsets() or
+ * setGyrOffsets() / setAccOffsets() are only valid for the temperature at which you
+ * determined them. The library can learn how the raw values change with temperature
+ * (linear, per axis) and corrects the offsets accordingly. The samples for learning
+ * are added by the sketch with addTempCompSample().
+ *
+ * For learning, the ICM20948 must not be moved while the temperature changes (e.g.
+ * after power-on, when the board warms up). The model improves with every sample,
+ * it is only applied once the temperature varied sufficiently.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <Wire.h>
+
+/* There are several ways to create your ICM20948 object:
+ * ICM20948 myIMU = ICM20948()              -> uses Wire / I2C Address = 0x69
+ * ICM20948 myIMU = ICM20948(ICM20948_ADDRESS) -> uses Wire / ICM20948_ADDRESS
+ * ICM20948 myIMU = ICM20948(&wire2)        -> uses the TwoWire object wire2 / ICM20948_ADDRESS
+ * ICM20948 myIMU = ICM20948(&wire2, ICM20948_ADDRESS) -> all together
+ */
+ICM20948 myIMU = ICM20948(ICM20948_ADDRESS);
+
+const unsigned long learningTime = 600000; // learn for 10 minutes
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    /* autoOffsets() also stores the temperature at which the offsets were measured.
+     * If you use setGyrOffsets() / setAccOffsets() instead, tell the library the
+     * temperature at which you determined the values:
+     */
+    // myIMU.setTempCompReference(23.5);
+    Serial.println("Position your ICM20948 flat and don't move it - calibrating...");
+    delay(1000);
+    myIMU.autoOffsets();
+    Serial.println("Done!");
+
+    /* The bias is only re-evaluated if the temperature changed by more than this
+     * value [°C] since the last evaluation (default: 0.1).
+     */
+    // myIMU.setTempCompThreshold(0.1);
+
+    /* Forget everything that has been learned so far */
+    // myIMU.resetTempCompModel();
+
+    /* Apply the learned model in getCorrectedXxxRawValues(), getGValues(),
+     * getGyrValues() and the corresponding FIFO functions. For FIFO data the
+     * temperature of the last readSensor() call is used.
+     */
+    myIMU.enableTempCompensation();
+    // myIMU.disableTempCompensation();
+
+    Serial.println("Learning temperature drift - don't move the ICM20948...");
+}
+
+void loop()
+{
+    myIMU.readSensor();
+
+    if (millis() < learningTime) {
+        myIMU.addTempCompSample();
+    }
+
+    xyzFloat gyr = myIMU.getGyrValues();
+    float temp = myIMU.getTemperature();
+
+    Serial.print("Temperature in °C: ");
+    Serial.print(temp);
+    Serial.print("   Model valid: ");
+    Serial.println(myIMU.isTempCompModelValid());
+
+    Serial.println("Gyroscope data in degrees/s: ");
+    Serial.print(gyr.x);
+    Serial.print("   ");
+    Serial.print(gyr.y);
+    Serial.print("   ");
+    Serial.println(gyr.z);
+
+    delay(1000);
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch shows how to let the library choose sample rate dividers, DLPF levels
+ * and the I2C master rate for the magnetometer. You specify the output rates you
+ * need and the maximum delay you accept. The library chooses the closest rates it can
+ * achieve and the widest filter bandwidth which is below half of the output rate
+ * (to avoid aliasing) and does not exceed the delay limit.
+ *
+ * The delays are estimates (filter group delay + half a sample period), the data
+ * sheet does not specify them.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <Wire.h>
+
+/* There are several ways to create your ICM20948 object:
+ * ICM20948 myIMU = ICM20948()              -> uses Wire / I2C Address = 0x69
+ * ICM20948 myIMU = ICM20948(ICM20948_ADDRESS) -> uses Wire / ICM20948_ADDRESS
+ * ICM20948 myIMU = ICM20948(&wire2)        -> uses the TwoWire object wire2 / ICM20948_ADDRESS
+ * ICM20948 myIMU = ICM20948(&wire2, ICM20948_ADDRESS) -> all together
+ */
+ICM20948 myIMU = ICM20948(ICM20948_ADDRESS);
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    if (!myIMU.initMagnetometer()) {
+        Serial.println("Magnetometer does not respond");
+    } else {
+        Serial.println("Magnetometer is connected");
+    }
+
+    /* setSampleRates(accRate, gyrRate, magRate, maxDelay) plans and applies the settings:
+     * accRate   desired accelerometer output rate [Hz], above 1125 Hz the DLPF is switched off (4500 Hz)
+     * gyrRate   desired gyroscope output rate [Hz], above 1125 Hz the DLPF is switched off (9000 Hz)
+     * magRate   desired magnetometer rate [Hz] (10, 20, 50 or 100), 0 = don't change the magnetometer
+     * maxDelay  maximum delay [ms], 0 = no limit
+     *
+     * With planSampleRates() you get the same result without applying it. You can modify
+     * it and apply it with applySampleRatePlan().
+     */
+    ICM20948_ratePlan plan = myIMU.setSampleRates(100.0, 200.0, 50.0, 10.0);
+
+    Serial.print("Accelerometer: divider = ");
+    Serial.print(plan.accDiv);
+    Serial.print(", DLPF = ");
+    Serial.print(plan.accDlpf);
+    Serial.print(", rate [Hz] = ");
+    Serial.print(plan.accRate);
+    Serial.print(", delay [ms] = ");
+    Serial.println(plan.accDelay);
+
+    Serial.print("Gyroscope:     divider = ");
+    Serial.print(plan.gyrDiv);
+    Serial.print(", DLPF = ");
+    Serial.print(plan.gyrDlpf);
+    Serial.print(", rate [Hz] = ");
+    Serial.print(plan.gyrRate);
+    Serial.print(", delay [ms] = ");
+    Serial.println(plan.gyrDelay);
+
+    /* The I2C master rate is 1.1 kHz / 2^exp. It only applies if accelerometer and
+     * gyroscope are disabled or in cycle mode, otherwise the I2C master runs with the
+     * gyroscope rate.
+     */
+    Serial.print("Magnetometer:  rate [Hz] = ");
+    Serial.print(plan.magRate);
+    Serial.print(", I2C master rate exponent = ");
+    Serial.println(plan.i2cMstRateExp);
+}
+
+void loop()
+{
+    myIMU.readSensor();
+    xyzFloat gValue = myIMU.getGValues();
+    xyzFloat gyr = myIMU.getGyrValues();
+
+    Serial.println("Acceleration in g (x,y,z):");
+    Serial.print(gValue.x);
+    Serial.print("   ");
+    Serial.print(gValue.y);
+    Serial.print("   ");
+    Serial.println(gValue.z);
+
+    Serial.println("Gyroscope data in degrees/s: ");
+    Serial.print(gyr.x);
+    Serial.print("   ");
+    Serial.print(gyr.y);
+    Serial.print("   ");
+    Serial.println(gyr.z);
+
+    delay(1000);
+}
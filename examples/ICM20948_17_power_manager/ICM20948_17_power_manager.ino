@@ -0,0 +1,150 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch shows how to use the power manager. It switches the ICM20948 between
+ * four states:
+ *
+ * ICM20948_PWR_SLEEP            everything off, only wakeup() leaves this state
+ * ICM20948_PWR_WAKE_ON_MOTION   accelerometer in low power mode, waits for motion
+ * ICM20948_PWR_LOW_POWER_CYCLE  accelerometer and gyroscope in cycle mode, data is
+ *                               collected in the FIFO
+ * ICM20948_PWR_STREAMING        full rate, read the data with readSensor()
+ *
+ * Motion is detected with the wake-on-motion interrupt. Connect the interrupt pin
+ * of the ICM20948 to pin 2. In a real application the MCU would sleep until the
+ * interrupt occurs or until getTimeToNextWakeup() has passed.
+ *
+ * For the low power mode the DLPF should be switched off (see example 08).
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_PowerManager.h>
+#include <Wire.h>
+
+/* There are several ways to create your ICM20948 object:
+ * ICM20948 myIMU = ICM20948()              -> uses Wire / I2C Address = 0x69
+ * ICM20948 myIMU = ICM20948(ICM20948_ADDRESS) -> uses Wire / ICM20948_ADDRESS
+ * ICM20948 myIMU = ICM20948(&wire2)        -> uses the TwoWire object wire2 / ICM20948_ADDRESS
+ * ICM20948 myIMU = ICM20948(&wire2, ICM20948_ADDRESS) -> all together
+ */
+ICM20948 myIMU = ICM20948(ICM20948_ADDRESS);
+ICM20948_PowerManager powerManager = ICM20948_PowerManager(&myIMU);
+
+const int intPin = 2;
+volatile bool womEvent = false;
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setAccDLPF(ICM20948_DLPF_OFF);
+    myIMU.setGyrDLPF(ICM20948_DLPF_OFF);
+    myIMU.enableIntLatch();
+
+    /* Wake-on-motion threshold, 1 = 4 mg ... 255 = 1020 mg */
+    powerManager.setWakeOnMotionThreshold(20);
+
+    /* Without motion for this time [ms], the power manager steps down one state:
+     * streaming -> low power cycle -> wake-on-motion
+     */
+    powerManager.setIdleTimeout(5000);
+
+    /* Without motion for this time [ms] in wake-on-motion state, the ICM20948 goes
+     * to sleep. 0 = never sleep (default)
+     */
+    // powerManager.setSleepTimeout(60000);
+
+    /* Number of motion events within a time window [ms] which switch from low power
+     * cycle mode to streaming
+     */
+    powerManager.setStreamingTrigger(5, 2000);
+
+    /* Sample rate dividers for the different states, see example 08 */
+    // powerManager.setWakeOnMotionSampleRateDivider(225);
+    // powerManager.setCycleSampleRateDivider(21, 21);
+    // powerManager.setStreamingSampleRateDivider(0, 0);
+
+    /* A FIFO batch is complete when it contains this number of bytes (12 bytes per
+     * data set, max. 4084 bytes). If there was motion while the batch was collected,
+     * the complete batch switches to streaming.
+     */
+    powerManager.setFifoBatchSize(1200);
+
+    /* For the energy estimate you can apply currents [µA] you measured for your board */
+    // powerManager.setStateCurrent(ICM20948_PWR_STREAMING, 3110.0);
+
+    attachInterrupt(digitalPinToInterrupt(intPin), womISR, RISING);
+    powerManager.begin(ICM20948_PWR_WAKE_ON_MOTION);
+}
+
+void loop()
+{
+    uint8_t intSource = 0;
+    if (womEvent) {
+        intSource = myIMU.readAndClearInterrupts();
+        womEvent = false;
+    }
+
+    ICM20948_powerState state = powerManager.update(intSource);
+
+    if (powerManager.isFifoBatchReady()) {
+        printFifo();
+    }
+
+    if (state == ICM20948_PWR_STREAMING) {
+        myIMU.readSensor();
+        xyzFloat gValue = myIMU.getGValues();
+        Serial.print("Streaming: ");
+        Serial.print(gValue.x);
+        Serial.print("   ");
+        Serial.print(gValue.y);
+        Serial.print("   ");
+        Serial.println(gValue.z);
+        delay(100);
+        return;
+    }
+
+    Serial.print("State: ");
+    Serial.print(state);
+    Serial.print("   next wakeup in [ms]: ");
+    Serial.print(powerManager.getTimeToNextWakeup());
+    Serial.print("   average current [µA]: ");
+    Serial.println(powerManager.getAverageCurrent());
+    delay(500);
+}
+
+void printFifo()
+{
+    int dataSets = myIMU.getNumberOfFifoDataSets();
+    Serial.print("FIFO batch with data sets: ");
+    Serial.println(dataSets);
+    for (int i = 0; i < dataSets; i++) {
+        xyzFloat gValue = myIMU.getGValuesFromFifo();
+        xyzFloat gyr = myIMU.getGyrValuesFromFifo();
+        if (i == dataSets - 1) {
+            Serial.print("Last data set: ");
+            Serial.print(gValue.z);
+            Serial.print("   ");
+            Serial.println(gyr.z);
+        }
+    }
+}
+
+void womISR()
+{
+    womEvent = true;
+}
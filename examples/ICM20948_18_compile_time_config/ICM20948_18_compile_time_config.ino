@@ -0,0 +1,74 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch shows how to use the compile time configured variant ICM20948T. If
+ * your settings never change, you can pass them as template parameters:
+ *
+ * ICM20948T<accRange, gyrRange, fifoType, accDLPF, gyrDLPF, accDivider, gyrDivider>
+ *
+ * Only accRange and gyrRange are mandatory. Defaults: ICM20948_FIFO_ACC_GYR,
+ * ICM20948_DLPF_6, ICM20948_DLPF_6, 0, 0.
+ *
+ * init() writes all settings at once without reading the registers first. Scale
+ * factors and the FIFO data set size are constants, and readFifoDataSets() reads
+ * complete data sets in bursts. All other functions of the ICM20948 class are
+ * available as well, but don't change the ranges or the FIFO type with them.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948T.h>
+#include <Wire.h>
+
+ICM20948T<ICM20948_ACC_RANGE_4G, ICM20948_GYRO_RANGE_500, ICM20948_FIFO_ACC_GYR, ICM20948_DLPF_6, ICM20948_DLPF_6, 10, 10>
+    myIMU(ICM20948_ADDRESS);
+
+const int maxSets = 20;
+xyzFloat gValues[maxSets];
+xyzFloat gyrValues[maxSets];
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    delay(100);
+    myIMU.startFifo();
+}
+
+void loop()
+{
+    delay(100); // ~10 data sets at 102 Hz
+
+    myIMU.findFifoBegin();
+    int sets = myIMU.readFifoDataSets(gValues, gyrValues, maxSets);
+
+    Serial.print("Data sets: ");
+    Serial.println(sets);
+    for (int i = 0; i < sets; i++) {
+        Serial.print(gValues[i].x);
+        Serial.print("   ");
+        Serial.print(gValues[i].y);
+        Serial.print("   ");
+        Serial.print(gValues[i].z);
+        Serial.print("   |   ");
+        Serial.print(gyrValues[i].x);
+        Serial.print("   ");
+        Serial.print(gyrValues[i].y);
+        Serial.print("   ");
+        Serial.println(gyrValues[i].z);
+    }
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch reads raw accelerometer and gyroscope data from the FIFO and sends
+ * it as compact binary packets (ICM20948_TelemetryEncoder) via Serial. Slowly
+ * changing values need about one byte instead of two. The packets can be decoded
+ * with ICM20948_TelemetryDecoder, e.g. with extras/host/examples/telemetry_decode.cpp
+ * on a PC.
+ *
+ * The serial output is binary, so don't use the serial monitor.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_Telemetry.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+const uint8_t maxSets = 20;
+int16_t rawData[maxSets * 6];
+uint8_t packet[ICM20948_TLM_HEADER_LEN + maxSets * 6 * ICM20948_TLM_MAX_VARINT_LEN + ICM20948_TLM_CRC_LEN];
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_TelemetryEncoder encoder(6);
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(460800);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        while (1) { }
+    }
+
+    myIMU.autoOffsets();
+    myIMU.setAccRange(ICM20948_ACC_RANGE_4G);
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setAccSampleRateDivider(10);
+    myIMU.setGyrRange(ICM20948_GYRO_RANGE_500);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrSampleRateDivider(10);
+
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    delay(100);
+    myIMU.startFifo(ICM20948_FIFO_ACC_GYR);
+}
+
+void loop()
+{
+    delay(100); // ~10 data sets at 102 Hz
+
+    myIMU.findFifoBegin();
+    uint16_t sets = myIMU.readFifoRawDataSets(rawData, maxSets);
+    if (sets == 0) {
+        return;
+    }
+    uint16_t len = encoder.encode(rawData, sets, packet, sizeof(packet));
+    Serial.write(packet, len);
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch reads the accelerometer at the full rate of 1125 Hz via the FIFO,
+ * filters the raw data and reduces the rate by 8 to ~140 Hz:
+ *
+ * 1. FIR lowpass and decimation (ICM20948_Decimator)
+ * 2. two biquad lowpass sections at 20 Hz (4th order Butterworth)
+ *
+ * One ICM20948_AxisFilter is used per axis. The filters are applied directly
+ * to the interleaved FIFO data (stride = 3). The filtered data of the last batch
+ * is printed.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_Filter.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+const uint8_t maxSets = 64; // 50 ms at 1125 Hz = 56 data sets
+const uint8_t decimation = 8;
+const float outputRate = 1125.0 / decimation;
+int16_t rawData[maxSets * 3];
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_AxisFilter filter[3];
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_2G);
+    myIMU.setAccDLPF(ICM20948_DLPF_OFF);
+    myIMU.setAccSampleRateDivider(0);
+
+    for (int i = 0; i < 3; i++) {
+        filter[i].decimator.design(decimation, 24);
+        filter[i].biquad.setLowPass(0, 20.0, outputRate, 0.5412); // Q values of a 4th order Butterworth
+        filter[i].biquad.setLowPass(1, 20.0, outputRate, 1.3066);
+    }
+
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    delay(100);
+    myIMU.startFifo(ICM20948_FIFO_ACC);
+}
+
+void loop()
+{
+    delay(50);
+
+    myIMU.findFifoBegin();
+    uint16_t sets = myIMU.readFifoRawDataSets(rawData, maxSets);
+
+    uint16_t outSets = 0;
+    for (int i = 0; i < 3; i++) {
+        outSets = filter[i].process(&rawData[i], sets, 3);
+    }
+
+    /* 2g range: 16384 LSB/g */
+    for (uint16_t i = 0; i < outSets; i++) {
+        Serial.print(rawData[i * 3] / 16384.0);
+        Serial.print("   ");
+        Serial.print(rawData[i * 3 + 1] / 16384.0);
+        Serial.print("   ");
+        Serial.println(rawData[i * 3 + 2] / 16384.0);
+    }
+}
@@ -0,0 +1,80 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch measures the vibration spectrum of the z-axis acceleration. The
+ * accelerometer runs at 1125 Hz, the data is read from the FIFO and passed to
+ * ICM20948_Spectrum, which calculates an averaged power spectrum over windows
+ * of 256 values (resolution: 1125 / 256 = 4.4 Hz). After 8 windows the three
+ * strongest peaks and the RMS value in two frequency bands are printed.
+ *
+ * RAM: ~1.3 kB for the spectrum, so use a board with more RAM than an UNO.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_Spectrum.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+const uint8_t maxSets = 64;
+const float gPerLsb = 2.0 / 32768.0; // 2g range
+int16_t rawData[maxSets * 3];
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_Spectrum<256> spectrum(1125.0);
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_2G);
+    myIMU.setAccDLPF(ICM20948_DLPF_OFF);
+    myIMU.setAccSampleRateDivider(0);
+
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    delay(100);
+    myIMU.startFifo(ICM20948_FIFO_ACC);
+}
+
+void loop()
+{
+    delay(50);
+
+    myIMU.findFifoBegin();
+    uint16_t sets = myIMU.readFifoRawDataSets(rawData, maxSets);
+    spectrum.addSamples(&rawData[2], sets, 3); // z-axis
+
+    if (spectrum.getWindowCount() < 8) {
+        return;
+    }
+
+    float freq[3], amplitude[3];
+    uint8_t peaks = spectrum.getPeaks(freq, amplitude, 3);
+    for (uint8_t i = 0; i < peaks; i++) {
+        Serial.print(freq[i]);
+        Serial.print(" Hz: ");
+        Serial.print(amplitude[i] * gPerLsb * 1000.0);
+        Serial.println(" mg");
+    }
+    Serial.print("RMS 10-100 Hz [mg]: ");
+    Serial.println(spectrum.getBandRms(10.0, 100.0) * gPerLsb * 1000.0);
+    Serial.print("RMS 100-500 Hz [mg]: ");
+    Serial.println(spectrum.getBandRms(100.0, 500.0) * gPerLsb * 1000.0);
+    Serial.println();
+
+    spectrum.resetAverage();
+}
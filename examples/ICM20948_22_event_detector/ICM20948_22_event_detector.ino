@@ -0,0 +1,95 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch detects steps, taps, double taps, free fall and changes of the
+ * activity level. The acceleration data (~102 Hz) is read from the FIFO in
+ * batches and passed to ICM20948_EventDetector, which only reports the events.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_EventDetector.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_EventDetector detector(&myIMU, 1125.0 / 11.0);
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    Serial.println("Position your ICM20948 flat and don't move it - calibrating...");
+    delay(1000);
+    myIMU.autoOffsets();
+    Serial.println("Done!");
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_8G); // taps can exceed 4 g
+    myIMU.setAccDLPF(ICM20948_DLPF_3);
+    myIMU.setAccSampleRateDivider(10);
+
+    /* optional, the values are the defaults:
+     * step: min. peak 0.05 g above the mean, min. 250 ms between steps
+     * tap: 1 g above the mean, max. 60 ms, second tap within 400 ms
+     * free fall: below 0.3 g for at least 100 ms
+     * activity: standard deviation of the resultant g > 0.03 g moving, > 0.4 g running
+     */
+    // detector.setStepParameters(0.05, 250);
+    // detector.setTapParameters(1.0, 60, 400);
+    // detector.setFreeFallParameters(0.3, 100);
+    // detector.setActivityThresholds(0.03, 0.4);
+
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    delay(100);
+    myIMU.startFifo(ICM20948_FIFO_ACC);
+}
+
+void loop()
+{
+    delay(100);
+
+    myIMU.findFifoBegin();
+    int count = myIMU.getNumberOfFifoDataSets();
+    for (int i = 0; i < count; i++) {
+        detector.addSample(myIMU.getGValuesFromFifo());
+    }
+
+    ICM20948_event evt;
+    while (detector.getEvent(&evt)) {
+        Serial.print(evt.time);
+        Serial.print(" ms: ");
+        switch (evt.type) {
+        case ICM20948_EVT_STEP:
+            Serial.print("step ");
+            Serial.println(evt.value);
+            break;
+        case ICM20948_EVT_TAP:
+            Serial.println("tap");
+            break;
+        case ICM20948_EVT_DOUBLE_TAP:
+            Serial.println("double tap");
+            break;
+        case ICM20948_EVT_FREE_FALL:
+            Serial.println("free fall");
+            break;
+        case ICM20948_EVT_ACTIVITY:
+            Serial.print("activity: ");
+            Serial.println(evt.value == ICM20948_ACT_STILL ? "still" : (evt.value == ICM20948_ACT_MOVING ? "moving" : "running"));
+            break;
+        }
+    }
+}
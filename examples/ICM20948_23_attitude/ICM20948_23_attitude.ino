@@ -0,0 +1,77 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * This sketch calculates the orientation by integrating every gyroscope sample
+ * from the FIFO (~102 Hz). In contrast to integrating getGyrValues() in the
+ * loop, no sample is lost, and the time step is exactly 1 / sample rate.
+ *
+ * The start orientation is aligned to gravity, so roll and pitch start with
+ * the actual tilt, yaw starts at 0. The angles drift slowly because of the
+ * remaining gyroscope offset.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_Attitude.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_Attitude attitude(1125.0 / 11.0); // divider 10
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    Serial.println("Position your ICM20948 flat and don't move it - calibrating...");
+    delay(1000);
+    myIMU.autoOffsets();
+    Serial.println("Done!");
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_2G);
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setAccSampleRateDivider(10);
+    myIMU.setGyrRange(ICM20948_GYRO_RANGE_500);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrSampleRateDivider(10);
+
+    myIMU.readSensor();
+    attitude.alignToGravity(myIMU.getGValues());
+
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    myIMU.startFifo(ICM20948_FIFO_ACC_GYR);
+}
+
+void loop()
+{
+    delay(100);
+
+    myIMU.findFifoBegin();
+    int count = myIMU.getNumberOfFifoDataSets();
+    for (int i = 0; i < count; i++) {
+        myIMU.getGValuesFromFifo(); // acceleration comes first in the FIFO
+        attitude.addSample(myIMU.getGyrValuesFromFifo());
+    }
+
+    xyzFloat angles = attitude.getEulerAngles();
+    Serial.print("Roll / Pitch / Yaw [°]: ");
+    Serial.print(angles.x);
+    Serial.print("   ");
+    Serial.print(angles.y);
+    Serial.print("   ");
+    Serial.println(angles.z);
+}
@@ -0,0 +1,111 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * init() and initMagnetometer() wait ~200 ms in total for the ICM20948 and the
+ * magnetometer (resets, I2C master). This sketch uses the non-blocking variants
+ * instead: initAsync(), initMagnetometerAsync() and setMagOpModeAsync() only
+ * start the sequence, step() continues it and returns immediately if the next
+ * step is not due yet. Meanwhile, the loop keeps running (here: an LED blinks).
+ *
+ * step() returns:
+ * ICM20948_ASYNC_BUSY    sequence still running, getAsyncReadyAt() returns the
+ *                        time (micros()) at which the next step is due
+ * ICM20948_ASYNC_DONE    sequence completed
+ * ICM20948_ASYNC_ERROR   ICM20948 or magnetometer did not respond
+ *
+ * Only one sequence can run at a time. resetMagAsync() and whoAmIMagAsync() work
+ * the same way, the value read by whoAmIMagAsync() is returned by getAsyncResult().
+ * autoOffsets() has no non-blocking variant.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+
+enum { START_INIT, INIT, START_MAG, MAG, RUNNING, FAILED } state = START_INIT;
+unsigned long lastBlink = 0;
+unsigned long lastPrint = 0;
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+    pinMode(LED_BUILTIN, OUTPUT);
+}
+
+void loop()
+{
+    /* some other task, not blocked by the initialization */
+    if (millis() - lastBlink > 50) {
+        lastBlink = millis();
+        digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+    }
+
+    switch (state) {
+    case START_INIT:
+        myIMU.initAsync();
+        state = INIT;
+        break;
+
+    case INIT:
+        switch (myIMU.step()) {
+        case ICM20948_ASYNC_DONE:
+            Serial.println("ICM20948 is connected");
+            state = START_MAG;
+            break;
+        case ICM20948_ASYNC_ERROR:
+            Serial.println("ICM20948 does not respond");
+            state = FAILED;
+            break;
+        default:
+            break;
+        }
+        break;
+
+    case START_MAG:
+        myIMU.initMagnetometerAsync();
+        state = MAG;
+        break;
+
+    case MAG:
+        switch (myIMU.step()) {
+        case ICM20948_ASYNC_DONE:
+            Serial.println("Magnetometer is connected");
+            state = RUNNING;
+            break;
+        case ICM20948_ASYNC_ERROR:
+            Serial.println("Magnetometer does not respond");
+            state = FAILED;
+            break;
+        default:
+            break;
+        }
+        break;
+
+    case RUNNING:
+        if (millis() - lastPrint > 500) {
+            lastPrint = millis();
+            myIMU.readSensor();
+            xyzFloat magValue = myIMU.getMagValues();
+            Serial.print("Magnetometer Data in µTesla: ");
+            Serial.print(magValue.x);
+            Serial.print("   ");
+            Serial.print(magValue.y);
+            Serial.print("   ");
+            Serial.println(magValue.z);
+        }
+        break;
+
+    case FAILED:
+        break;
+    }
+}
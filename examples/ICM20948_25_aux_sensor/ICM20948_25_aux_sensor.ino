@@ -0,0 +1,106 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * Additional I2C sensors can be connected to the auxiliary I2C bus of the
+ * ICM20948 (AUX_DA / AUX_CL). The internal I2C master reads them together with
+ * the magnetometer (SLV0) using the slaves SLV1 ... SLV3. Their data is stored
+ * behind the magnetometer data in EXT_SLV_SENS_DATA_xx, so readSensor() gets
+ * acc, gyr, temp, mag and the auxiliary data in one burst read.
+ *
+ * setAuxSlave(slave, addr, reg, len, decimate):
+ *   slave     1 ... 3
+ *   addr      I2C address of the auxiliary sensor
+ *   reg       first register to be read
+ *   len       number of bytes (1 ... 15, max. 24 - 9 for all slaves in total)
+ *   decimate  read the slave only every (1 + i2cMstDly) master cycles, with
+ *             i2cMstDly set by setAuxDecimation() (valid for all slaves)
+ *
+ * readAuxRegister() / writeAuxRegister() access single registers of the
+ * auxiliary sensors (e.g. for their configuration) via SLV4.
+ *
+ * Here a BMP280 (address 0x76) is used. The sketch prints its raw pressure
+ * and temperature values.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define BMP280_ADDR 0x76
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    /* initMagnetometer() enables the I2C master */
+    if (!myIMU.initMagnetometer()) {
+        Serial.println("Magnetometer does not respond");
+    } else {
+        Serial.println("Magnetometer is connected");
+    }
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setMagOpMode(AK09916_CONT_MODE_20HZ);
+
+    byte chipID = 0;
+    if (!myIMU.readAuxRegister(BMP280_ADDR, 0xD0, &chipID) || (chipID != 0x58)) {
+        Serial.println("BMP280 does not respond");
+    } else {
+        Serial.println("BMP280 is connected");
+    }
+    myIMU.writeAuxRegister(BMP280_ADDR, 0xF5, 0x10); // filter x16
+    myIMU.writeAuxRegister(BMP280_ADDR, 0xF4, 0x57); // osrs_t x2, osrs_p x16, normal mode
+
+    /* press_msb ... temp_xlsb (0xF7 ... 0xFC), read every 10th master cycle */
+    myIMU.setAuxDecimation(9);
+    if (!myIMU.setAuxSlave(1, BMP280_ADDR, 0xF7, 6, true)) {
+        Serial.println("Auxiliary slave could not be set");
+    }
+}
+
+void loop()
+{
+    myIMU.readSensor();
+    xyzFloat gValue = myIMU.getGValues();
+    xyzFloat magValue = myIMU.getMagValues();
+
+    byte aux[6];
+    myIMU.getAuxData(1, aux);
+    unsigned long rawPress = ((unsigned long)aux[0] << 12) | ((unsigned long)aux[1] << 4) | (aux[2] >> 4);
+    unsigned long rawTemp = ((unsigned long)aux[3] << 12) | ((unsigned long)aux[4] << 4) | (aux[5] >> 4);
+
+    Serial.print("Acceleration in g (x,y,z): ");
+    Serial.print(gValue.x);
+    Serial.print("   ");
+    Serial.print(gValue.y);
+    Serial.print("   ");
+    Serial.println(gValue.z);
+    Serial.print("Magnetometer data in µTesla: ");
+    Serial.print(magValue.x);
+    Serial.print("   ");
+    Serial.print(magValue.y);
+    Serial.print("   ");
+    Serial.println(magValue.z);
+    Serial.print("BMP280 raw pressure / temperature: ");
+    Serial.print(rawPress);
+    Serial.print("   ");
+    Serial.println(rawTemp);
+    Serial.println("********************************************");
+
+    delay(500);
+}
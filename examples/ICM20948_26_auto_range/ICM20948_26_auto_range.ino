@@ -0,0 +1,85 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * Automatic range switching: a small range gives the best resolution at rest,
+ * a large range avoids clipping during fast movements. With enableAutoRange()
+ * the library switches to the next higher range as soon as a value comes close
+ * to full scale and back to the next lower range if the values stayed small
+ * for a while.
+ *
+ * setAutoRangeLimits(upper, lower, lowSamples):
+ *   upper       fraction of full scale to switch up (default 0.9)
+ *   lower       fraction of full scale to switch down (default 0.3), limited to
+ *               less than upper / 2, so that switching down does not cause
+ *               switching up again
+ *   lowSamples  number of consecutive samples below lower to switch down
+ *               (default 100)
+ *
+ * The values returned by getGValues(), getGyrValues() and the ...FromFifo()
+ * functions are always scaled with the range at which they were measured, also
+ * for FIFO data from before a range switch. getAccRangeFactor() and
+ * getGyrRangeFactor() return the range of the last readSensor() data
+ * (1 = 2 g / 250 dps, 2 = 4 g / 500 dps, ...). For raw FIFO data read with
+ * readFifoRawDataSets() use getFifoAccRangeFactor() / getFifoGyrRangeFactor().
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setAccSampleRateDivider(10);
+    myIMU.setGyrSampleRateDivider(10);
+    myIMU.setAccRange(ICM20948_ACC_RANGE_2G);
+    myIMU.setGyrRange(ICM20948_GYRO_RANGE_250);
+
+    // myIMU.setAutoRangeLimits(0.9, 0.3, 100);
+    myIMU.enableAutoRange(true, true);
+}
+
+void loop()
+{
+    myIMU.readSensor();
+    xyzFloat gValue = myIMU.getGValues();
+    xyzFloat gyr = myIMU.getGyrValues();
+
+    Serial.print("Acc range: +/-");
+    Serial.print(2 * myIMU.getAccRangeFactor());
+    Serial.print(" g, g values: ");
+    Serial.print(gValue.x);
+    Serial.print("   ");
+    Serial.print(gValue.y);
+    Serial.print("   ");
+    Serial.println(gValue.z);
+    Serial.print("Gyr range: +/-");
+    Serial.print(250 * myIMU.getGyrRangeFactor());
+    Serial.print(" dps, values: ");
+    Serial.print(gyr.x);
+    Serial.print("   ");
+    Serial.print(gyr.y);
+    Serial.print("   ");
+    Serial.println(gyr.z);
+
+    delay(10);
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * Polling the FIFO without interrupts: ICM20948_FifoScheduler predicts the
+ * fill level of the FIFO and tells when the next batch is ready. The loop is
+ * free for other tasks in between, and the FIFO is only read when there is a
+ * complete batch. The fill rate estimate corrects itself with the observed
+ * FIFO counts, so a rough sample rate in begin() is sufficient.
+ *
+ * setTargetBatch(sets)      data sets to be read per poll
+ * setSafetyMargin(bytes)    the predicted fill level, including 25 % rate
+ *                           uncertainty, stays this much below the 4096 byte
+ *                           FIFO size (default: 512)
+ * getTimeToNextPoll()       µs until the next poll is due, e.g. to sleep
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_FifoScheduler.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define BATCH_SETS 20
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_FifoScheduler scheduler(&myIMU);
+int16_t data[BATCH_SETS * 6];
+unsigned long lastReport = 0;
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    ICM20948_ratePlan plan = myIMU.setSampleRates(100.0, 100.0);
+    myIMU.setFifoMode(ICM20948_CONTINUOUS);
+    myIMU.enableFifo();
+    myIMU.resetFifo();
+    myIMU.startFifo(ICM20948_FIFO_ACC_GYR);
+
+    scheduler.begin(plan.gyrRate, 12); // acc + gyr: 12 bytes per data set
+    scheduler.setTargetBatch(BATCH_SETS);
+}
+
+void loop()
+{
+    if (scheduler.isPollDue()) {
+        uint16_t sets = scheduler.read(data, BATCH_SETS);
+        float accRange = myIMU.getFifoAccRangeFactor() * 2.0 / 32768.0;
+        for (uint16_t i = 0; i < sets; i++) {
+            float accZ = data[i * 6 + 2] * accRange; // acc x, y, z, gyr x, y, z
+            (void)accZ; // process the data here
+        }
+    }
+
+    if (millis() - lastReport > 5000) {
+        lastReport = millis();
+        Serial.print("Data sets: ");
+        Serial.print(scheduler.getSetsRead());
+        Serial.print("   Polls: ");
+        Serial.print(scheduler.getPolls());
+        Serial.print("   Fill rate [bytes/s]: ");
+        Serial.print(scheduler.getFillRate());
+        Serial.print("   Full FIFO: ");
+        Serial.println(scheduler.getOverflows());
+    }
+}
@@ -0,0 +1,80 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * The gyroscope offsets drift with time and temperature. ICM20948_BiasEstimator
+ * detects periods in which the ICM20948 does not move and corrects the offsets
+ * with the mean gyroscope values measured in these periods. So the offsets stay
+ * up to date without recalibration.
+ *
+ * setWindow(seconds)              length of the evaluated windows (default 1 s)
+ * setStillThresholds(gyrStdDev, accStdDev, maxRate)
+ *                                 standard deviations [dps, g] and mean rotation
+ *                                 rate [dps] below which a window counts as still
+ *                                 (default 0.3 dps, 0.005 g, 3 dps)
+ * setWeight(weight)               weight of a new estimate (default 0.1)
+ * enableHardwareOffsets(true)     use the offset registers of the ICM20948, then
+ *                                 FIFO data is corrected as well
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_BiasEstimator.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define SAMPLE_RATE 100.0
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_BiasEstimator biasEstimator(&myIMU, SAMPLE_RATE);
+unsigned long lastSample = 0;
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    Serial.println("Position your ICM20948 flat and don't move it - calibrating...");
+    delay(1000);
+    myIMU.autoOffsets();
+    Serial.println("Done!");
+
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setSampleRates(SAMPLE_RATE, SAMPLE_RATE);
+
+    // biasEstimator.enableHardwareOffsets(true);
+    biasEstimator.begin(); // takes the offsets from autoOffsets() as start values
+}
+
+void loop()
+{
+    if (micros() - lastSample < 1000000.0 / SAMPLE_RATE) {
+        return;
+    }
+    lastSample = micros();
+
+    myIMU.readSensor();
+    xyzFloat gValue = myIMU.getGValues();
+    xyzFloat gyr = myIMU.getGyrValues();
+
+    if (biasEstimator.addSample(gValue, gyr)) {
+        xyzFloat bias = biasEstimator.getBias();
+        Serial.print("Bias updated [dps]: ");
+        Serial.print(bias.x, 3);
+        Serial.print("   ");
+        Serial.print(bias.y, 3);
+        Serial.print("   ");
+        Serial.println(bias.z, 3);
+    }
+}
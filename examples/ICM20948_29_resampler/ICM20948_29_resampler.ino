@@ -0,0 +1,94 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * Accelerometer and gyroscope run much faster than the magnetometer (max.
+ * 100 Hz). readSensor() returns the last magnetometer value, no matter how
+ * old it is. ICM20948_Resampler puts all three on a common time line and
+ * returns synchronized frames at the output rate, e.g. for sensor fusion.
+ *
+ * The acceleration and gyroscope values are pushed with each reading, the
+ * magnetometer values only when they are new (isNewMagData()). The time
+ * stamp is the time of the reading (micros()).
+ *
+ * setMode(stream, mode)   ICM20948_RESAMPLE_HOLD, ICM20948_RESAMPLE_LINEAR or
+ *                         ICM20948_RESAMPLE_CUBIC
+ *                         (default: linear for acc/gyr, hold for mag)
+ * setOutputRate(rate)     frames per second
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_Resampler.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define OUTPUT_RATE 50.0
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_Resampler resampler(OUTPUT_RATE);
+ICM20948_frame frames[4];
+
+void setup()
+{
+    Wire.begin();
+    Wire.setClock(400000);
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+    if (!myIMU.initMagnetometer()) {
+        Serial.println("Magnetometer does not respond");
+    } else {
+        Serial.println("Magnetometer is connected");
+    }
+
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setSampleRates(500.0, 500.0);
+    myIMU.setMagOpMode(AK09916_CONT_MODE_100HZ);
+
+    // resampler.setMode(ICM20948_STREAM_ACC, ICM20948_RESAMPLE_CUBIC);
+    // resampler.setMode(ICM20948_STREAM_GYR, ICM20948_RESAMPLE_CUBIC);
+}
+
+void loop()
+{
+    uint32_t now = micros();
+    myIMU.readSensor();
+    resampler.push(ICM20948_STREAM_ACC, now, myIMU.getGValues());
+    resampler.push(ICM20948_STREAM_GYR, now, myIMU.getGyrValues());
+    if (myIMU.isNewMagData()) {
+        resampler.push(ICM20948_STREAM_MAG, now, myIMU.getMagValues());
+    }
+
+    uint16_t n = resampler.getFrames(frames, 4);
+    for (uint16_t i = 0; i < n; i++) {
+        Serial.print(frames[i].time);
+        Serial.print("  g: ");
+        Serial.print(frames[i].acc.x, 3);
+        Serial.print(" ");
+        Serial.print(frames[i].acc.y, 3);
+        Serial.print(" ");
+        Serial.print(frames[i].acc.z, 3);
+        Serial.print("  gyr: ");
+        Serial.print(frames[i].gyr.x, 1);
+        Serial.print(" ");
+        Serial.print(frames[i].gyr.y, 1);
+        Serial.print(" ");
+        Serial.print(frames[i].gyr.z, 1);
+        Serial.print("  mag: ");
+        Serial.print(frames[i].mag.x, 1);
+        Serial.print(" ");
+        Serial.print(frames[i].mag.y, 1);
+        Serial.print(" ");
+        Serial.println(frames[i].mag.z, 1);
+    }
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * ICM20948_RollingStats keeps min, max, mean and RMS of the resultant
+ * acceleration and rotation rate for the last seconds, minutes and hours.
+ * Instead of the raw data, only these values (or the compact snapshot from
+ * writeSnapshot()) need to be sent, e.g. to a dashboard.
+ *
+ * The number of stored buckets per tier can be changed with the macros
+ * ICM20948_STATS_SECONDS, ICM20948_STATS_MINUTES and ICM20948_STATS_HOURS
+ * (compiler flags, defaults 10, 10, 24). Each bucket needs 20 bytes of RAM.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_RollingStats.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define SAMPLE_RATE 100.0
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_RollingStats stats(SAMPLE_RATE);
+unsigned long lastSample = 0;
+unsigned long lastReport = 0;
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    Serial.println("Position your ICM20948 flat and don't move it - calibrating...");
+    delay(1000);
+    myIMU.autoOffsets();
+    Serial.println("Done!");
+
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setSampleRates(SAMPLE_RATE, SAMPLE_RATE);
+}
+
+void printBucket(const char* name, ICM20948_statsBucket& bucket)
+{
+    Serial.print(name);
+    Serial.print("  g min/max/mean/rms: ");
+    Serial.print(bucket.acc.min, 3);
+    Serial.print(" ");
+    Serial.print(bucket.acc.max, 3);
+    Serial.print(" ");
+    Serial.print(bucket.acc.mean, 3);
+    Serial.print(" ");
+    Serial.print(bucket.acc.rms, 3);
+    Serial.print("  dps min/max/mean/rms: ");
+    Serial.print(bucket.gyr.min, 1);
+    Serial.print(" ");
+    Serial.print(bucket.gyr.max, 1);
+    Serial.print(" ");
+    Serial.print(bucket.gyr.mean, 1);
+    Serial.print(" ");
+    Serial.println(bucket.gyr.rms, 1);
+}
+
+void loop()
+{
+    if (micros() - lastSample >= 1000000.0 / SAMPLE_RATE) {
+        lastSample = micros();
+        myIMU.readSensor();
+        stats.addSample(myIMU.getGValues(), myIMU.getGyrValues());
+    }
+
+    if (millis() - lastReport >= 10000) {
+        lastReport = millis();
+        ICM20948_statsBucket bucket;
+        if (stats.getBucket(ICM20948_STATS_SECOND, 0, &bucket)) {
+            printBucket("Last second", bucket);
+        }
+        if (stats.getBucket(ICM20948_STATS_MINUTE, 0, &bucket)) {
+            printBucket("Last minute", bucket);
+        }
+        if (stats.getBucket(ICM20948_STATS_HOUR, 0, &bucket)) {
+            printBucket("Last hour  ", bucket);
+        }
+        Serial.print("Snapshot size [bytes]: ");
+        Serial.println(stats.getSnapshotSize());
+        Serial.println();
+    }
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * The ICM20948 shares the I2C bus with another sensor (here: a BMP280 at
+ * 0x76, replace it with whatever you have). Both drivers are clients of a
+ * ICM20948_BusArbiter. The ICM20948 locks the bus for each transaction
+ * including the bank switch and for multi-step sequences (magnetometer
+ * access), so its bank cache stays valid. The other driver locks the bus
+ * around its own transactions.
+ *
+ * The ICM20948 has the higher priority: if both are waiting for the bus, it
+ * gets the bus first. This matters if the drivers run in different contexts,
+ * e.g. RTOS tasks. In an interrupt service routine, don't use lock(): use
+ * request() and a grant callback, see ICM20948_BusArbiter.h.
+ *
+ * The latency histograms show how long the clients waited for the bus:
+ * bin i counts waiting times of 2^i ... 2^(i+1) - 1 µs.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_BusArbiter.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define OTHER_SENSOR_ADDR 0x76
+#define OTHER_SENSOR_ID_REG 0xD0
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_BusArbiter arbiter;
+uint8_t otherClient;
+unsigned long lastReport = 0;
+
+uint8_t readOtherSensorId()
+{
+    arbiter.lock(otherClient);
+    Wire.beginTransmission(OTHER_SENSOR_ADDR);
+    Wire.write(OTHER_SENSOR_ID_REG);
+    Wire.endTransmission(false);
+    Wire.requestFrom(OTHER_SENSOR_ADDR, 1);
+    uint8_t id = Wire.available() ? Wire.read() : 0;
+    arbiter.release(otherClient);
+    return id;
+}
+
+void printHistogram(const char* name, uint8_t client)
+{
+    const uint16_t* hist = arbiter.getLatencyHistogram(client);
+    Serial.print(name);
+    Serial.print(" grants: ");
+    Serial.print(arbiter.getGrants(client));
+    Serial.print(", max. latency [µs]: ");
+    Serial.print(arbiter.getMaxLatency(client));
+    Serial.print(", histogram:");
+    for (uint8_t i = 0; i < ICM20948_BUS_HIST_BINS; i++) {
+        Serial.print(" ");
+        Serial.print(hist[i]);
+    }
+    Serial.println();
+}
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    myIMU.setBusArbiter(&arbiter, 10); // before init()
+    otherClient = arbiter.addClient(1);
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+    if (!myIMU.initMagnetometer()) {
+        Serial.println("Magnetometer does not respond");
+    } else {
+        Serial.println("Magnetometer is connected");
+    }
+    myIMU.setMagOpMode(AK09916_CONT_MODE_20HZ);
+}
+
+void loop()
+{
+    myIMU.readSensor();
+    xyzFloat gValue = myIMU.getGValues();
+    uint8_t otherId = readOtherSensorId();
+
+    if (millis() - lastReport >= 2000) {
+        lastReport = millis();
+        Serial.print("g: ");
+        Serial.print(gValue.x, 2);
+        Serial.print(" ");
+        Serial.print(gValue.y, 2);
+        Serial.print(" ");
+        Serial.print(gValue.z, 2);
+        Serial.print("   other sensor ID: 0x");
+        Serial.println(otherId, HEX);
+        printHistogram("ICM20948", 0); // first client added to the arbiter
+        printHistogram("Other   ", otherClient);
+        Serial.println();
+    }
+}
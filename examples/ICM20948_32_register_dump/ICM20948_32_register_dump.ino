@@ -0,0 +1,92 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * dumpRegisters() reads the registers of all four banks in a few burst
+ * transactions (151 bytes) into an ICM20948_regDump. The clear on read status
+ * registers and FIFO_R_W are not read, so the dump doesn't change the state
+ * of the ICM20948. The dump can be printed or attached to an error report.
+ *
+ * diffRegisterDumps() compares a dump with an expected one, e.g. taken after
+ * the setup, and lists the configuration registers which differ. Measured
+ * values (sensor data, FIFO count, ...) are not compared.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_regDump expectedDump;
+ICM20948_regDump currentDump;
+ICM20948_regDiff diffs[10];
+
+void printHex(uint8_t val)
+{
+    if (val < 0x10) {
+        Serial.print("0");
+    }
+    Serial.print(val, HEX);
+}
+
+void setup()
+{
+    Wire.begin();
+    Wire.setClock(400000);
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_4G);
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrRange(ICM20948_GYRO_RANGE_500);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+
+    unsigned long start = micros();
+    myIMU.dumpRegisters(&expectedDump);
+    unsigned long duration = micros() - start;
+    Serial.print("Register dump [µs]: ");
+    Serial.println(duration);
+
+    for (uint8_t i = 0; i < ICM20948_REG_DUMP_LEN; i++) {
+        printHex(expectedDump.data[i]);
+        Serial.print((i % 16 == 15) ? "\n" : " ");
+    }
+    Serial.println();
+}
+
+void loop()
+{
+    delay(5000);
+
+    /* simulates a misconfiguration */
+    myIMU.setAccRange(ICM20948_ACC_RANGE_16G);
+
+    myIMU.dumpRegisters(&currentDump);
+    uint8_t n = ICM20948::diffRegisterDumps(&expectedDump, &currentDump, diffs, 10);
+    Serial.print("Differences: ");
+    Serial.println(n);
+    for (uint8_t i = 0; (i < n) && (i < 10); i++) {
+        Serial.print("Bank ");
+        Serial.print(diffs[i].bank);
+        Serial.print(", register 0x");
+        printHex(diffs[i].reg);
+        Serial.print(": expected 0x");
+        printHex(diffs[i].expected);
+        Serial.print(", actual 0x");
+        printHex(diffs[i].actual);
+        Serial.println();
+    }
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_4G);
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+ * Example sketch for the ICM20948 library
+ *
+ * ICM20948_AllanVariance computes the Allan deviation of the gyroscope and
+ * accelerometer values while the ICM20948 is at rest. Every minute, the
+ * table tau / ADEV and the estimated noise density and bias instability are
+ * printed. The longer the sketch runs, the more levels (longer averaging
+ * times) are available. Change the DLPF or averaging settings and compare.
+ *
+ * Each accumulator needs about 1 KB of RAM with the default of 20 levels.
+ * On boards with little RAM, reduce ICM20948_ALLAN_LEVELS (compiler flag)
+ * or use only one accumulator.
+ *
+ * For the overlapping Allan deviation of a complete recording, see the host
+ * tool extras/host/examples/allan.cpp.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ***************************************************************************/
+
+#include <ICM20948.h>
+#include <ICM20948_AllanVariance.h>
+#include <Wire.h>
+#define ICM20948_ADDR 0x68
+#define SAMPLE_RATE 100.0
+
+ICM20948 myIMU = ICM20948(ICM20948_ADDR);
+ICM20948_AllanVariance gyrAllan(SAMPLE_RATE);
+ICM20948_AllanVariance accAllan(SAMPLE_RATE);
+unsigned long lastSample = 0;
+unsigned long lastReport = 0;
+
+void setup()
+{
+    Wire.begin();
+    Serial.begin(115200);
+    while (!Serial) { }
+
+    if (!myIMU.init()) {
+        Serial.println("ICM20948 does not respond");
+    } else {
+        Serial.println("ICM20948 is connected");
+    }
+
+    myIMU.setAccRange(ICM20948_ACC_RANGE_2G);
+    myIMU.setGyrRange(ICM20948_GYRO_RANGE_250);
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setSampleRates(SAMPLE_RATE, SAMPLE_RATE);
+
+    Serial.println("Position your ICM20948 and don't move it - collecting data...");
+}
+
+void printAxes(const char* name, xyzFloat val, float factor)
+{
+    Serial.print(name);
+    Serial.print(val.x * factor, 3);
+    Serial.print(" ");
+    Serial.print(val.y * factor, 3);
+    Serial.print(" ");
+    Serial.println(val.z * factor, 3);
+}
+
+void loop()
+{
+    if (micros() - lastSample >= 1000000.0 / SAMPLE_RATE) {
+        lastSample = micros();
+        myIMU.readSensor();
+        gyrAllan.addSample(myIMU.getGyrValues());
+        accAllan.addSample(myIMU.getGValues());
+    }
+
+    if (millis() - lastReport >= 60000) {
+        lastReport = millis();
+        Serial.println("tau [s]   gyr ADEV x/y/z [dps]   acc ADEV x/y/z [mg]");
+        for (uint8_t k = 0; k < gyrAllan.getLevels(); k++) {
+            Serial.print(gyrAllan.getTau(k), 3);
+            Serial.print("   ");
+            xyzFloat gyrAdev = gyrAllan.getAdev(k);
+            xyzFloat accAdev = accAllan.getAdev(k);
+            Serial.print(gyrAdev.x, 4);
+            Serial.print(" ");
+            Serial.print(gyrAdev.y, 4);
+            Serial.print(" ");
+            Serial.print(gyrAdev.z, 4);
+            Serial.print("   ");
+            Serial.print(accAdev.x * 1000.0, 3);
+            Serial.print(" ");
+            Serial.print(accAdev.y * 1000.0, 3);
+            Serial.print(" ");
+            Serial.println(accAdev.z * 1000.0, 3);
+        }
+        printAxes("Gyr noise density [dps/sqrt(Hz)]: ", gyrAllan.getNoiseDensity(), 1.0);
+        printAxes("Gyr bias instability [deg/h]:      ", gyrAllan.getBiasInstability(), 3600.0);
+        printAxes("Acc noise density [ug/sqrt(Hz)]:   ", accAllan.getNoiseDensity(), 1000000.0);
+        printAxes("Acc bias instability [ug]:         ", accAllan.getBiasInstability(), 1000000.0);
+        Serial.println();
+    }
+}
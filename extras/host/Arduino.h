@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ * Minimal Arduino API for building the ICM20948 library on a host computer
+ * (Linux, macOS, Windows). Only what the library needs is provided.
+ *
+ * The clock can run in real time (default) or simulated. In simulated mode
+ * delay() returns immediately and only advances the clock, which allows
+ * replaying recordings faster than real time.
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_HOST_ARDUINO_H_
+#define ICM20948_HOST_ARDUINO_H_
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define sq(x) ((x) * (x))
+
+typedef uint8_t byte;
+
+/* Time */
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void hostSetSimulatedClock(bool simulated);
+void hostSetMicros(uint32_t us);
+
+/* Interrupts (no-ops on the host) */
+
+inline void noInterrupts() { }
+inline void interrupts() { }
+inline void yield() { }
+
+/* Output */
+
+class Print {
+public:
+    virtual ~Print() { }
+    virtual size_t write(uint8_t val) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len)
+    {
+        size_t n = 0;
+        while (len--) {
+            n += write(*buf++);
+        }
+        return n;
+    }
+};
+
+#endif
@@ -0,0 +1,154 @@
+/********************************************************************
+ * Host implementation of the minimal Arduino API and TwoWire.
+ *********************************************************************/
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#include <chrono>
+#include <thread>
+
+static bool simulatedClock = false;
+static uint32_t simulatedMicros = 0;
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+///////////////////////////////////////////////
+// Time
+///////////////////////////////////////////////
+
+uint32_t micros()
+{
+    if (simulatedClock) {
+        return simulatedMicros;
+    }
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime)
+        .count();
+}
+
+uint32_t millis()
+{
+    return micros() / 1000;
+}
+
+void delay(uint32_t ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if (simulatedClock) {
+        simulatedMicros += us;
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+void hostSetSimulatedClock(bool simulated)
+{
+    simulatedMicros = micros();
+    simulatedClock = simulated;
+}
+
+void hostSetMicros(uint32_t us)
+{
+    simulatedMicros = us;
+}
+
+///////////////////////////////////////////////
+// TwoWire
+///////////////////////////////////////////////
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+{
+    _backend = nullptr;
+    txAddr = 0;
+    txLen = 0;
+    txPending = false;
+    rxLen = 0;
+    rxPos = 0;
+}
+
+void TwoWire::setBackend(TwoWireBackend* backend)
+{
+    _backend = backend;
+}
+
+void TwoWire::begin() { }
+
+void TwoWire::setClock(uint32_t) { }
+
+void TwoWire::beginTransmission(int addr)
+{
+    txAddr = addr;
+    txLen = 0;
+    txPending = false;
+}
+
+size_t TwoWire::write(uint8_t val)
+{
+    if (txLen >= BUFFER_LENGTH) {
+        return 0;
+    }
+    txBuf[txLen++] = val;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* buf, size_t len)
+{
+    size_t n = 0;
+    while (len-- && write(*buf++)) {
+        n++;
+    }
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    if (!sendStop) {
+        txPending = true;
+        return 0;
+    }
+    if (!_backend) {
+        return 4;
+    }
+    uint8_t status = _backend->transfer(txAddr, txBuf, txLen, nullptr, 0);
+    txLen = 0;
+    return status;
+}
+
+uint8_t TwoWire::requestFrom(int addr, int len)
+{
+    rxLen = 0;
+    rxPos = 0;
+    if (len > BUFFER_LENGTH) {
+        len = BUFFER_LENGTH;
+    }
+    if (!_backend || (len <= 0)) {
+        return 0;
+    }
+    size_t tx = (txPending && (txAddr == addr)) ? txLen : 0;
+    uint8_t status = _backend->transfer(addr, txBuf, tx, rxBuf, len);
+    txPending = false;
+    txLen = 0;
+    if (status != 0) {
+        return 0;
+    }
+    rxLen = len;
+    return len;
+}
+
+int TwoWire::available()
+{
+    return rxLen - rxPos;
+}
+
+int TwoWire::read()
+{
+    if (rxPos >= rxLen) {
+        return -1;
+    }
+    return rxBuf[rxPos++];
+}
@@ -0,0 +1,89 @@
+/********************************************************************
+ * Linux i2c-dev backend for host builds.
+ *********************************************************************/
+
+#include "ICM20948_LinuxI2C.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+ICM20948_LinuxI2C::ICM20948_LinuxI2C()
+{
+    fd = -1;
+    lastErrno = 0;
+}
+
+ICM20948_LinuxI2C::~ICM20948_LinuxI2C()
+{
+    close();
+}
+
+bool ICM20948_LinuxI2C::open(const char* device)
+{
+    close();
+    fd = ::open(device, O_RDWR);
+    if (fd < 0) {
+        lastErrno = errno;
+        return false;
+    }
+    return true;
+}
+
+void ICM20948_LinuxI2C::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool ICM20948_LinuxI2C::isOpen()
+{
+    return fd >= 0;
+}
+
+int ICM20948_LinuxI2C::getLastErrno()
+{
+    return lastErrno;
+}
+
+uint8_t ICM20948_LinuxI2C::transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen)
+{
+    if (fd < 0) {
+        return 4;
+    }
+
+    struct i2c_msg msgs[2];
+    int n = 0;
+    if (txLen > 0) {
+        msgs[n].addr = addr;
+        msgs[n].flags = 0;
+        msgs[n].len = txLen;
+        msgs[n].buf = const_cast<uint8_t*>(tx);
+        n++;
+    }
+    if (rxLen > 0) {
+        msgs[n].addr = addr;
+        msgs[n].flags = I2C_M_RD;
+        msgs[n].len = rxLen;
+        msgs[n].buf = rx;
+        n++;
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    struct i2c_rdwr_ioctl_data data;
+    data.msgs = msgs;
+    data.nmsgs = n;
+    if (ioctl(fd, I2C_RDWR, &data) < 0) {
+        lastErrno = errno;
+        /* Arduino Wire codes: 2 = NACK on address, 4 = other error */
+        return ((errno == ENXIO) || (errno == EREMOTEIO)) ? 2 : 4;
+    }
+    return 0;
+}
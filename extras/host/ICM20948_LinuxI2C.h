@@ -0,0 +1,39 @@
+/******************************************************************************
+ *
+ * TwoWire backend for Linux i2c-dev (/dev/i2c-N), e.g. on a Raspberry Pi. A
+ * write followed by a read is sent as one combined I2C_RDWR transfer (write,
+ * repeated start, read), as the ICM20948 class expects it.
+ *
+ * Usage:
+ *
+ *   ICM20948_LinuxI2C bus;
+ *   bus.open("/dev/i2c-1");
+ *   Wire.setBackend(&bus);
+ *   ICM20948 myIMU(&Wire, 0x68);
+ *
+ * The user needs read/write access to the device, e.g. membership in the
+ * group i2c.
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_LINUX_I2C_H_
+#define ICM20948_LINUX_I2C_H_
+
+#include "Wire.h"
+
+class ICM20948_LinuxI2C : public TwoWireBackend {
+public:
+    ICM20948_LinuxI2C();
+    ~ICM20948_LinuxI2C();
+    bool open(const char* device);
+    void close();
+    bool isOpen();
+    int getLastErrno();
+    uint8_t transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) override;
+
+private:
+    int fd;
+    int lastErrno;
+};
+
+#endif
@@ -0,0 +1,217 @@
+/********************************************************************
+ * Multi-threaded processing pipeline for host builds.
+ *********************************************************************/
+
+#include "ICM20948_Pipeline.h"
+
+#include <chrono>
+
+ICM20948_Pipeline::ICM20948_Pipeline(ICM20948* icm, const ICM20948_pipeConfig& config)
+    : attitude(config.sampleRate)
+{
+    _icm = icm;
+    cfg = config;
+    pool = new ICM20948_batch[ICM20948_PIPE_POOL_SIZE];
+    running = false;
+}
+
+ICM20948_Pipeline::~ICM20948_Pipeline()
+{
+    stop();
+    delete[] pool;
+}
+
+void ICM20948_Pipeline::setOutput(std::function<void(const ICM20948_batch&)> output)
+{
+    outputFunc = output;
+}
+
+void ICM20948_Pipeline::start()
+{
+    if (running) {
+        return;
+    }
+    uint8_t idx;
+    while (calibQueue.pop(idx) || fusionQueue.pop(idx) || outputQueue.pop(idx) || freeQueue.pop(idx)) { }
+    for (uint8_t i = 0; i < ICM20948_PIPE_POOL_SIZE; i++) {
+        freeQueue.push(i);
+    }
+    batches = 0;
+    sets = 0;
+    droppedSets = 0;
+    latencyMax = 0;
+    latencySum = 0;
+    maxDepth = 0;
+    for (int i = 0; i < 4; i++) {
+        busy[i] = 0;
+    }
+    attitude.reset();
+
+    _icm->setFifoMode(ICM20948_CONTINUOUS);
+    _icm->enableFifo();
+    _icm->resetFifo();
+    _icm->startFifo(ICM20948_FIFO_ACC_GYR);
+
+    running = true;
+    threads[0] = std::thread(&ICM20948_Pipeline::acquire, this);
+    threads[1] = std::thread(&ICM20948_Pipeline::calibrate, this);
+    threads[2] = std::thread(&ICM20948_Pipeline::fuse, this);
+    threads[3] = std::thread(&ICM20948_Pipeline::output, this);
+}
+
+void ICM20948_Pipeline::stop()
+{
+    if (!running) {
+        return;
+    }
+    running = false;
+    for (int i = 0; i < 4; i++) {
+        threads[i].join();
+    }
+    _icm->stopFifo();
+}
+
+ICM20948_pipeStats ICM20948_Pipeline::getStats()
+{
+    ICM20948_pipeStats st;
+    st.batches = batches;
+    st.sets = sets;
+    st.droppedSets = droppedSets;
+    st.maxQueueDepth = maxDepth;
+    for (int i = 0; i < 4; i++) {
+        st.busyMicros[i] = busy[i];
+    }
+    st.maxLatencyMicros = latencyMax;
+    st.sumLatencyMicros = latencySum;
+    return st;
+}
+
+void ICM20948_Pipeline::idle()
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+void ICM20948_Pipeline::noteDepth(size_t depth)
+{
+    uint32_t prev = maxDepth;
+    while ((depth > prev) && !maxDepth.compare_exchange_weak(prev, depth)) { }
+}
+
+///////////////////////////////////////////////
+// Stages
+///////////////////////////////////////////////
+
+void ICM20948_Pipeline::acquire()
+{
+    uint32_t sequence = 0;
+    uint32_t nextPoll = micros();
+    bool haveBatch = false; // kept while empty, freeQueue has only one producer (output)
+    uint8_t idx = 0;
+
+    while (running) {
+        int32_t wait = (int32_t)(nextPoll - micros());
+        if (wait > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(wait));
+        }
+        nextPoll += cfg.pollIntervalMicros;
+        uint32_t start = micros();
+
+        if (!haveBatch) {
+            haveBatch = freeQueue.pop(idx);
+        }
+        if (!haveBatch) {
+            droppedSets += _icm->readFifoRawDataSets(scratch, ICM20948_PIPE_MAX_SETS);
+            busy[0] += micros() - start;
+            continue;
+        }
+        ICM20948_batch& b = pool[idx];
+        b.sets = _icm->readFifoRawDataSets(b.raw, ICM20948_PIPE_MAX_SETS);
+        b.timestamp = micros();
+        busy[0] += b.timestamp - start;
+        if (b.sets == 0) {
+            continue;
+        }
+        b.sequence = sequence++;
+        sets += b.sets;
+        calibQueue.push(idx);
+        noteDepth(calibQueue.size());
+        haveBatch = false;
+    }
+}
+
+void ICM20948_Pipeline::calibrate()
+{
+    float accScale = cfg.accRangeFactor / 16384.0;
+    float gyrScale = cfg.gyrRangeFactor * 250.0 / 32768.0;
+    xyzFloat accOffs = { cfg.accOffset.x / cfg.accRangeFactor, cfg.accOffset.y / cfg.accRangeFactor,
+        cfg.accOffset.z / cfg.accRangeFactor };
+    xyzFloat gyrOffs = { cfg.gyrOffset.x / cfg.gyrRangeFactor, cfg.gyrOffset.y / cfg.gyrRangeFactor,
+        cfg.gyrOffset.z / cfg.gyrRangeFactor };
+
+    while (running) {
+        uint8_t idx;
+        if (!calibQueue.pop(idx)) {
+            idle();
+            continue;
+        }
+        uint32_t start = micros();
+        ICM20948_batch& b = pool[idx];
+        const int16_t* raw = b.raw;
+        for (uint16_t i = 0; i < b.sets; i++) {
+            b.acc[i].x = (raw[0] - accOffs.x) * accScale;
+            b.acc[i].y = (raw[1] - accOffs.y) * accScale;
+            b.acc[i].z = (raw[2] - accOffs.z) * accScale;
+            b.gyr[i].x = (raw[3] - gyrOffs.x) * gyrScale;
+            b.gyr[i].y = (raw[4] - gyrOffs.y) * gyrScale;
+            b.gyr[i].z = (raw[5] - gyrOffs.z) * gyrScale;
+            raw += 6;
+        }
+        busy[1] += micros() - start;
+        fusionQueue.push(idx);
+        noteDepth(fusionQueue.size());
+    }
+}
+
+void ICM20948_Pipeline::fuse()
+{
+    while (running) {
+        uint8_t idx;
+        if (!fusionQueue.pop(idx)) {
+            idle();
+            continue;
+        }
+        uint32_t start = micros();
+        ICM20948_batch& b = pool[idx];
+        attitude.addSamples(b.gyr, b.acc, b.sets);
+        b.orientation = attitude.getOrientation();
+        busy[2] += micros() - start;
+        outputQueue.push(idx);
+        noteDepth(outputQueue.size());
+    }
+}
+
+void ICM20948_Pipeline::output()
+{
+    while (running) {
+        uint8_t idx;
+        if (!outputQueue.pop(idx)) {
+            idle();
+            continue;
+        }
+        uint32_t start = micros();
+        ICM20948_batch& b = pool[idx];
+        if (outputFunc) {
+            outputFunc(b);
+        }
+        uint32_t end = micros();
+        busy[3] += end - start;
+
+        uint32_t latency = end - b.timestamp;
+        latencySum += latency;
+        if (latency > latencyMax) {
+            latencyMax = latency;
+        }
+        batches++;
+        freeQueue.push(idx);
+    }
+}
@@ -0,0 +1,146 @@
+/******************************************************************************
+ *
+ * Multi-threaded processing pipeline for host builds (Linux gateways etc.).
+ *
+ *   acquisition -> calibration -> fusion -> output
+ *
+ * The acquisition thread is the only thread which accesses the ICM20948 (and the
+ * bus). It drains the FIFO (acceleration and gyroscope data sets) in bursts into
+ * batches. The batches are taken from a fixed pool and passed between the
+ * threads as indices through single producer / single consumer lock-free queues,
+ * so no data is copied and no lock is taken. Only the output stage returns
+ * batches to the pool, an empty batch stays with the acquisition. If no free
+ * batch is available, the acquisition reads and drops the data to keep the FIFO
+ * from overflowing.
+ *
+ * Usage:
+ *
+ *   ICM20948_Pipeline pipeline(&myIMU, config);
+ *   pipeline.setOutput([](const ICM20948_batch& b) { ... });
+ *   pipeline.start();
+ *   ...
+ *   pipeline.stop();
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_PIPELINE_H_
+#define ICM20948_PIPELINE_H_
+
+#include "ICM20948.h"
+#include "ICM20948_Attitude.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#define ICM20948_PIPE_MAX_SETS (ICM20948_FIFO_SIZE / 12 + 1)
+#define ICM20948_PIPE_POOL_SIZE 16 // power of 2
+
+template <class T, size_t N>
+class ICM20948_SpscQueue {
+    static_assert((N & (N - 1)) == 0, "N must be a power of 2");
+
+public:
+    ICM20948_SpscQueue()
+        : head(0)
+        , tail(0)
+    {
+    }
+
+    bool push(const T& val)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if ((t - head.load(std::memory_order_acquire)) == N) {
+            return false;
+        }
+        buf[t & (N - 1)] = val;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& val)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        val = buf[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size()
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    T buf[N];
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+struct ICM20948_pipeConfig {
+    float sampleRate; // Hz, output data rate of the FIFO data
+    uint8_t accRangeFactor; // 1, 2, 4, 8 (2 g ... 16 g)
+    uint8_t gyrRangeFactor; // 1, 2, 4, 8 (250 ... 2000 degrees/s)
+    xyzFloat accOffset; // raw, range independent (as with 2 g)
+    xyzFloat gyrOffset; // raw, range independent (as with 250 degrees/s)
+    uint32_t pollIntervalMicros;
+};
+
+struct ICM20948_batch {
+    uint32_t sequence;
+    uint32_t timestamp; // micros() after the FIFO was read
+    uint16_t sets;
+    int16_t raw[ICM20948_PIPE_MAX_SETS * 6];
+    xyzFloat acc[ICM20948_PIPE_MAX_SETS]; // g
+    xyzFloat gyr[ICM20948_PIPE_MAX_SETS]; // degrees/s
+    ICM20948_quaternion orientation; // after the last data set
+};
+
+struct ICM20948_pipeStats {
+    uint64_t batches;
+    uint64_t sets;
+    uint64_t droppedSets;
+    uint32_t maxQueueDepth;
+    uint64_t busyMicros[4]; // acquisition, calibration, fusion, output
+    uint32_t maxLatencyMicros; // from the FIFO read to the end of the output
+    uint64_t sumLatencyMicros;
+};
+
+class ICM20948_Pipeline {
+public:
+    ICM20948_Pipeline(ICM20948* icm, const ICM20948_pipeConfig& config);
+    ~ICM20948_Pipeline();
+    void setOutput(std::function<void(const ICM20948_batch&)> output);
+    void start();
+    void stop();
+    ICM20948_pipeStats getStats();
+
+private:
+    ICM20948* _icm;
+    ICM20948_pipeConfig cfg;
+    ICM20948_Attitude attitude;
+    std::function<void(const ICM20948_batch&)> outputFunc;
+    ICM20948_batch* pool;
+    int16_t scratch[ICM20948_PIPE_MAX_SETS * 6]; // dropped data, acquisition thread only
+    ICM20948_SpscQueue<uint8_t, ICM20948_PIPE_POOL_SIZE> freeQueue;
+    ICM20948_SpscQueue<uint8_t, ICM20948_PIPE_POOL_SIZE> calibQueue;
+    ICM20948_SpscQueue<uint8_t, ICM20948_PIPE_POOL_SIZE> fusionQueue;
+    ICM20948_SpscQueue<uint8_t, ICM20948_PIPE_POOL_SIZE> outputQueue;
+    std::thread threads[4];
+    std::atomic<bool> running;
+    std::atomic<uint64_t> batches, sets, droppedSets, latencyMax, latencySum;
+    std::atomic<uint64_t> busy[4];
+    std::atomic<uint32_t> maxDepth;
+
+    void acquire();
+    void calibrate();
+    void fuse();
+    void output();
+    void idle();
+    void noteDepth(size_t depth);
+};
+
+#endif
@@ -0,0 +1,186 @@
+/********************************************************************
+ * Replay of ICM20948_Recorder recordings on a host computer.
+ *********************************************************************/
+
+#include "ICM20948_Replay.h"
+
+#include <stdio.h>
+
+ICM20948_Replay::ICM20948_Replay()
+{
+    memset(&config, 0, sizeof(config));
+    rewind();
+}
+
+bool ICM20948_Replay::load(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return load(data.data(), data.size());
+}
+
+bool ICM20948_Replay::load(const uint8_t* data, size_t len)
+{
+    recording.assign(data, data + len);
+    records.clear();
+    fifoRecords.clear();
+    for (int b = 0; b < 4; b++) {
+        for (int r = 0; r < 128; r++) {
+            index[b][r].clear();
+        }
+    }
+
+    if ((len < ICM20948_REC_HEADER_LEN) || !ICM20948_Recorder::decodeHeader(data, config)) {
+        return false;
+    }
+
+    size_t pos = ICM20948_REC_HEADER_LEN;
+    while ((pos + ICM20948_REC_RECORD_HEADER_LEN) <= len) {
+        Record rec;
+        rec.bank = data[pos] & 0x03;
+        rec.reg = data[pos + 1] & 0x7F;
+        rec.len = data[pos + 2];
+        rec.timestamp = (uint32_t)data[pos + 3] | ((uint32_t)data[pos + 4] << 8) | ((uint32_t)data[pos + 5] << 16)
+            | ((uint32_t)data[pos + 6] << 24);
+        rec.offset = pos + ICM20948_REC_RECORD_HEADER_LEN;
+        if ((rec.offset + rec.len) > len) {
+            break; // truncated recording
+        }
+        if ((rec.bank == 0) && (rec.reg == ICM20948_FIFO_R_W)) {
+            fifoRecords.push_back(records.size());
+        } else {
+            index[rec.bank][rec.reg].push_back(records.size());
+        }
+        records.push_back(rec);
+        pos = rec.offset + rec.len;
+    }
+
+    rewind();
+    return true;
+}
+
+ICM20948_recConfig ICM20948_Replay::getConfig()
+{
+    return config;
+}
+
+void ICM20948_Replay::applyConfig(ICM20948& icm)
+{
+    uint8_t accRange = 0;
+    uint8_t gyrRange = 0;
+    while ((accRange < 3) && ((1 << accRange) < config.accRangeFactor)) {
+        accRange++;
+    }
+    while ((gyrRange < 3) && ((1 << gyrRange) < config.gyrRangeFactor)) {
+        gyrRange++;
+    }
+    icm.setAccRange((ICM20948_accRange)accRange);
+    icm.setGyrRange((ICM20948_gyroRange)gyrRange);
+
+    /* setAccOffsets() calculates offset and correction factor from min and max */
+    xyzFloat halfSpan = { config.accCorrFactor.x * 16384.0f, config.accCorrFactor.y * 16384.0f,
+        config.accCorrFactor.z * 16384.0f };
+    icm.setAccOffsets(config.accOffsetVal.x - halfSpan.x, config.accOffsetVal.x + halfSpan.x,
+        config.accOffsetVal.y - halfSpan.y, config.accOffsetVal.y + halfSpan.y, config.accOffsetVal.z - halfSpan.z,
+        config.accOffsetVal.z + halfSpan.z);
+    icm.setGyrOffsets(config.gyrOffsetVal.x, config.gyrOffsetVal.y, config.gyrOffsetVal.z);
+    if (config.fifoType != 0) {
+        icm.enableFifo();
+        icm.startFifo((ICM20948_fifoType)config.fifoType);
+    }
+    rewind(); // the register accesses above must not consume recorded data
+}
+
+void ICM20948_Replay::rewind()
+{
+    memset(cursor, 0, sizeof(cursor));
+    fifoRecord = 0;
+    fifoPos = 0;
+    memset(regs, 0, sizeof(regs));
+    regs[0][ICM20948_WHO_AM_I] = ICM20948_WHO_AM_I_CONTENT;
+    regs[0][ICM20948_EXT_SLV_SENS_DATA_00] = AK09916_WHO_AM_I_1 >> 8;
+    regs[0][ICM20948_EXT_SLV_SENS_DATA_01] = AK09916_WHO_AM_I_1 & 0xFF;
+    bank = 0;
+    regPtr = 0;
+    finished = false;
+}
+
+bool ICM20948_Replay::isFinished()
+{
+    return finished;
+}
+
+size_t ICM20948_Replay::getNumberOfRecords()
+{
+    return records.size();
+}
+
+uint8_t ICM20948_Replay::transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen)
+{
+    (void)addr;
+    if (txLen > 0) {
+        regPtr = tx[0] & 0x7F;
+        for (size_t i = 1; i < txLen; i++) {
+            if (regPtr == ICM20948_REG_BANK_SEL) {
+                bank = (tx[i] >> 4) & 0x03;
+            } else {
+                regs[bank][regPtr] = tx[i];
+            }
+            regPtr = (regPtr + 1) & 0x7F;
+        }
+    }
+    if (rxLen > 0) {
+        readRegisters(rx, rxLen);
+    }
+    return 0;
+}
+
+void ICM20948_Replay::readRegisters(uint8_t* rx, size_t rxLen)
+{
+    if ((bank == 0) && (regPtr == ICM20948_FIFO_R_W)) {
+        for (size_t i = 0; i < rxLen; i++) {
+            while ((fifoRecord < fifoRecords.size()) && (fifoPos >= records[fifoRecords[fifoRecord]].len)) {
+                fifoRecord++;
+                fifoPos = 0;
+            }
+            if (fifoRecord >= fifoRecords.size()) {
+                finished = true;
+                rx[i] = 0;
+                continue;
+            }
+            const Record& rec = records[fifoRecords[fifoRecord]];
+            hostSetMicros(rec.timestamp);
+            rx[i] = recording[rec.offset + fifoPos++];
+        }
+        return;
+    }
+
+    std::vector<size_t>& recs = index[bank][regPtr];
+    size_t& cur = cursor[bank][regPtr];
+    if (!recs.empty()) {
+        if (cur >= recs.size()) {
+            finished = true;
+            memset(rx, 0, rxLen);
+            return;
+        }
+        const Record& rec = records[recs[cur++]];
+        hostSetMicros(rec.timestamp);
+        size_t n = (rec.len < rxLen) ? rec.len : rxLen;
+        memcpy(rx, &recording[rec.offset], n);
+        memset(rx + n, 0, rxLen - n);
+        return;
+    }
+
+    for (size_t i = 0; i < rxLen; i++) {
+        rx[i] = regs[bank][(regPtr + i) & 0x7F];
+    }
+}
@@ -0,0 +1,69 @@
+/******************************************************************************
+ *
+ * Replays a recording of ICM20948_Recorder through the ICM20948 class on a host
+ * computer. The replay acts as TwoWire backend: read transactions which are part
+ * of the recording return the recorded data in the recorded order, all other
+ * registers behave like plain memory. With the simulated clock, micros() returns
+ * the recorded timestamps and delay() does not wait.
+ *
+ * Usage:
+ *
+ *   ICM20948_Replay replay;
+ *   replay.load("recording.bin");
+ *   Wire.setBackend(&replay);
+ *   hostSetSimulatedClock(true);
+ *   ICM20948 myIMU(&Wire);
+ *   myIMU.init();
+ *   replay.applyConfig(myIMU);
+ *   while (!replay.isFinished()) {
+ *       myIMU.readSensor();
+ *       ...
+ *   }
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_REPLAY_H_
+#define ICM20948_REPLAY_H_
+
+#include "ICM20948.h"
+#include "ICM20948_Recorder.h"
+#include "Wire.h"
+
+#include <vector>
+
+class ICM20948_Replay : public TwoWireBackend {
+public:
+    ICM20948_Replay();
+    bool load(const char* path);
+    bool load(const uint8_t* data, size_t len);
+    ICM20948_recConfig getConfig();
+    void applyConfig(ICM20948& icm);
+    void rewind();
+    bool isFinished();
+    size_t getNumberOfRecords();
+    uint8_t transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) override;
+
+private:
+    struct Record {
+        uint8_t bank;
+        uint8_t reg;
+        uint32_t timestamp;
+        size_t offset; // of the data in recording
+        uint8_t len;
+    };
+    std::vector<uint8_t> recording;
+    std::vector<Record> records;
+    std::vector<size_t> index[4][128]; // records per bank and register
+    size_t cursor[4][128];
+    std::vector<size_t> fifoRecords;
+    size_t fifoRecord; // current FIFO record
+    size_t fifoPos; // position within the current FIFO record
+    ICM20948_recConfig config;
+    uint8_t regs[4][128];
+    uint8_t bank;
+    uint8_t regPtr;
+    bool finished;
+    void readRegisters(uint8_t* rx, size_t rxLen);
+};
+
+#endif
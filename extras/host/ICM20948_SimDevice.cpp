@@ -0,0 +1,187 @@
+/********************************************************************
+ * Simulated ICM20948 for host builds.
+ *********************************************************************/
+
+#include "ICM20948_SimDevice.h"
+
+#define ICM20948_SIM_FIFO_RST 0x68
+
+ICM20948_SimDevice::ICM20948_SimDevice()
+{
+    freeRunning = false;
+    noise = 8;
+    reset();
+}
+
+void ICM20948_SimDevice::reset()
+{
+    memset(regs, 0, sizeof(regs));
+    regs[0][ICM20948_WHO_AM_I] = ICM20948_WHO_AM_I_CONTENT;
+    regs[0][ICM20948_EXT_SLV_SENS_DATA_00] = AK09916_WHO_AM_I_1 >> 8;
+    regs[0][ICM20948_EXT_SLV_SENS_DATA_01] = AK09916_WHO_AM_I_1 & 0xFF;
+    bank = 0;
+    regPtr = 0;
+    fifoHead = 0;
+    fifoLen = 0;
+    lastUpdate = micros();
+    sampleDebt = 0.0;
+    sampleIndex = 0;
+    generatedSets = 0;
+    overflows = 0;
+}
+
+void ICM20948_SimDevice::setFreeRunning(bool run)
+{
+    freeRunning = run;
+}
+
+void ICM20948_SimDevice::setNoise(int16_t amplitude)
+{
+    noise = amplitude;
+}
+
+uint32_t ICM20948_SimDevice::getGeneratedSets()
+{
+    return generatedSets;
+}
+
+uint32_t ICM20948_SimDevice::getOverflows()
+{
+    return overflows;
+}
+
+uint8_t ICM20948_SimDevice::transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen)
+{
+    (void)addr;
+    update();
+    if (txLen > 0) {
+        regPtr = tx[0] & 0x7F;
+        for (size_t i = 1; i < txLen; i++) {
+            if (regPtr == ICM20948_REG_BANK_SEL) {
+                bank = (tx[i] >> 4) & 0x03;
+            } else if ((bank == 0) && (regPtr == ICM20948_SIM_FIFO_RST) && (tx[i] & 0x1F)) {
+                fifoHead = 0;
+                fifoLen = 0;
+            } else {
+                regs[bank][regPtr] = tx[i];
+            }
+            regPtr = (regPtr + 1) & 0x7F;
+        }
+    }
+    if (rxLen > 0) {
+        readRegisters(rx, rxLen);
+    }
+    return 0;
+}
+
+float ICM20948_SimDevice::getSampleRate()
+{
+    /* the gyroscope divider has priority if the gyroscope data is stored */
+    if (regs[0][ICM20948_FIFO_EN_2] & ICM20948_FIFO_GYR) {
+        return ICM20948_BASE_SAMPLE_RATE / (1 + regs[2][ICM20948_GYRO_SMPLRT_DIV]);
+    }
+    uint16_t accDiv = ((regs[2][ICM20948_ACCEL_SMPLRT_DIV_1] & 0x0F) << 8) | regs[2][ICM20948_ACCEL_SMPLRT_DIV_2];
+    return ICM20948_BASE_SAMPLE_RATE / (1 + accDiv);
+}
+
+void ICM20948_SimDevice::update()
+{
+    uint32_t now = micros();
+    uint32_t elapsed = now - lastUpdate;
+    lastUpdate = now;
+
+    uint8_t fifoEn = regs[0][ICM20948_FIFO_EN_2];
+    if (!(regs[0][ICM20948_USER_CTRL] & ICM20948_FIFO_EN) || !fifoEn) {
+        sampleDebt = 0.0;
+        return;
+    }
+    size_t setLen = ((fifoEn & ICM20948_FIFO_ACC) ? 6 : 0) + ((fifoEn & ICM20948_FIFO_GYR) ? 6 : 0);
+    uint32_t sets;
+    if (freeRunning) {
+        sets = (ICM20948_FIFO_SIZE - fifoLen) / setLen;
+    } else {
+        sampleDebt += elapsed * 1e-6 * getSampleRate();
+        sets = (uint32_t)sampleDebt;
+        sampleDebt -= sets;
+    }
+
+    uint8_t data[12];
+    while (sets--) {
+        generateSet(data, fifoEn);
+        pushFifo(data, setLen);
+    }
+}
+
+void ICM20948_SimDevice::generateSet(uint8_t* data, uint8_t fifoEn)
+{
+    /* acceleration: 1 g on z (2 g range) with a slow tilt, gyroscope: slow rotation */
+    float t = sampleIndex++ * 0.001;
+    int16_t vals[6];
+    vals[0] = (int16_t)(1600.0 * sin(2.0 * PI * 0.5 * t));
+    vals[1] = (int16_t)(1600.0 * cos(2.0 * PI * 0.3 * t));
+    vals[2] = 16384;
+    vals[3] = (int16_t)(500.0 * sin(2.0 * PI * 0.5 * t));
+    vals[4] = (int16_t)(300.0 * cos(2.0 * PI * 0.3 * t));
+    vals[5] = 100;
+    for (int i = 0; i < 6; i++) {
+        if (noise > 0) {
+            vals[i] += (rand() % (2 * noise + 1)) - noise;
+        }
+    }
+
+    for (int i = 0; i < 6; i++) {
+        regs[0][ICM20948_ACCEL_OUT + 2 * i] = vals[i] >> 8;
+        regs[0][ICM20948_ACCEL_OUT + 2 * i + 1] = vals[i] & 0xFF;
+    }
+
+    uint8_t pos = 0;
+    int first = (fifoEn & ICM20948_FIFO_ACC) ? 0 : 3;
+    int last = (fifoEn & ICM20948_FIFO_GYR) ? 6 : 3;
+    for (int i = first; i < last; i++) {
+        data[pos++] = vals[i] >> 8;
+        data[pos++] = vals[i] & 0xFF;
+    }
+    generatedSets++;
+}
+
+void ICM20948_SimDevice::pushFifo(const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (fifoLen == ICM20948_FIFO_SIZE) {
+            if (regs[0][ICM20948_FIFO_MODE] & 0x01) { // stop when full
+                overflows++;
+                return;
+            }
+            fifoHead = (fifoHead + 1) % ICM20948_FIFO_SIZE; // overwrite the oldest byte
+            fifoLen--;
+            if (i == 0) {
+                overflows++;
+            }
+        }
+        fifo[(fifoHead + fifoLen) % ICM20948_FIFO_SIZE] = data[i];
+        fifoLen++;
+    }
+}
+
+void ICM20948_SimDevice::readRegisters(uint8_t* rx, size_t rxLen)
+{
+    if (bank == 0) {
+        if (regPtr == ICM20948_FIFO_R_W) {
+            for (size_t i = 0; i < rxLen; i++) {
+                if (fifoLen == 0) {
+                    rx[i] = 0xFF;
+                    continue;
+                }
+                rx[i] = fifo[fifoHead];
+                fifoHead = (fifoHead + 1) % ICM20948_FIFO_SIZE;
+                fifoLen--;
+            }
+            return;
+        }
+        regs[0][ICM20948_FIFO_COUNT] = fifoLen >> 8;
+        regs[0][ICM20948_FIFO_COUNT + 1] = fifoLen & 0xFF;
+    }
+    for (size_t i = 0; i < rxLen; i++) {
+        rx[i] = regs[bank][(regPtr + i) & 0x7F];
+    }
+}
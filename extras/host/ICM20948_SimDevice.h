@@ -0,0 +1,61 @@
+/******************************************************************************
+ *
+ * Simulated ICM20948 as TwoWire backend, e.g. to test and benchmark host
+ * applications without hardware. Registers behave like memory, except:
+ *
+ * - the data registers return a synthetic signal (slow sine waves and noise)
+ * - the FIFO is filled with acceleration and/or gyroscope data sets according to
+ *   FIFO_EN_2, USER_CTRL, the sample rate dividers and the elapsed time (micros())
+ * - FIFO_COUNT and FIFO_R_W work like in the real device, FIFO_RST clears the FIFO
+ *
+ * In free running mode the FIFO is refilled whenever it is read, independent of
+ * the time. This measures the maximum throughput of the processing.
+ *
+ * Usage:
+ *
+ *   ICM20948_SimDevice sim;
+ *   Wire.setBackend(&sim);
+ *   ICM20948 myIMU(&Wire);
+ *   myIMU.init();
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_SIM_DEVICE_H_
+#define ICM20948_SIM_DEVICE_H_
+
+#include "ICM20948.h"
+#include "Wire.h"
+
+class ICM20948_SimDevice : public TwoWireBackend {
+public:
+    ICM20948_SimDevice();
+    void reset();
+    void setFreeRunning(bool freeRunning);
+    void setNoise(int16_t amplitude);
+    uint32_t getGeneratedSets();
+    uint32_t getOverflows();
+    uint8_t transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) override;
+
+private:
+    uint8_t regs[4][128];
+    uint8_t bank;
+    uint8_t regPtr;
+    uint8_t fifo[ICM20948_FIFO_SIZE];
+    size_t fifoHead;
+    size_t fifoLen;
+    bool freeRunning;
+    int16_t noise;
+    uint32_t lastUpdate;
+    float sampleDebt; // fraction of a data set not yet generated
+    uint32_t sampleIndex;
+    uint32_t generatedSets;
+    uint32_t overflows;
+
+    void update();
+    void generateSet(uint8_t* data, uint8_t fifoEn);
+    void pushFifo(const uint8_t* data, size_t len);
+    float getSampleRate();
+    void readRegisters(uint8_t* rx, size_t rxLen);
+};
+
+#endif
@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ * TwoWire replacement for building the ICM20948 library on a host computer.
+ * The bus transactions are passed to a TwoWireBackend, e.g. the replay of a
+ * recording (ICM20948_Replay) or a real I2C bus.
+ *
+ * A write followed by endTransmission(false) and requestFrom() is passed as
+ * one combined transfer (write, repeated start, read).
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_HOST_WIRE_H_
+#define ICM20948_HOST_WIRE_H_
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 256
+
+class TwoWireBackend {
+public:
+    virtual ~TwoWireBackend() { }
+    /* writes txLen bytes, then reads rxLen bytes after a repeated start,
+     * returns 0 on success or an Arduino Wire error code */
+    virtual uint8_t transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) = 0;
+};
+
+class TwoWire {
+public:
+    TwoWire();
+    void setBackend(TwoWireBackend* backend);
+    void begin();
+    void setClock(uint32_t freq);
+    void beginTransmission(int addr);
+    size_t write(uint8_t val);
+    size_t write(const uint8_t* buf, size_t len);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(int addr, int len);
+    int available();
+    int read();
+
+private:
+    TwoWireBackend* _backend;
+    uint8_t txAddr;
+    uint8_t txBuf[BUFFER_LENGTH];
+    size_t txLen;
+    bool txPending; // written with endTransmission(false), sent with the next read
+    uint8_t rxBuf[BUFFER_LENGTH];
+    size_t rxLen;
+    size_t rxPos;
+};
+
+extern TwoWire Wire;
+
+#endif
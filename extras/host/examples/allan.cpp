@@ -0,0 +1,404 @@
+/********************************************************************
+ * Computes the overlapping Allan deviation, the noise density and the
+ * bias instability per axis from a long capture of an ICM20948 at rest.
+ * With --streaming, the results of the on-device accumulator
+ * (ICM20948_AllanVariance, non-overlapping) are printed for comparison.
+ *
+ * The capture is not kept in memory, so hours of data at 1125 Hz can be
+ * processed. Like in the on-device accumulator, level k averages 2^k
+ * samples. Each level keeps a ring of the last 2 * 16 prefix sums and
+ * accumulates the overlapping differences for clusters of 8 ... 15 level
+ * values (level 0: 1 ... 15). So cluster sizes are spaced 8 per octave,
+ * consecutive clusters are shifted by 2^k samples (at least 8 offsets per
+ * cluster instead of all) and the memory grows with log2 of the duration.
+ *
+ * Input:
+ *   --recording file   recording of ICM20948_Recorder, read with
+ *                      readSensor(); the sample rate is taken from the
+ *                      timestamps
+ *   --fifo             the recording contains FIFO reads (needs --rate)
+ *   --text file        text lines "micros ax ay az gx gy gz" (output of
+ *                      the replay example) or "ax ay az gx gy gz" (needs
+ *                      --rate); "-" reads stdin
+ *   --rate Hz          sample rate
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/allan.cpp \
+ *       extras/host/HostArduino.cpp extras/host/ICM20948_Replay.cpp \
+ *       src/ICM20948.cpp src/ICM20948_BusArbiter.cpp src/ICM20948_Recorder.cpp \
+ *       src/ICM20948_AllanVariance.cpp -o allan
+ *
+ * Run:
+ *   ./allan --recording still.bin
+ *   ./replay still.bin | ./allan --text -
+ *********************************************************************/
+
+#include "ICM20948.h"
+#include "ICM20948_AllanVariance.h"
+#include "ICM20948_Replay.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define CHANNELS 6
+#define MAX_LEVELS 48
+#define LEVEL_MIN_CLUSTER 8 // cluster sizes of the levels k > 0, in level values
+#define LEVEL_MAX_CLUSTER 16 // exclusive
+#define RING_LEN 32 // >= 2 * LEVEL_MAX_CLUSTER - 1 prefix sums
+
+static const char* channelNames[CHANNELS] = { "acc x", "acc y", "acc z", "gyr x", "gyr y", "gyr z" };
+
+/* overlapping Allan variance of one channel, octave levels */
+class OverlapAdev {
+public:
+    OverlapAdev()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void add(double val)
+    {
+        if (samples == 0) {
+            ref = val; // shifted for precision
+        }
+        samples++;
+        addToLevel(0, val - ref);
+    }
+
+    uint64_t getSamples() const
+    {
+        return samples;
+    }
+
+    /* clusters of m samples: true if the level exists, sets the variance */
+    bool getAvar(uint8_t k, uint8_t m, double* avar) const
+    {
+        if ((k >= MAX_LEVELS) || (diffs[k][m] == 0)) {
+            return false;
+        }
+        *avar = sq[k][m] / (2.0 * diffs[k][m]);
+        return true;
+    }
+
+private:
+    uint64_t samples;
+    double ref;
+    double prefix[MAX_LEVELS][RING_LEN];
+    uint64_t count[MAX_LEVELS]; // values of the level
+    double pending[MAX_LEVELS];
+    double sq[MAX_LEVELS][LEVEL_MAX_CLUSTER];
+    uint64_t diffs[MAX_LEVELS][LEVEL_MAX_CLUSTER];
+
+    void addToLevel(uint8_t k, double val)
+    {
+        uint64_t c = ++count[k];
+        prefix[k][c % RING_LEN] = prefix[k][(c - 1) % RING_LEN] + val;
+        const double* p = prefix[k];
+        for (uint8_t m = (k == 0) ? 1 : LEVEL_MIN_CLUSTER; (m < LEVEL_MAX_CLUSTER) && (2 * (uint64_t)m <= c); m++) {
+            double d = (p[c % RING_LEN] - 2.0 * p[(c - m) % RING_LEN] + p[(c - 2 * m) % RING_LEN]) / m;
+            sq[k][m] += d * d;
+            diffs[k][m]++;
+        }
+        if (k + 1 >= MAX_LEVELS) {
+            return;
+        }
+        if (c & 1) {
+            pending[k] = val;
+        } else {
+            addToLevel(k + 1, (pending[k] + val) / 2.0);
+        }
+    }
+};
+
+struct Analysis {
+    OverlapAdev overlap[CHANNELS];
+    ICM20948_AllanVariance* streaming[2]; // acc, gyr; nullptr without --streaming
+    bool hasChannel[CHANNELS];
+    double rate;
+};
+
+struct AdevPoint {
+    double tau;
+    double adev[CHANNELS];
+};
+
+static void addSet(Analysis& an, const xyzFloat& g, const xyzFloat& gyr)
+{
+    an.overlap[0].add(g.x);
+    an.overlap[1].add(g.y);
+    an.overlap[2].add(g.z);
+    an.overlap[3].add(gyr.x);
+    an.overlap[4].add(gyr.y);
+    an.overlap[5].add(gyr.z);
+    if (an.streaming[0]) {
+        an.streaming[0]->addSample(g);
+        an.streaming[1]->addSample(gyr);
+    }
+}
+
+static bool readRecording(const char* path, bool fifo, Analysis& an)
+{
+    ICM20948_Replay replay;
+    if (!replay.load(path)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    Wire.setBackend(&replay);
+    hostSetSimulatedClock(true);
+    ICM20948 imu(&Wire);
+    imu.init();
+    replay.applyConfig(imu);
+    ICM20948_fifoType fifoType = (ICM20948_fifoType)replay.getConfig().fifoType;
+    xyzFloat zero = { 0.0, 0.0, 0.0 };
+
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint16_t emptyPolls = 0;
+    while (!replay.isFinished()) {
+        if (fifo) {
+            int16_t sets = imu.getNumberOfFifoDataSets();
+            emptyPolls = (sets > 0) ? 0 : emptyPolls + 1;
+            if (emptyPolls > 1000) {
+                break; // no FIFO data left in the recording
+            }
+            for (int16_t i = 0; (i < sets) && !replay.isFinished(); i++) {
+                xyzFloat g = (fifoType == ICM20948_FIFO_GYR) ? zero : imu.getGValuesFromFifo();
+                xyzFloat gyr = (fifoType == ICM20948_FIFO_ACC) ? zero : imu.getGyrValuesFromFifo();
+                addSet(an, g, gyr);
+            }
+            continue;
+        }
+        imu.readSensor();
+        if (replay.isFinished()) {
+            break;
+        }
+        if (an.overlap[0].getSamples() == 0) {
+            first = micros();
+        }
+        last = micros();
+        addSet(an, imu.getGValues(), imu.getGyrValues());
+    }
+
+    for (int c = 0; c < CHANNELS; c++) {
+        an.hasChannel[c] = !fifo || ((c < 3) ? (fifoType != ICM20948_FIFO_GYR) : (fifoType != ICM20948_FIFO_ACC));
+    }
+    uint64_t n = an.overlap[0].getSamples();
+    if (!fifo && (an.rate <= 0.0) && (n > 1) && (last != first)) {
+        an.rate = (n - 1) * 1e6 / (uint32_t)(last - first);
+    }
+    return true;
+}
+
+static bool readText(const char* path, Analysis& an)
+{
+    FILE* f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!f) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    char line[256];
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    bool timestamps = false;
+    while (fgets(line, sizeof(line), f)) {
+        double v[7];
+        int n = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]);
+        const double* set = v;
+        if (n == 7) {
+            if (an.overlap[0].getSamples() == 0) {
+                firstTime = v[0];
+            }
+            lastTime = v[0];
+            timestamps = true;
+            set = &v[1];
+        } else if (n != 6) {
+            continue;
+        }
+        xyzFloat g = { (float)set[0], (float)set[1], (float)set[2] };
+        xyzFloat gyr = { (float)set[3], (float)set[4], (float)set[5] };
+        for (int c = 0; c < CHANNELS; c++) {
+            an.overlap[c].add(set[c]); // full precision
+        }
+        if (an.streaming[0]) {
+            an.streaming[0]->addSample(g);
+            an.streaming[1]->addSample(gyr);
+        }
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+    for (int c = 0; c < CHANNELS; c++) {
+        an.hasChannel[c] = true;
+    }
+    uint64_t n = an.overlap[0].getSamples();
+    if (timestamps && (an.rate <= 0.0) && (n > 1) && (lastTime > firstTime)) {
+        an.rate = (n - 1) * 1e6 / (lastTime - firstTime);
+    }
+    return true;
+}
+
+static std::vector<AdevPoint> getAdevPoints(const Analysis& an)
+{
+    /* Cluster sizes spaced about 10 per decade, with at least ICM20948_ALLAN_MIN_CLUSTERS
+     * independent differences like in the streaming accumulator. */
+    std::vector<AdevPoint> points;
+    uint64_t n = an.overlap[0].getSamples();
+    double next = 1.0;
+    for (uint8_t k = 0; k < MAX_LEVELS; k++) {
+        for (uint8_t m = (k == 0) ? 1 : LEVEL_MIN_CLUSTER; m < LEVEL_MAX_CLUSTER; m++) {
+            uint64_t size = (uint64_t)m << k;
+            if (size * (ICM20948_ALLAN_MIN_CLUSTERS + 1) > n) {
+                return points;
+            }
+            if (size + 0.5 < next) {
+                continue;
+            }
+            while (next <= size + 0.5) {
+                next *= pow(10.0, 0.1);
+            }
+            AdevPoint point;
+            point.tau = size / an.rate;
+            for (int c = 0; c < CHANNELS; c++) {
+                double avar = 0.0;
+                an.overlap[c].getAvar(k, m, &avar);
+                point.adev[c] = sqrt(avar);
+            }
+            points.push_back(point);
+        }
+    }
+    return points;
+}
+
+static double noiseDensity(const std::vector<AdevPoint>& points, int c)
+{
+    /* white noise: ADEV(tau) = N / sqrt(tau), where the slope is -1/2 +/- 1/4 */
+    double sum = 0.0;
+    int n = 0;
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        if ((points[i].adev[c] <= 0.0) || (points[i + 1].adev[c] <= 0.0)) {
+            continue;
+        }
+        double slope = log(points[i + 1].adev[c] / points[i].adev[c]) / log(points[i + 1].tau / points[i].tau);
+        if ((slope > -0.75) && (slope < -0.25)) {
+            sum += points[i].adev[c] * sqrt(points[i].tau);
+            n++;
+        }
+    }
+    if ((n == 0) && !points.empty()) {
+        return points[0].adev[c] * sqrt(points[0].tau);
+    }
+    return (n > 0) ? sum / n : 0.0;
+}
+
+static double biasInstability(const std::vector<AdevPoint>& points, int c)
+{
+    double minAdev = 0.0;
+    for (size_t i = 0; i < points.size(); i++) {
+        if ((i == 0) || (points[i].adev[c] < minAdev)) {
+            minAdev = points[i].adev[c];
+        }
+    }
+    return minAdev / ICM20948_ALLAN_BIAS_FACTOR;
+}
+
+static void printResults(const char* title, int c, double density, double bias)
+{
+    /* acc in g, gyr in degrees/s */
+    if (c < 3) {
+        printf("%-10s %-6s noise density %9.2f µg/sqrt(Hz)   bias instability %9.2f µg\n", title, channelNames[c],
+            density * 1e6, bias * 1e6);
+    } else {
+        printf("%-10s %-6s noise density %9.5f dps/sqrt(Hz) bias instability %9.3f deg/h\n", title, channelNames[c],
+            density, bias * 3600.0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* recording = nullptr;
+    const char* text = nullptr;
+    bool fifo = false;
+    bool streaming = false;
+    static Analysis an; // about 20 KB per channel
+    an.rate = 0.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--recording") && (i + 1 < argc)) {
+            recording = argv[++i];
+        } else if (!strcmp(argv[i], "--text") && (i + 1 < argc)) {
+            text = argv[++i];
+        } else if (!strcmp(argv[i], "--rate") && (i + 1 < argc)) {
+            an.rate = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--fifo")) {
+            fifo = true;
+        } else if (!strcmp(argv[i], "--streaming")) {
+            streaming = true;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!recording == !text) {
+        fprintf(stderr, "usage: %s --recording file [--fifo] | --text file [--rate Hz] [--streaming]\n", argv[0]);
+        return 1;
+    }
+
+    /* The rate of recordings is only known at the end. The accumulator works in samples
+     * (rate 1 Hz), the noise density is scaled afterwards. */
+    ICM20948_AllanVariance accAdev(1.0);
+    ICM20948_AllanVariance gyrAdev(1.0);
+    an.streaming[0] = streaming ? &accAdev : nullptr;
+    an.streaming[1] = streaming ? &gyrAdev : nullptr;
+    if (recording ? !readRecording(recording, fifo, an) : !readText(text, an)) {
+        return 1;
+    }
+    uint64_t n = an.overlap[0].getSamples();
+    if ((n < 16) || (an.rate <= 0.0)) {
+        fprintf(stderr, "%llu samples, sample rate %.1f Hz: not enough data or no rate (--rate)\n",
+            (unsigned long long)n, an.rate);
+        return 1;
+    }
+    fprintf(stderr, "%llu samples at %.2f Hz (%.1f s)\n", (unsigned long long)n, an.rate, n / an.rate);
+
+    std::vector<AdevPoint> points = getAdevPoints(an);
+    printf("# tau[s]");
+    for (int c = 0; c < CHANNELS; c++) {
+        if (an.hasChannel[c]) {
+            printf("\t%s", channelNames[c]);
+        }
+    }
+    printf("\n");
+    for (size_t i = 0; i < points.size(); i++) {
+        printf("%.6g", points[i].tau);
+        for (int c = 0; c < CHANNELS; c++) {
+            if (an.hasChannel[c]) {
+                printf("\t%.6g", points[i].adev[c]);
+            }
+        }
+        printf("\n");
+    }
+    printf("\n");
+    for (int c = 0; c < CHANNELS; c++) {
+        if (!an.hasChannel[c]) {
+            continue;
+        }
+        printResults("overlap", c, noiseDensity(points, c), biasInstability(points, c));
+    }
+
+    if (streaming) {
+        xyzFloat density[2] = { accAdev.getNoiseDensity(), gyrAdev.getNoiseDensity() };
+        xyzFloat bias[2] = { accAdev.getBiasInstability(), gyrAdev.getBiasInstability() };
+        for (int c = 0; c < CHANNELS; c++) {
+            if (!an.hasChannel[c]) {
+                continue;
+            }
+            const xyzFloat& d = density[c / 3];
+            const xyzFloat& b = bias[c / 3];
+            int axis = c % 3;
+            printResults("streaming", c, ((axis == 0) ? d.x : ((axis == 1) ? d.y : d.z)) / sqrt(an.rate),
+                (axis == 0) ? b.x : ((axis == 1) ? b.y : b.z));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/********************************************************************
+ * Serves several simulated ICM20948 on one thread with the C++20
+ * coroutine interface (ICM20948_Coro.h). Each device runs its own
+ * coroutine: init, magnetometer init, FIFO start, then a loop which
+ * drains the FIFO every poll period. While one device waits (reset
+ * times, next poll), the others run. The clock is simulated, so the
+ * demo runs faster than real time.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++20 -O2 -Iextras/host -Isrc extras/host/examples/coro_demo.cpp \
+ *       extras/host/HostArduino.cpp extras/host/ICM20948_SimDevice.cpp \
+ *       src/ICM20948.cpp src/ICM20948_BusArbiter.cpp src/ICM20948_Recorder.cpp -o coro_demo
+ *
+ * Run:
+ *   ./coro_demo                    4 devices, 2 seconds
+ *   options: --devices n, --seconds n, --poll-ms n
+ *********************************************************************/
+
+#include "ICM20948.h"
+#include "ICM20948_Coro.h"
+#include "ICM20948_SimDevice.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifndef ICM20948_HAS_COROUTINES
+#error "C++20 coroutines required, compile with -std=c++20"
+#endif
+
+/* resumes the suspended coroutines in order of their wake up time */
+class DemoExecutor : public ICM20948_Executor {
+public:
+    void schedule(std::coroutine_handle<> handle, uint32_t wakeAt) override
+    {
+        waiting.push_back(Entry { handle, wakeAt });
+    }
+
+    void run()
+    {
+        while (!waiting.empty()) {
+            size_t next = 0;
+            for (size_t i = 1; i < waiting.size(); i++) {
+                if ((int32_t)(waiting[i].wakeAt - waiting[next].wakeAt) < 0) {
+                    next = i;
+                }
+            }
+            Entry e = waiting[next];
+            waiting.erase(waiting.begin() + next);
+            int32_t wait = (int32_t)(e.wakeAt - micros());
+            if (wait > 0) {
+                delayMicroseconds(wait); // idle: nothing is due
+                idleMicros += wait;
+            }
+            resumes++;
+            e.handle.resume();
+        }
+    }
+
+    uint32_t resumes = 0;
+    uint32_t idleMicros = 0;
+
+private:
+    struct Entry {
+        std::coroutine_handle<> handle;
+        uint32_t wakeAt;
+    };
+    std::vector<Entry> waiting;
+};
+
+struct Device {
+    ICM20948_SimDevice sim;
+    TwoWire wire;
+    ICM20948* imu;
+    bool ok;
+    uint32_t initMicros;
+    uint32_t sets;
+    uint32_t drains;
+};
+
+static ICM20948_Task<void> runDevice(Device& dev, DemoExecutor& ex, uint32_t endTime, uint32_t pollMicros)
+{
+    uint32_t start = micros();
+    dev.ok = co_await icm20948Init(*dev.imu, ex);
+    dev.ok = dev.ok && co_await icm20948InitMagnetometer(*dev.imu, ex);
+    dev.initMicros = micros() - start;
+    if (!dev.ok) {
+        co_return;
+    }
+
+    dev.imu->setSampleRates(500.0, 500.0);
+    dev.imu->setFifoMode(ICM20948_CONTINUOUS);
+    dev.imu->enableFifo();
+    dev.imu->resetFifo();
+    dev.imu->startFifo(ICM20948_FIFO_ACC_GYR);
+
+    int16_t data[64 * 6];
+    uint32_t nextPoll = micros();
+    while ((int32_t)(micros() - endTime) < 0) {
+        nextPoll += pollMicros;
+        co_await icm20948SleepUntil(ex, nextPoll);
+        dev.sets += co_await icm20948DrainFifo(*dev.imu, ex, data, 6, 64, 16);
+        dev.drains++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int devices = 4;
+    int seconds = 2;
+    int pollMs = 20;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--devices") && (i + 1 < argc)) {
+            devices = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seconds") && (i + 1 < argc)) {
+            seconds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--poll-ms") && (i + 1 < argc)) {
+            pollMs = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    hostSetSimulatedClock(true);
+    std::vector<Device> devs(devices);
+    std::vector<ICM20948_Task<void>> tasks;
+    DemoExecutor ex;
+    uint32_t start = micros();
+    uint32_t endTime = start + seconds * 1000000UL;
+
+    for (Device& dev : devs) {
+        dev.wire.setBackend(&dev.sim);
+        dev.imu = new ICM20948(&dev.wire);
+        dev.ok = false;
+        dev.initMicros = 0;
+        dev.sets = 0;
+        dev.drains = 0;
+        tasks.push_back(runDevice(dev, ex, endTime, pollMs * 1000));
+    }
+    for (ICM20948_Task<void>& task : tasks) {
+        task.start();
+    }
+    ex.run();
+
+    uint32_t total = micros() - start;
+    for (int i = 0; i < devices; i++) {
+        printf("device %d: %s, init %.1f ms, %u data sets in %u drains\n", i, devs[i].ok ? "ok" : "failed",
+            devs[i].initMicros / 1000.0, devs[i].sets, devs[i].drains);
+        delete devs[i].imu;
+    }
+    printf("simulated time %.1f ms, idle %.1f ms, %u resumes\n", total / 1000.0, ex.idleMicros / 1000.0, ex.resumes);
+    return 0;
+}
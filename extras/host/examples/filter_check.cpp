@@ -0,0 +1,112 @@
+/********************************************************************
+ * Full scale check of ICM20948_Biquad: notch sections near Nyquist and
+ * a section with a gain of 5 are fed with full scale signals (Nyquist
+ * frequency, steps between the limits, a sine). The output is compared
+ * with a 64 bit model of the Q14 section with the same coefficients,
+ * saturation and error feedback. Returns 1 if an output differs.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/filter_check.cpp \
+ *       extras/host/HostArduino.cpp src/ICM20948_Filter.cpp -o filter_check
+ *********************************************************************/
+
+#include "ICM20948_Filter.h"
+
+#include <math.h>
+#include <stdio.h>
+
+static const float sampleRate = 1125.0;
+static const uint16_t len = 2048;
+
+static ICM20948_Biquad biquad;
+static int16_t nyquist[len], steps[len], sine[len];
+static char label[32];
+
+/* as in ICM20948_Filter.cpp */
+static int64_t q14(float val)
+{
+    return (int32_t)(val * 16384.0 + ((val < 0) ? -0.5 : 0.5));
+}
+
+static bool check(const char* name, const int64_t* b, const int64_t* a, const int16_t* input)
+{
+    static int16_t data[len];
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = input[i];
+    }
+    biquad.process(data, len);
+
+    int64_t x1 = 0, x2 = 0, y1 = 0, y2 = 0, err = 0;
+    uint16_t diffs = 0;
+    for (uint16_t i = 0; i < len; i++) {
+        int64_t acc = err + b[0] * input[i] + b[1] * x1 + b[2] * x2 - a[0] * y1 - a[1] * y2;
+        int64_t y = acc >> 14;
+        y = (y > 32767) ? 32767 : ((y < -32768) ? -32768 : y);
+        err = acc & 0x3FFF;
+        x2 = x1;
+        x1 = input[i];
+        y2 = y1;
+        y1 = y;
+        if (y != data[i]) {
+            diffs++;
+        }
+    }
+    printf("%-28s %-8s %4u of %u outputs differ: %s\n", label, name, diffs, len, diffs ? "FAILED" : "ok");
+    return diffs == 0;
+}
+
+static bool checkSignals(const int64_t* b, const int64_t* a)
+{
+    bool ok = true;
+    biquad.reset();
+    ok &= check("nyquist", b, a, nyquist);
+    biquad.reset();
+    ok &= check("steps", b, a, steps);
+    biquad.reset();
+    ok &= check("sine", b, a, sine);
+    return ok;
+}
+
+static bool checkNotch(float freq, float q)
+{
+    /* RBJ audio EQ cookbook and DC gain match as in setNotch() */
+    float w0 = 2.0 * PI * freq / sampleRate;
+    float alpha = sin(w0) / (2.0 * q);
+    float a0 = 1.0 + alpha;
+    int64_t a[2] = { q14(-2.0 * cos(w0) / a0), q14((1.0 - alpha) / a0) };
+    int64_t b[3] = { q14(1.0 / a0), 0, q14(1.0 / a0) };
+    b[1] = 16384 + a[0] + a[1] - b[0] - b[2];
+    biquad.setNotch(0, freq, sampleRate, q);
+    snprintf(label, sizeof(label), "notch %5.1f Hz, Q %4.1f", freq, q);
+    return checkSignals(b, a);
+}
+
+static bool checkGain()
+{
+    /* the sum of the products exceeds 2^31 for full scale input */
+    int64_t b[3] = { q14(2.5), 0, q14(2.5) };
+    int64_t a[2] = { 0, 0 };
+    biquad.setCoefficients(0, 2.5, 0.0, 2.5, 0.0, 0.0);
+    snprintf(label, sizeof(label), "gain 5");
+    return checkSignals(b, a);
+}
+
+int main()
+{
+    for (uint16_t i = 0; i < len; i++) {
+        nyquist[i] = (i & 1) ? -32768 : 32767;
+        steps[i] = ((i / 64) & 1) ? -32768 : 32767;
+        sine[i] = (int16_t)(32767.0 * sin(2.0 * M_PI * 300.0 * i / sampleRate));
+    }
+
+    bool ok = true;
+    const float freqs[] = { 400.0, 500.0, 540.0 };
+    const float qs[] = { 2.0, 10.0 };
+    for (uint8_t f = 0; f < 3; f++) {
+        for (uint8_t q = 0; q < 2; q++) {
+            ok &= checkNotch(freqs[f], qs[q]);
+        }
+    }
+    ok &= checkGain();
+    return ok ? 0 : 1;
+}
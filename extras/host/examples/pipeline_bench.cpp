@@ -0,0 +1,111 @@
+/********************************************************************
+ * Runs the ICM20948_Pipeline for some seconds and prints throughput,
+ * queue depth, CPU time per stage and latency. Without a device
+ * argument a simulated ICM20948 is used.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -pthread -Iextras/host -Isrc extras/host/examples/pipeline_bench.cpp \
+ *       extras/host/HostArduino.cpp extras/host/ICM20948_SimDevice.cpp \
+ *       extras/host/ICM20948_LinuxI2C.cpp extras/host/ICM20948_Pipeline.cpp \
+ *       src/ICM20948.cpp src/ICM20948_BusArbiter.cpp src/ICM20948_Recorder.cpp \
+ *       src/ICM20948_Attitude.cpp -o pipeline_bench
+ *
+ * Run:
+ *   ./pipeline_bench                       simulated device, real time (1125 Hz)
+ *   ./pipeline_bench --free-running        simulated device, as fast as possible
+ *   ./pipeline_bench --device /dev/i2c-1   real ICM20948 at address 0x68
+ *   options: --seconds n, --poll-ms n, --address 0x69
+ *********************************************************************/
+
+#include "ICM20948.h"
+#include "ICM20948_LinuxI2C.h"
+#include "ICM20948_Pipeline.h"
+#include "ICM20948_SimDevice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char** argv)
+{
+    const char* device = nullptr;
+    int address = 0x68;
+    int seconds = 5;
+    int pollMs = 10;
+    bool freeRunning = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--device") && (i + 1 < argc)) {
+            device = argv[++i];
+        } else if (!strcmp(argv[i], "--address") && (i + 1 < argc)) {
+            address = strtol(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--seconds") && (i + 1 < argc)) {
+            seconds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--poll-ms") && (i + 1 < argc)) {
+            pollMs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--free-running")) {
+            freeRunning = true;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    ICM20948_SimDevice sim;
+    ICM20948_LinuxI2C bus;
+    if (device) {
+        if (!bus.open(device)) {
+            fprintf(stderr, "cannot open %s: %s\n", device, strerror(bus.getLastErrno()));
+            return 1;
+        }
+        Wire.setBackend(&bus);
+    } else {
+        sim.setFreeRunning(freeRunning);
+        Wire.setBackend(&sim);
+    }
+
+    ICM20948 myIMU(&Wire, address);
+    if (!myIMU.init()) {
+        fprintf(stderr, "ICM20948 does not respond\n");
+        return 1;
+    }
+    myIMU.setAccRange(ICM20948_ACC_RANGE_2G);
+    myIMU.setAccDLPF(ICM20948_DLPF_6);
+    myIMU.setAccSampleRateDivider(0);
+    myIMU.setGyrRange(ICM20948_GYRO_RANGE_250);
+    myIMU.setGyrDLPF(ICM20948_DLPF_6);
+    myIMU.setGyrSampleRateDivider(0);
+
+    ICM20948_pipeConfig config;
+    config.sampleRate = ICM20948_BASE_SAMPLE_RATE;
+    config.accRangeFactor = 1;
+    config.gyrRangeFactor = 1;
+    config.accOffset = { 0.0, 0.0, 0.0 };
+    config.gyrOffset = { 0.0, 0.0, 0.0 };
+    config.pollIntervalMicros = freeRunning ? 0 : pollMs * 1000;
+
+    ICM20948_Pipeline pipeline(&myIMU, config);
+    uint64_t checksum = 0;
+    pipeline.setOutput([&checksum](const ICM20948_batch& b) { checksum += b.sets + (uint64_t)(b.orientation.w * 1000); });
+
+    uint32_t start = micros();
+    pipeline.start();
+    delay(seconds * 1000);
+    pipeline.stop();
+    double elapsed = (micros() - start) * 1e-6;
+
+    ICM20948_pipeStats st = pipeline.getStats();
+    const char* stages[4] = { "acquisition", "calibration", "fusion", "output" };
+    printf("data sets:        %llu (%.0f/s), dropped: %llu\n", (unsigned long long)st.sets, st.sets / elapsed,
+        (unsigned long long)st.droppedSets);
+    printf("batches:          %llu, max. queue depth: %u\n", (unsigned long long)st.batches, st.maxQueueDepth);
+    for (int i = 0; i < 4; i++) {
+        printf("%-17s %8.1f ms busy, %6.3f us/data set\n", stages[i], st.busyMicros[i] / 1000.0,
+            st.sets ? (double)st.busyMicros[i] / st.sets : 0.0);
+    }
+    printf("latency:          avg %.0f us, max %u us\n", st.batches ? (double)st.sumLatencyMicros / st.batches : 0.0,
+        (unsigned)st.maxLatencyMicros);
+    if (!device) {
+        printf("simulated device: %u data sets generated, %u overflows\n", sim.getGeneratedSets(), sim.getOverflows());
+    }
+    printf("checksum:         %llu\n", (unsigned long long)checksum);
+    return 0;
+}
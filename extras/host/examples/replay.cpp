@@ -0,0 +1,55 @@
+/********************************************************************
+ * Replays a recording made with ICM20948_Recorder and prints the
+ * acceleration and gyroscope values, followed by the processing rate.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/replay.cpp \
+ *       extras/host/HostArduino.cpp extras/host/ICM20948_Replay.cpp \
+ *       src/ICM20948.cpp src/ICM20948_BusArbiter.cpp src/ICM20948_Recorder.cpp -o replay
+ *
+ * Run:
+ *   ./replay recording.bin
+ *********************************************************************/
+
+#include "ICM20948.h"
+#include "ICM20948_Replay.h"
+
+#include <chrono>
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s recording.bin\n", argv[0]);
+        return 1;
+    }
+
+    ICM20948_Replay replay;
+    if (!replay.load(argv[1])) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    Wire.setBackend(&replay);
+    hostSetSimulatedClock(true);
+    ICM20948 myIMU(&Wire);
+    myIMU.init();
+    replay.applyConfig(myIMU);
+
+    unsigned long samples = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (true) {
+        myIMU.readSensor();
+        if (replay.isFinished()) {
+            break;
+        }
+        xyzFloat gVal = myIMU.getGValues();
+        xyzFloat gyr = myIMU.getGyrValues();
+        printf("%lu\t%.4f\t%.4f\t%.4f\t%.3f\t%.3f\t%.3f\n", (unsigned long)micros(), gVal.x, gVal.y, gVal.z, gyr.x,
+            gyr.y, gyr.z);
+        samples++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%lu samples in %.3f s (%.0f samples/s)\n", samples, seconds, samples / seconds);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/********************************************************************
+ * Throughput of ICM20948_Spectrum for different window sizes. A
+ * synthetic signal (two sine waves plus noise) is processed and the
+ * time per window, the sample throughput and the detected peaks are
+ * printed.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/spectrum_bench.cpp \
+ *       extras/host/HostArduino.cpp -o spectrum_bench
+ *********************************************************************/
+
+#include "ICM20948_Spectrum.h"
+
+#include <chrono>
+#include <stdio.h>
+
+static const float sampleRate = 1125.0;
+static const uint32_t totalSamples = 1UL << 20;
+static int16_t signal[totalSamples];
+
+template <uint16_t N>
+static void bench()
+{
+    static ICM20948_Spectrum<N> spectrum(sampleRate);
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t windows = 0;
+    for (uint32_t i = 0; i < totalSamples; i += 4096) {
+        windows += spectrum.addSamples(&signal[i], 4096);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    float freq[2], amplitude[2];
+    uint8_t peaks = spectrum.getPeaks(freq, amplitude, 2);
+    printf("%5u  %10.2f  %12.1f  %8.1f Hz  %8.1f Hz\n", N, seconds * 1e6 / windows, totalSamples / seconds / 1e6,
+        (peaks > 0) ? freq[0] : 0.0, (peaks > 1) ? freq[1] : 0.0);
+}
+
+int main()
+{
+    for (uint32_t i = 0; i < totalSamples; i++) {
+        signal[i] = (int16_t)(16384 + 3000 * sin(2 * PI * 87.3 * i / sampleRate) + 500 * sin(2 * PI * 300.0 * i / sampleRate)
+            + (rand() % 41 - 20));
+    }
+
+    printf("    N  us/window   Msamples/s      peak 1      peak 2\n");
+    bench<16>();
+    bench<32>();
+    bench<64>();
+    bench<128>();
+    bench<256>();
+    bench<512>();
+    bench<1024>();
+    bench<2048>();
+    bench<4096>();
+    return 0;
+}
@@ -0,0 +1,51 @@
+/********************************************************************
+ * Decodes the packets sent by the ICM20948_19_telemetry example and
+ * prints one line per data set (raw values).
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/telemetry_decode.cpp \
+ *       extras/host/HostArduino.cpp src/ICM20948_Telemetry.cpp -o telemetry_decode
+ *
+ * Run, e.g. with a serial port configured by stty:
+ *   ./telemetry_decode /dev/ttyUSB0
+ *   ./telemetry_decode capture.bin
+ *********************************************************************/
+
+#include "ICM20948_Telemetry.h"
+
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s file\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    ICM20948_TelemetryDecoder decoder;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        if (!decoder.push((uint8_t)c)) {
+            continue;
+        }
+        const int16_t* data = decoder.getData();
+        for (uint8_t s = 0; s < decoder.getSets(); s++) {
+            for (uint8_t ch = 0; ch < decoder.getChannels(); ch++) {
+                printf("%s%d", ch ? "\t" : "", *data++);
+            }
+            printf("\n");
+        }
+    }
+    fclose(in);
+
+    fprintf(stderr, "packets: %lu, lost: %lu, CRC errors: %lu, format errors: %lu\n",
+        (unsigned long)decoder.getPacketCount(), (unsigned long)decoder.getLostPackets(),
+        (unsigned long)decoder.getCrcErrors(), (unsigned long)decoder.getFormatErrors());
+    return 0;
+}
@@ -0,0 +1,175 @@
+/********************************************************************
+ * Time per FIFO data set (acceleration and gyroscope) of the runtime
+ * configured ICM20948 and the compile time configured ICM20948T. The
+ * devices are initialized with the simulated device, then the FIFO is
+ * read from a backend which answers immediately, so the time is that
+ * of the driver (transactions, decoding, correction), not of the bus.
+ * The last two lines compare the offset correction and scaling alone.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/template_bench.cpp \
+ *       extras/host/HostArduino.cpp extras/host/ICM20948_SimDevice.cpp \
+ *       src/ICM20948.cpp src/ICM20948_BusArbiter.cpp src/ICM20948_Recorder.cpp -o template_bench
+ *********************************************************************/
+
+#include "ICM20948.h"
+#include "ICM20948T.h"
+#include "ICM20948_SimDevice.h"
+
+#include <chrono>
+#include <stdio.h>
+
+static const uint32_t totalSets = 1UL << 20;
+static const uint16_t batch = 64;
+
+/* FIFO_COUNT is always 4095 bytes, FIFO_R_W returns a fixed pattern */
+class FastFifo : public TwoWireBackend {
+public:
+    uint8_t transfer(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) override
+    {
+        (void)addr;
+        if ((txLen > 0) && (tx[0] == ICM20948_FIFO_COUNT) && (rxLen == 2)) {
+            rx[0] = 0x0F;
+            rx[1] = 0xFF;
+            return 0;
+        }
+        for (size_t i = 0; i < rxLen; i++) {
+            rx[i] = (uint8_t)(i * 37 + 11);
+        }
+        return 0;
+    }
+};
+
+typedef ICM20948T<ICM20948_ACC_RANGE_4G, ICM20948_GYRO_RANGE_500> TemplateIMU;
+
+/* access to the correction functions of both classes */
+struct RuntimeCorrection : public ICM20948 {
+    RuntimeCorrection(TwoWire* w)
+        : ICM20948(w)
+    {
+    }
+    void convert(const xyzFloat* raw, xyzFloat* acc, xyzFloat* gyr, uint16_t sets)
+    {
+        for (uint16_t i = 0; i < sets; i++) {
+            acc[i] = correctAccRawValues(raw[2 * i], fifoAccRangeFactor);
+            acc[i].x = acc[i].x * fifoAccRangeFactor / 16384.0;
+            acc[i].y = acc[i].y * fifoAccRangeFactor / 16384.0;
+            acc[i].z = acc[i].z * fifoAccRangeFactor / 16384.0;
+            gyr[i] = correctGyrRawValues(raw[2 * i + 1], fifoGyrRangeFactor);
+            gyr[i].x = gyr[i].x * fifoGyrRangeFactor * 250.0 / 32768.0;
+            gyr[i].y = gyr[i].y * fifoGyrRangeFactor * 250.0 / 32768.0;
+            gyr[i].z = gyr[i].z * fifoGyrRangeFactor * 250.0 / 32768.0;
+        }
+    }
+};
+
+struct TemplateCorrection : public TemplateIMU {
+    TemplateCorrection(TwoWire* w)
+        : TemplateIMU(w)
+    {
+    }
+    void convert(const xyzFloat* raw, xyzFloat* acc, xyzFloat* gyr, uint16_t sets)
+    {
+        correction c = prepareCorrection();
+        for (uint16_t i = 0; i < sets; i++) {
+            acc[i] = correctAcc(raw[2 * i], c);
+            gyr[i] = correctGyr(raw[2 * i + 1], c);
+        }
+    }
+};
+
+static volatile float sink;
+
+/* minimum of several runs, reads totalSets data sets in each run */
+template <class F>
+static double nsPerSet(F readSets)
+{
+    double best = 1e30;
+    for (uint8_t run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        readSets();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds < best) {
+            best = seconds;
+        }
+    }
+    return best * 1e9 / totalSets;
+}
+
+int main()
+{
+    hostSetSimulatedClock(true);
+    ICM20948_SimDevice sim;
+    FastFifo fast;
+    TwoWire wire;
+    wire.setBackend(&sim);
+
+    RuntimeCorrection runtimeIMU(&wire);
+    runtimeIMU.init();
+    runtimeIMU.setAccRange(ICM20948_ACC_RANGE_4G);
+    runtimeIMU.setGyrRange(ICM20948_GYRO_RANGE_500);
+    runtimeIMU.setGyrOffsets(120.0, -80.0, 40.0);
+    runtimeIMU.enableFifo();
+    runtimeIMU.startFifo(ICM20948_FIFO_ACC_GYR);
+
+    ICM20948_SimDevice templateSim;
+    wire.setBackend(&templateSim);
+    TemplateCorrection templateIMU(&wire);
+    templateIMU.init();
+    templateIMU.setGyrOffsets(120.0, -80.0, 40.0);
+    templateIMU.enableFifo();
+    templateIMU.startFifo();
+
+    wire.setBackend(&fast);
+    static xyzFloat acc[batch], gyr[batch];
+    static int16_t raw[batch * 6];
+
+    double ns = nsPerSet([&]() {
+        for (uint32_t i = 0; i < totalSets; i++) {
+            xyzFloat g = runtimeIMU.getGValuesFromFifo();
+            xyzFloat w = runtimeIMU.getGyrValuesFromFifo();
+            sink = g.x + w.z;
+        }
+    });
+    printf("ICM20948  getGValuesFromFifo() + getGyrValuesFromFifo(): %6.1f ns/data set\n", ns);
+
+    ns = nsPerSet([&]() {
+        for (uint32_t i = 0; i < totalSets; i += batch) {
+            runtimeIMU.readFifoRawDataSets(raw, batch);
+            sink = raw[0];
+        }
+    });
+    printf("ICM20948  readFifoRawDataSets() (raw values only):      %6.1f ns/data set\n", ns);
+
+    ns = nsPerSet([&]() {
+        for (uint32_t i = 0; i < totalSets; i += batch) {
+            templateIMU.readFifoDataSets(acc, gyr, batch);
+            sink = acc[0].x + gyr[batch - 1].z;
+        }
+    });
+    printf("ICM20948T readFifoDataSets():                           %6.1f ns/data set\n", ns);
+
+    /* correction and scaling only, raw values in memory */
+    static xyzFloat rawVal[batch * 2];
+    for (uint16_t i = 0; i < batch * 2; i++) {
+        rawVal[i].x = (int16_t)(i * 997);
+        rawVal[i].y = (int16_t)(i * 1999);
+        rawVal[i].z = (int16_t)(i * 2999);
+    }
+    ns = nsPerSet([&]() {
+        for (uint32_t i = 0; i < totalSets; i += batch) {
+            runtimeIMU.convert(rawVal, acc, gyr, batch);
+            sink = acc[0].x + gyr[batch - 1].z;
+        }
+    });
+    printf("ICM20948  correction only:                              %6.1f ns/data set\n", ns);
+
+    ns = nsPerSet([&]() {
+        for (uint32_t i = 0; i < totalSets; i += batch) {
+            templateIMU.convert(rawVal, acc, gyr, batch);
+            sink = acc[0].x + gyr[batch - 1].z;
+        }
+    });
+    printf("ICM20948T correction only:                              %6.1f ns/data set\n", ns);
+    return 0;
+}
@@ -0,0 +1,115 @@
+/********************************************************************
+ * Checks the compile time configured ICM20948T against the runtime
+ * configured ICM20948 class with the simulated device: for all
+ * combinations of ranges, both read the same data registers and FIFO
+ * data sets and must return the same range factors, corrected raw
+ * values, g values and gyroscope values. Returns 1 if there is a
+ * difference.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++11 -O2 -Iextras/host -Isrc extras/host/examples/template_check.cpp \
+ *       extras/host/HostArduino.cpp extras/host/ICM20948_SimDevice.cpp \
+ *       src/ICM20948.cpp src/ICM20948_BusArbiter.cpp src/ICM20948_Recorder.cpp -o template_check
+ *
+ * Run:
+ *   ./template_check
+ *********************************************************************/
+
+#include "ICM20948.h"
+#include "ICM20948T.h"
+#include "ICM20948_SimDevice.h"
+
+#include <math.h>
+#include <stdio.h>
+
+static bool sameValues(const char* name, xyzFloat a, xyzFloat b)
+{
+    float tol = 1e-3f * (fabs(a.x) + fabs(a.y) + fabs(a.z) + 1.0f);
+    if ((fabs(a.x - b.x) > tol) || (fabs(a.y - b.y) > tol) || (fabs(a.z - b.z) > tol)) {
+        printf("  %s differs: runtime %.4f %.4f %.4f, template %.4f %.4f %.4f\n", name, a.x, a.y, a.z, b.x, b.y, b.z);
+        return false;
+    }
+    return true;
+}
+
+template <ICM20948_accRange ACC_RANGE, ICM20948_gyroRange GYR_RANGE>
+static bool check()
+{
+    /* one simulated device each, without noise they generate the same data */
+    ICM20948_SimDevice runtimeSim, templateSim;
+    runtimeSim.setNoise(0);
+    templateSim.setNoise(0);
+    TwoWire runtimeWire, templateWire;
+    runtimeWire.setBackend(&runtimeSim);
+    templateWire.setBackend(&templateSim);
+
+    ICM20948 runtimeIMU(&runtimeWire);
+    runtimeIMU.init();
+    runtimeIMU.setAccRange(ACC_RANGE);
+    runtimeIMU.setGyrRange(GYR_RANGE);
+    ICM20948T<ACC_RANGE, GYR_RANGE> templateIMU(&templateWire);
+    templateIMU.init();
+
+    /* offsets are stored for the +/-2 g and +/-250 dps ranges */
+    runtimeIMU.setAccOffsets(-16000.0, 16800.0, -16200.0, 16600.0, -16400.0, 16400.0);
+    templateIMU.setAccOffsets(-16000.0, 16800.0, -16200.0, 16600.0, -16400.0, 16400.0);
+    runtimeIMU.setGyrOffsets(120.0, -80.0, 40.0);
+    templateIMU.setGyrOffsets(120.0, -80.0, 40.0);
+
+    /* the simulated device updates the data registers with the FIFO data sets */
+    runtimeIMU.enableFifo();
+    runtimeIMU.startFifo(ICM20948_FIFO_ACC_GYR);
+    templateIMU.enableFifo();
+    templateIMU.startFifo();
+
+    bool ok = true;
+    for (uint8_t i = 0; i < 3; i++) {
+        delay(10);
+        runtimeIMU.readSensor();
+        templateIMU.readSensor();
+        ok &= (runtimeIMU.getAccRangeFactor() == templateIMU.getAccRangeFactor());
+        ok &= (runtimeIMU.getGyrRangeFactor() == templateIMU.getGyrRangeFactor());
+        ok &= sameValues("corrected acc raw", runtimeIMU.getCorrectedAccRawValues(),
+            templateIMU.getCorrectedAccRawValues());
+        ok &= sameValues("g", runtimeIMU.getGValues(), templateIMU.getGValues());
+        ok &= sameValues("gyr", runtimeIMU.getGyrValues(), templateIMU.getGyrValues());
+    }
+
+    /* FIFO: data sets one by one with the runtime class, in bursts with the template */
+    const uint8_t sets = 8;
+    xyzFloat acc[sets], gyr[sets];
+    runtimeIMU.resetFifo();
+    templateIMU.resetFifo();
+    delay(10);
+    if (templateIMU.readFifoDataSets(acc, gyr, sets) != sets) {
+        printf("  FIFO: less than %d data sets\n", sets);
+        ok = false;
+    } else {
+        for (uint8_t i = 0; i < sets; i++) {
+            ok &= sameValues("FIFO g", runtimeIMU.getGValuesFromFifo(), acc[i]);
+            ok &= sameValues("FIFO gyr", runtimeIMU.getGyrValuesFromFifo(), gyr[i]);
+        }
+    }
+    printf("acc +/-%2d g, gyr +/-%4d dps: %s\n", 2 << ACC_RANGE, 250 << GYR_RANGE, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+template <ICM20948_accRange ACC_RANGE>
+static bool checkGyrRanges()
+{
+    bool ok = check<ACC_RANGE, ICM20948_GYRO_RANGE_250>();
+    ok &= check<ACC_RANGE, ICM20948_GYRO_RANGE_500>();
+    ok &= check<ACC_RANGE, ICM20948_GYRO_RANGE_1000>();
+    ok &= check<ACC_RANGE, ICM20948_GYRO_RANGE_2000>();
+    return ok;
+}
+
+int main()
+{
+    hostSetSimulatedClock(true);
+    bool ok = checkGyrRanges<ICM20948_ACC_RANGE_2G>();
+    ok &= checkGyrRanges<ICM20948_ACC_RANGE_4G>();
+    ok &= checkGyrRanges<ICM20948_ACC_RANGE_8G>();
+    ok &= checkGyrRanges<ICM20948_ACC_RANGE_16G>();
+    return ok ? 0 : 1;
+}
@@ -20,6 +20,143 @@
  *********************************************************************/
 
 #include "ICM20948.h"
+#include "ICM20948_BusArbiter.h"
+#include "ICM20948_Recorder.h"
+
+#ifdef ICM20948_ENABLE_STATS
+#define ICM20948_STATS_BEGIN() uint32_t statsStart = micros()
+#define ICM20948_STATS_END(written, requested, received, status) \
+    updateStats(statsStart, written, received, ((status) != 0) || ((received) < (requested)))
+#else
+#define ICM20948_STATS_BEGIN()
+#define ICM20948_STATS_END(written, requested, received, status) ((void)(status), (void)(received))
+#endif
+
+/* 3 dB bandwidth [Hz] for ICM20948_DLPF_0 ... ICM20948_DLPF_7 and ICM20948_DLPF_OFF */
+static const float accDlpfBandwidth[9] = { 246.0, 246.0, 111.4, 50.4, 23.9, 11.5, 5.7, 473.0, 1209.0 };
+static const float gyrDlpfBandwidth[9] = { 196.6, 151.8, 119.5, 51.2, 23.9, 11.6, 5.7, 361.4, 12106.0 };
+
+/* register ranges of dumpRegisters(), ICM20948_REG_DUMP_LEN bytes in total */
+struct ICM20948_regDumpRange {
+    uint8_t bank;
+    uint8_t first;
+    uint8_t len;
+};
+
+static const ICM20948_regDumpRange regDumpRanges[ICM20948_REG_DUMP_RANGES] = {
+    { 0, ICM20948_WHO_AM_I, 20 }, // ... INT_ENABLE_3
+    { 0, ICM20948_DELAY_TIME_H, 2 },
+    { 0, ICM20948_ACCEL_OUT, 38 }, // ... EXT_SLV_SENS_DATA_23
+    { 0, ICM20948_FIFO_EN_1, 12 }, // ... FIFO_COUNT
+    { 0, ICM20948_DATA_RDY_STATUS, 3 }, // ... FIFO_CFG
+    { 1, ICM20948_SELF_TEST_X_GYRO, 26 }, // ... ZA_OFFS_L
+    { 1, ICM20948_TIMEBASE_CORR_PLL, 1 },
+    { 2, ICM20948_GYRO_SMPLRT_DIV, 22 }, // ... ACCEL_CONFIG_2
+    { 2, ICM20948_FSYNC_CONFIG, 3 }, // ... MOD_CTRL_USR
+    { 3, ICM20948_I2C_MST_ODR_CFG, 24 }, // ... I2C_SLV4_DI
+};
+
+static bool isVolatileRegister(uint8_t bank, uint8_t reg)
+{
+    /* measured values, not part of the configuration */
+    if (bank == 0) {
+        return ((reg >= ICM20948_DELAY_TIME_H) && (reg <= ICM20948_EXT_SLV_SENS_DATA_00 + 23))
+            || (reg == ICM20948_FIFO_COUNT) || (reg == ICM20948_FIFO_COUNT + 1) || (reg == ICM20948_DATA_RDY_STATUS);
+    }
+    return (bank == 3) && (reg == ICM20948_I2C_SLV4_DI);
+}
+
+static float estimateDelay(float bandwidth, float rate)
+{
+    /* group delay of the filter approximated as 1/(2*pi*f3dB) plus half a sample period */
+    return 1000.0 / (2.0 * PI * bandwidth) + 500.0 / rate;
+}
+
+static float planSensorRate(float rate, float maxDelay, const float* bandwidth, float offRate, uint16_t maxDiv,
+    uint16_t& div, ICM20948_dlpf& dlpf, float& delay)
+{
+    if (rate > ICM20948_BASE_SAMPLE_RATE) {
+        div = 0;
+        dlpf = ICM20948_DLPF_OFF;
+        delay = estimateDelay(bandwidth[ICM20948_DLPF_OFF], offRate);
+        return offRate;
+    }
+
+    float divider = (rate > 0.0) ? (ICM20948_BASE_SAMPLE_RATE / rate - 1.0) : 0.0;
+    div = (divider < 0.0) ? 0 : (uint16_t)(divider + 0.5);
+    if (div > maxDiv) {
+        div = maxDiv;
+    }
+    float actualRate = ICM20948_BASE_SAMPLE_RATE / (1 + div);
+
+    /* widest bandwidth below Nyquist within the delay limit, otherwise the narrowest within the limit */
+    int best = ICM20948_DLPF_7;
+    bool bestAliasFree = false;
+    bool found = false;
+    for (int i = ICM20948_DLPF_0; i <= ICM20948_DLPF_7; i++) {
+        if ((maxDelay > 0.0) && (estimateDelay(bandwidth[i], actualRate) > maxDelay)) {
+            continue;
+        }
+        bool aliasFree = bandwidth[i] <= (actualRate * 0.5);
+        if (!found || (aliasFree && (!bestAliasFree || (bandwidth[i] > bandwidth[best])))
+            || (!aliasFree && !bestAliasFree && (bandwidth[i] < bandwidth[best]))) {
+            best = i;
+            bestAliasFree = aliasFree;
+            found = true;
+        }
+    }
+    dlpf = (ICM20948_dlpf)best;
+    delay = estimateDelay(bandwidth[best], actualRate);
+    return actualRate;
+}
+
+static uint16_t rawPeak(int16_t x, int16_t y, int16_t z)
+{
+    uint16_t peak = (x < 0) ? -(int32_t)x : x;
+    uint16_t ay = (y < 0) ? -(int32_t)y : y;
+    uint16_t az = (z < 0) ? -(int32_t)z : z;
+    if (ay > peak) {
+        peak = ay;
+    }
+    if (az > peak) {
+        peak = az;
+    }
+    return peak;
+}
+
+static uint8_t rangeIndex(uint8_t rangeFactor)
+{
+    uint8_t index = 0;
+    while ((1 << index) < rangeFactor) {
+        index++;
+    }
+    return index;
+}
+
+static uint16_t rawPeak(xyzFloat v)
+{
+    return rawPeak((int16_t)v.x, (int16_t)v.y, (int16_t)v.z);
+}
+
+/* states of the non-blocking init / magnetometer sequences, see step() */
+enum {
+    ICM20948_STATE_IDLE,
+    ICM20948_STATE_RESET,
+    ICM20948_STATE_INIT,
+    ICM20948_STATE_MAG_I2C_MST,
+    ICM20948_STATE_MAG_RESET,
+    ICM20948_STATE_MAG_DEV_RESET,
+    ICM20948_STATE_MAG_WAKEUP,
+    ICM20948_STATE_MAG_I2C_MST_2,
+    ICM20948_STATE_MAG_WHO_AM_I,
+    ICM20948_STATE_MAG_CHECK,
+    ICM20948_STATE_MAG_OP_MODE,
+    ICM20948_STATE_MAG_DATA_READ,
+    ICM20948_STATE_MAG_SOFT_RESET,
+    ICM20948_STATE_MAG_WIA_READ,
+    ICM20948_STATE_MAG_WIA_RESULT,
+    ICM20948_STATE_FINISH
+};
 
 ///////////////////////////////////////////////
 // Constructors
@@ -29,24 +166,28 @@ ICM20948::ICM20948(int addr)
 {
     _wire = &Wire;
     i2cAddress = addr;
+    initMembers();
 }
 
 ICM20948::ICM20948()
 {
     _wire = &Wire;
     i2cAddress = 0x69;
+    initMembers();
 }
 
 ICM20948::ICM20948(TwoWire* w, int addr)
 {
     _wire = w;
     i2cAddress = addr;
+    initMembers();
 }
 
 ICM20948::ICM20948(TwoWire* w)
 {
     _wire = w;
     i2cAddress = 0x69;
+    initMembers();
 }
 
 ///////////////////////////////////////////////
@@ -55,35 +196,24 @@ ICM20948::ICM20948(TwoWire* w)
 
 bool ICM20948::init()
 {
-    currentBank = 0;
-
-    resetICM20948();
-    if (whoAmI() != ICM20948_WHO_AM_I_CONTENT) {
-        return false;
-    }
-
-    accOffsetVal.x = 0.0;
-    accOffsetVal.y = 0.0;
-    accOffsetVal.z = 0.0;
-    accCorrFactor.x = 1.0;
-    accCorrFactor.y = 1.0;
-    accCorrFactor.z = 1.0;
-    accRangeFactor = 1.0;
-    gyrOffsetVal.x = 0.0;
-    gyrOffsetVal.y = 0.0;
-    gyrOffsetVal.z = 0.0;
-    gyrRangeFactor = 1.0;
-    fifoType = ICM20948_FIFO_ACC;
-
-    wakeup();
-    writeRegister8(2, ICM20948_ODR_ALIGN_EN, 1); // aligns ODR
+    initAsync();
+    return finishAsync() == ICM20948_ASYNC_DONE;
+}
 
-    return true;
+bool ICM20948::initAsync()
+{
+    currentBank = 0;
+#ifdef ICM20948_ENABLE_STATS
+    resetStats();
+#endif
+    asyncState = ICM20948_STATE_IDLE; // a reset cancels everything else
+    return startAsync(ICM20948_STATE_RESET);
 }
 
 void ICM20948::autoOffsets(uint8_t runs)
 {
     xyzFloat accRawVal, gyrRawVal;
+    float tempSum = 0.0;
     accOffsetVal.x = 0.0;
     accOffsetVal.y = 0.0;
     accOffsetVal.z = 0.0;
@@ -107,6 +237,8 @@ void ICM20948::autoOffsets(uint8_t runs)
         gyrOffsetVal.y += gyrRawVal.y;
         gyrOffsetVal.z += gyrRawVal.z;
 
+        tempSum += getTemperature();
+
         delay(10);
     }
 
@@ -118,6 +250,9 @@ void ICM20948::autoOffsets(uint8_t runs)
     gyrOffsetVal.x /= runs;
     gyrOffsetVal.y /= runs;
     gyrOffsetVal.z /= runs;
+
+    tempCompRefTemp = tempSum / runs; // the offsets are valid for this temperature
+    tempCompDirty = true;
 }
 
 void ICM20948::setAccOffsets(float xMin, float xMax, float yMin, float yMax, float zMin, float zMax)
@@ -137,6 +272,27 @@ void ICM20948::setGyrOffsets(float xOffset, float yOffset, float zOffset)
     gyrOffsetVal.z = zOffset;
 }
 
+xyzFloat ICM20948::getGyrOffsets()
+{
+    return gyrOffsetVal;
+}
+
+void ICM20948::setGyrHardwareOffsets(float xOffset, float yOffset, float zOffset)
+{
+    /* Offsets in raw values of the +/-250 dps range, like setGyrOffsets(). XG_OFFS_USR is
+     * added to the sensor value, 1 LSB corresponds to 4 LSB at +/-250 dps. */
+    float offs[3] = { xOffset, yOffset, zOffset };
+    for (uint8_t i = 0; i < 3; i++) {
+        float val = round(-offs[i] / 4.0);
+        if (val > 32767.0) {
+            val = 32767.0;
+        } else if (val < -32768.0) {
+            val = -32768.0;
+        }
+        writeRegister16(2, ICM20948_XG_OFFS_USRH + 2 * i, (int16_t)val);
+    }
+}
+
 uint8_t ICM20948::whoAmI()
 {
     return readRegister8(0, ICM20948_WHO_AM_I);
@@ -162,7 +318,10 @@ void ICM20948::setAccRange(ICM20948_accRange accRange)
     regVal &= ~(0x06);
     regVal |= (accRange << 1);
     writeRegister8(2, ICM20948_ACCEL_CONFIG, regVal);
+    markFifoRangeChange();
     accRangeFactor = 1 << accRange;
+    accLowCount = 0;
+    dataRangeChanged = true;
 }
 
 void ICM20948::setAccDLPF(ICM20948_dlpf dlpf)
@@ -205,7 +364,10 @@ void ICM20948::setGyrRange(ICM20948_gyroRange gyroRange)
     regVal &= ~(0x06);
     regVal |= (gyroRange << 1);
     writeRegister8(2, ICM20948_GYRO_CONFIG_1, regVal);
+    markFifoRangeChange();
     gyrRangeFactor = (1 << gyroRange);
+    gyrLowCount = 0;
+    dataRangeChanged = true;
 }
 
 void ICM20948::setGyrDLPF(ICM20948_dlpf dlpf)
@@ -240,13 +402,124 @@ void ICM20948::setI2CMstSampleRate(uint8_t rateExp)
     }
 }
 
+ICM20948_ratePlan ICM20948::planSampleRates(float accRate, float gyrRate, float magRate, float maxDelay)
+{
+    ICM20948_ratePlan plan;
+    uint16_t div;
+
+    plan.accRate = planSensorRate(accRate, maxDelay, accDlpfBandwidth, 4500.0, 4095, plan.accDiv, plan.accDlpf, plan.accDelay);
+    plan.gyrRate = planSensorRate(gyrRate, maxDelay, gyrDlpfBandwidth, 9000.0, 255, div, plan.gyrDlpf, plan.gyrDelay);
+    plan.gyrDiv = div;
+
+    plan.i2cMstRateExp = 0;
+    plan.magOpMode = AK09916_PWR_DOWN;
+    plan.magRate = 0.0;
+    if (magRate > 0.0) {
+        if (magRate <= 10.0) {
+            plan.magOpMode = AK09916_CONT_MODE_10HZ;
+            plan.magRate = 10.0;
+        } else if (magRate <= 20.0) {
+            plan.magOpMode = AK09916_CONT_MODE_20HZ;
+            plan.magRate = 20.0;
+        } else if (magRate <= 50.0) {
+            plan.magOpMode = AK09916_CONT_MODE_50HZ;
+            plan.magRate = 50.0;
+        } else {
+            plan.magOpMode = AK09916_CONT_MODE_100HZ;
+            plan.magRate = 100.0;
+        }
+        /* slowest I2C master rate which still reads every magnetometer sample */
+        while ((plan.i2cMstRateExp < 15)
+            && ((ICM20948_I2C_MST_BASE_RATE / (1 << (plan.i2cMstRateExp + 1))) >= (2.0 * plan.magRate))) {
+            plan.i2cMstRateExp++;
+        }
+    }
+
+    return plan;
+}
+
+void ICM20948::applySampleRatePlan(ICM20948_ratePlan plan)
+{
+    setAccDLPF(plan.accDlpf);
+    setAccSampleRateDivider(plan.accDiv);
+    setGyrDLPF(plan.gyrDlpf);
+    setGyrSampleRateDivider(plan.gyrDiv);
+    if (plan.magRate > 0.0) {
+        setI2CMstSampleRate(plan.i2cMstRateExp);
+        setMagOpMode(plan.magOpMode);
+    }
+}
+
+ICM20948_ratePlan ICM20948::setSampleRates(float accRate, float gyrRate, float magRate, float maxDelay)
+{
+    ICM20948_ratePlan plan = planSampleRates(accRate, gyrRate, magRate, maxDelay);
+    applySampleRatePlan(plan);
+    return plan;
+}
+
+///////////////////////////////////////////////
+// Automatic range switching
+///////////////////////////////////////////////
+
+void ICM20948::enableAutoRange(bool acc, bool gyr)
+{
+    autoRangeAcc = acc;
+    autoRangeGyr = gyr;
+    accLowCount = 0;
+    gyrLowCount = 0;
+}
+
+void ICM20948::disableAutoRange()
+{
+    enableAutoRange(false, false);
+}
+
+void ICM20948::setAutoRangeLimits(float upper, float lower, uint16_t lowSamples)
+{
+    /* limits as fraction of full scale; lower < upper/2 gives the hysteresis */
+    if (upper > 1.0) {
+        upper = 1.0;
+    }
+    if (lower > (upper * 0.45)) {
+        lower = upper * 0.45;
+    }
+    autoRangeUpper = (uint16_t)(upper * 32767.0);
+    autoRangeLower = (uint16_t)(lower * 32767.0);
+    autoRangeLowSamples = lowSamples;
+}
+
+uint8_t ICM20948::getAccRangeFactor()
+{
+    return dataAccRangeFactor;
+}
+
+uint8_t ICM20948::getGyrRangeFactor()
+{
+    return dataGyrRangeFactor;
+}
+
+uint8_t ICM20948::getFifoAccRangeFactor()
+{
+    return fifoAccRangeFactor;
+}
+
+uint8_t ICM20948::getFifoGyrRangeFactor()
+{
+    return fifoGyrRangeFactor;
+}
+
 ///////////////////////////////////////////////
 // x,y,z results
 ///////////////////////////////////////////////
 
 void ICM20948::readSensor()
 {
+    bool prevDataReady = buffer[14] & AK09916_DRDY;
+    uint8_t prevData[12];
+    memcpy(prevData, buffer, 12);
     readAllData(buffer);
+    updateMagStatus(prevDataReady);
+    updateDataRange(prevData);
 }
 
 xyzFloat ICM20948::getAccRawValues()
@@ -261,7 +534,7 @@ xyzFloat ICM20948::getAccRawValues()
 xyzFloat ICM20948::getCorrectedAccRawValues()
 {
     xyzFloat accRawVal = getAccRawValues();
-    accRawVal = correctAccRawValues(accRawVal);
+    accRawVal = correctAccRawValues(accRawVal, dataAccRangeFactor);
 
     return accRawVal;
 }
@@ -271,9 +544,9 @@ xyzFloat ICM20948::getGValues()
     xyzFloat gVal, accRawVal;
     accRawVal = getCorrectedAccRawValues();
 
-    gVal.x = accRawVal.x * accRangeFactor / 16384.0;
-    gVal.y = accRawVal.y * accRangeFactor / 16384.0;
-    gVal.z = accRawVal.z * accRangeFactor / 16384.0;
+    gVal.x = accRawVal.x * dataAccRangeFactor / 16384.0;
+    gVal.y = accRawVal.y * dataAccRangeFactor / 16384.0;
+    gVal.z = accRawVal.z * dataAccRangeFactor / 16384.0;
     return gVal;
 }
 
@@ -286,7 +559,10 @@ xyzFloat ICM20948::getAccRawValuesFromFifo()
 xyzFloat ICM20948::getCorrectedAccRawValuesFromFifo()
 {
     xyzFloat accRawVal = getAccRawValuesFromFifo();
-    accRawVal = correctAccRawValues(accRawVal);
+    if (autoRangeAcc) {
+        checkAutoRange(rawPeak(accRawVal), 0, fifoAccRangeFactor, 0, 1);
+    }
+    accRawVal = correctAccRawValues(accRawVal, fifoAccRangeFactor);
 
     return accRawVal;
 }
@@ -296,9 +572,9 @@ xyzFloat ICM20948::getGValuesFromFifo()
     xyzFloat gVal, accRawVal;
     accRawVal = getCorrectedAccRawValuesFromFifo();
 
-    gVal.x = accRawVal.x * accRangeFactor / 16384.0;
-    gVal.y = accRawVal.y * accRangeFactor / 16384.0;
-    gVal.z = accRawVal.z * accRangeFactor / 16384.0;
+    gVal.x = accRawVal.x * fifoAccRangeFactor / 16384.0;
+    gVal.y = accRawVal.y * fifoAccRangeFactor / 16384.0;
+    gVal.z = accRawVal.z * fifoAccRangeFactor / 16384.0;
     return gVal;
 }
 
@@ -331,7 +607,7 @@ xyzFloat ICM20948::getGyrRawValues()
 xyzFloat ICM20948::getCorrectedGyrRawValues()
 {
     xyzFloat gyrRawVal = getGyrRawValues();
-    gyrRawVal = correctGyrRawValues(gyrRawVal);
+    gyrRawVal = correctGyrRawValues(gyrRawVal, dataGyrRangeFactor);
     return gyrRawVal;
 }
 
@@ -339,9 +615,9 @@ xyzFloat ICM20948::getGyrValues()
 {
     xyzFloat gyrVal = getCorrectedGyrRawValues();
 
-    gyrVal.x = gyrVal.x * gyrRangeFactor * 250.0 / 32768.0;
-    gyrVal.y = gyrVal.y * gyrRangeFactor * 250.0 / 32768.0;
-    gyrVal.z = gyrVal.z * gyrRangeFactor * 250.0 / 32768.0;
+    gyrVal.x = gyrVal.x * dataGyrRangeFactor * 250.0 / 32768.0;
+    gyrVal.y = gyrVal.y * dataGyrRangeFactor * 250.0 / 32768.0;
+    gyrVal.z = gyrVal.z * dataGyrRangeFactor * 250.0 / 32768.0;
 
     return gyrVal;
 }
@@ -351,10 +627,13 @@ xyzFloat ICM20948::getGyrValuesFromFifo()
     xyzFloat gyrVal;
     xyzFloat gyrRawVal = readICM20948xyzValFromFifo();
 
-    gyrRawVal = correctGyrRawValues(gyrRawVal);
-    gyrVal.x = gyrRawVal.x * gyrRangeFactor * 250.0 / 32768.0;
-    gyrVal.y = gyrRawVal.y * gyrRangeFactor * 250.0 / 32768.0;
-    gyrVal.z = gyrRawVal.z * gyrRangeFactor * 250.0 / 32768.0;
+    if (autoRangeGyr) {
+        checkAutoRange(0, rawPeak(gyrRawVal), 0, fifoGyrRangeFactor, 1);
+    }
+    gyrRawVal = correctGyrRawValues(gyrRawVal, fifoGyrRangeFactor);
+    gyrVal.x = gyrRawVal.x * fifoGyrRangeFactor * 250.0 / 32768.0;
+    gyrVal.y = gyrRawVal.y * fifoGyrRangeFactor * 250.0 / 32768.0;
+    gyrVal.z = gyrRawVal.z * fifoGyrRangeFactor * 250.0 / 32768.0;
 
     return gyrVal;
 }
@@ -364,9 +643,9 @@ xyzFloat ICM20948::getMagValues()
     int16_t x, y, z;
     xyzFloat mag;
 
-    x = (int16_t)((buffer[15]) << 8) | buffer[14];
-    y = (int16_t)((buffer[17]) << 8) | buffer[16];
-    z = (int16_t)((buffer[19]) << 8) | buffer[18];
+    x = (int16_t)((buffer[16]) << 8) | buffer[15];
+    y = (int16_t)((buffer[18]) << 8) | buffer[17];
+    z = (int16_t)((buffer[20]) << 8) | buffer[19];
 
     mag.x = x * AK09916_MAG_LSB;
     mag.y = y * AK09916_MAG_LSB;
@@ -375,6 +654,118 @@ xyzFloat ICM20948::getMagValues()
     return mag;
 }
 
+bool ICM20948::isNewMagData()
+{
+    return magNewData;
+}
+
+bool ICM20948::isMagOverflow()
+{
+    if (slv0Len != AK09916_DATA_BLOCK_LEN) {
+        return false; // no magnetometer data in the buffer (aux slaves start at 14)
+    }
+    return buffer[22] & AK09916_OVF;
+}
+
+bool ICM20948::isMagDataOverrun()
+{
+    if (slv0Len != AK09916_DATA_BLOCK_LEN) {
+        return false;
+    }
+    return buffer[14] & AK09916_DOR;
+}
+
+uint32_t ICM20948::getMagSequence()
+{
+    return magSequence;
+}
+
+///////////////////////////////////////////////
+// Temperature compensation
+///////////////////////////////////////////////
+
+void ICM20948::enableTempCompensation()
+{
+    tempCompEnabled = true;
+    tempCompDirty = true;
+}
+
+void ICM20948::disableTempCompensation()
+{
+    tempCompEnabled = false;
+    accTempBias = { 0.0, 0.0, 0.0 };
+    gyrTempBias = { 0.0, 0.0, 0.0 };
+}
+
+void ICM20948::setTempCompReference(float refTemp)
+{
+    tempCompRefTemp = refTemp;
+    tempCompDirty = true;
+}
+
+void ICM20948::setTempCompThreshold(float deltaTemp)
+{
+    tempCompThreshold = deltaTemp;
+}
+
+void ICM20948::addTempCompSample()
+{
+    /* Incremental (Welford) least squares fit of raw value vs. temperature. Only the
+     * slopes are used, so the sample may contain a constant offset like gravity. The
+     * ICM20948 must not be moved while the samples are collected. */
+    float temp = getTemperature();
+    xyzFloat accRawVal = getAccRawValues();
+    xyzFloat gyrRawVal = getGyrRawValues();
+    float dTemp;
+
+    accRawVal.x *= dataAccRangeFactor;
+    accRawVal.y *= dataAccRangeFactor;
+    accRawVal.z *= dataAccRangeFactor;
+    gyrRawVal.x *= dataGyrRangeFactor;
+    gyrRawVal.y *= dataGyrRangeFactor;
+    gyrRawVal.z *= dataGyrRangeFactor;
+
+    tempCompSamples++;
+    dTemp = temp - tempCompMeanTemp;
+    tempCompMeanTemp += dTemp / tempCompSamples;
+    tempCompTempM2 += dTemp * (temp - tempCompMeanTemp);
+
+    accTempMean.x += (accRawVal.x - accTempMean.x) / tempCompSamples;
+    accTempMean.y += (accRawVal.y - accTempMean.y) / tempCompSamples;
+    accTempMean.z += (accRawVal.z - accTempMean.z) / tempCompSamples;
+    accTempCoMoment.x += dTemp * (accRawVal.x - accTempMean.x);
+    accTempCoMoment.y += dTemp * (accRawVal.y - accTempMean.y);
+    accTempCoMoment.z += dTemp * (accRawVal.z - accTempMean.z);
+
+    gyrTempMean.x += (gyrRawVal.x - gyrTempMean.x) / tempCompSamples;
+    gyrTempMean.y += (gyrRawVal.y - gyrTempMean.y) / tempCompSamples;
+    gyrTempMean.z += (gyrRawVal.z - gyrTempMean.z) / tempCompSamples;
+    gyrTempCoMoment.x += dTemp * (gyrRawVal.x - gyrTempMean.x);
+    gyrTempCoMoment.y += dTemp * (gyrRawVal.y - gyrTempMean.y);
+    gyrTempCoMoment.z += dTemp * (gyrRawVal.z - gyrTempMean.z);
+
+    tempCompDirty = true;
+}
+
+void ICM20948::resetTempCompModel()
+{
+    tempCompSamples = 0;
+    tempCompMeanTemp = 0.0;
+    tempCompTempM2 = 0.0;
+    accTempMean = { 0.0, 0.0, 0.0 };
+    accTempCoMoment = { 0.0, 0.0, 0.0 };
+    accTempBias = { 0.0, 0.0, 0.0 };
+    gyrTempMean = { 0.0, 0.0, 0.0 };
+    gyrTempCoMoment = { 0.0, 0.0, 0.0 };
+    gyrTempBias = { 0.0, 0.0, 0.0 };
+    tempCompDirty = true;
+}
+
+bool ICM20948::isTempCompModelValid()
+{
+    return (tempCompSamples > 1) && (tempCompTempM2 >= ICM20948_TEMP_COMP_MIN_VAR * tempCompSamples);
+}
+
 ///////////////////////////////////////////////
 // Power, Sleep, Standby
 ///////////////////////////////////////////////
@@ -564,31 +955,71 @@ void ICM20948::disableInterrupt(ICM20948_intType intType)
 
 uint8_t ICM20948::readAndClearInterrupts()
 {
-    uint8_t intSource = 0;
-    regVal = readRegister8(0, ICM20948_I2C_MST_STATUS);
-    if (regVal & 0x80) {
-        intSource |= 0x01;
+    return readInterruptSnapshot().source;
+}
+
+ICM20948_intSnapshot ICM20948::readInterruptSnapshot(bool withData, bool withFifoCount)
+{
+    /* I2C_MST_STATUS ... INT_STATUS_3 in one burst. The data registers follow after
+     * 16 reserved bytes and are included if the Wire buffer is large enough. FIFO_COUNT
+     * is too far away (0x70), reading it separately is faster than a 91 byte burst. */
+    ICM20948_intSnapshot snap;
+    bool prevDataReady = buffer[14] & AK09916_DRDY;
+    uint8_t prevData[12];
+    memcpy(prevData, buffer, 12);
+#if ICM20948_WIRE_BUFFER_SIZE >= ICM20948_INT_DATA_BLOCK_LEN
+    const uint8_t dataOffset = ICM20948_ACCEL_OUT - ICM20948_I2C_MST_STATUS;
+    uint8_t block[dataOffset + ICM20948_MAX_DATA_BLOCK_LEN];
+    if (withData && ((dataOffset + dataBlockLen) <= ICM20948_WIRE_BUFFER_SIZE)) {
+        readRegisters(0, ICM20948_I2C_MST_STATUS, block, dataOffset + dataBlockLen);
+        memcpy(buffer, &block[dataOffset], dataBlockLen);
+    } else {
+        readRegisters(0, ICM20948_I2C_MST_STATUS, block, ICM20948_INT_BLOCK_LEN);
+        if (withData) {
+            readAllData(buffer);
+        }
     }
-    regVal = readRegister8(0, ICM20948_INT_STATUS);
-    if (regVal & 0x08) {
-        intSource |= 0x02;
+#else
+    uint8_t block[ICM20948_INT_BLOCK_LEN];
+    readRegisters(0, ICM20948_I2C_MST_STATUS, block, ICM20948_INT_BLOCK_LEN);
+    if (withData) {
+        readAllData(buffer);
     }
-    if (regVal & 0x02) {
-        intSource |= 0x04;
+#endif
+
+    snap.i2cMstStatus = block[0];
+    snap.intStatus = block[ICM20948_INT_STATUS - ICM20948_I2C_MST_STATUS];
+    snap.intStatus1 = block[ICM20948_INT_STATUS_1 - ICM20948_I2C_MST_STATUS];
+    snap.intStatus2 = block[ICM20948_INT_STATUS_2 - ICM20948_I2C_MST_STATUS];
+    snap.intStatus3 = block[ICM20948_INT_STATUS_3 - ICM20948_I2C_MST_STATUS];
+
+    snap.source = 0;
+    if (snap.i2cMstStatus & 0x80) {
+        snap.source |= 0x01;
+    }
+    if (snap.intStatus & 0x08) {
+        snap.source |= 0x02;
+    }
+    if (snap.intStatus & 0x02) {
+        snap.source |= 0x04;
     }
-    regVal = readRegister8(0, ICM20948_INT_STATUS_1);
-    if (regVal & 0x01) {
-        intSource |= 0x08;
+    if (snap.intStatus1 & 0x01) {
+        snap.source |= 0x08;
     }
-    regVal = readRegister8(0, ICM20948_INT_STATUS_2);
-    if (regVal & 0x01) {
-        intSource |= 0x10;
+    if (snap.intStatus2 & 0x01) {
+        snap.source |= 0x10;
     }
-    regVal = readRegister8(0, ICM20948_INT_STATUS_3);
-    if (regVal & 0x01) {
-        intSource |= 0x20;
+    if (snap.intStatus3 & 0x01) {
+        snap.source |= 0x20;
     }
-    return intSource;
+
+    snap.hasData = withData;
+    if (withData) {
+        updateMagStatus(prevDataReady);
+        updateDataRange(prevData);
+    }
+    snap.fifoCount = withFifoCount ? getFifoCount() : -1;
+    return snap;
 }
 
 bool ICM20948::checkInterrupt(uint8_t source, ICM20948_intType type)
@@ -617,6 +1048,7 @@ void ICM20948::enableFifo()
     regVal = readRegister8(0, ICM20948_USER_CTRL);
     regVal |= ICM20948_FIFO_EN;
     writeRegister8(0, ICM20948_USER_CTRL, regVal);
+    fifoEnabled = true;
 }
 
 void ICM20948::disableFifo()
@@ -624,6 +1056,7 @@ void ICM20948::disableFifo()
     regVal = readRegister8(0, ICM20948_USER_CTRL);
     regVal &= ~ICM20948_FIFO_EN;
     writeRegister8(0, ICM20948_USER_CTRL, regVal);
+    fifoEnabled = false;
 }
 
 void ICM20948::setFifoMode(ICM20948_fifoMode mode)
@@ -640,17 +1073,23 @@ void ICM20948::startFifo(ICM20948_fifoType fifo)
 {
     fifoType = fifo;
     writeRegister8(0, ICM20948_FIFO_EN_2, fifoType);
+    fifoRunning = true;
+    fifoHoldsData = true;
+    fifoRangeSegCount = 0;
 }
 
 void ICM20948::stopFifo()
 {
     writeRegister8(0, ICM20948_FIFO_EN_2, 0);
+    fifoRunning = false;
 }
 
 void ICM20948::resetFifo()
 {
     writeRegister8(0, ICM20948_FIFO_RST, 0x01);
     writeRegister8(0, ICM20948_FIFO_RST, 0x00);
+    fifoHoldsData = fifoRunning;
+    fifoRangeSegCount = 0;
 }
 
 int16_t ICM20948::getFifoCount()
@@ -679,61 +1118,486 @@ void ICM20948::findFifoBegin()
 
     if ((fifoType == ICM20948_FIFO_ACC) || (fifoType == ICM20948_FIFO_GYR)) {
         start = count % 6;
+        takeFifoBytes(start);
         for (int i = 0; i < start; i++) {
             readRegister8(0, ICM20948_FIFO_R_W);
         }
     } else if (fifoType == ICM20948_FIFO_ACC_GYR) {
         start = count % 12;
+        takeFifoBytes(start);
         for (int i = 0; i < start; i++) {
             readRegister8(0, ICM20948_FIFO_R_W);
         }
     }
 }
 
+uint16_t ICM20948::readFifoRawDataSets(int16_t* data, uint16_t maxSets)
+{
+    /* raw values as stored in the FIFO: acc x,y,z and/or gyr x,y,z per data set */
+    uint8_t setSize = (fifoType == ICM20948_FIFO_ACC_GYR) ? 12 : 6;
+    uint8_t setsPerBurst = ICM20948_FIFO_BURST_LEN / setSize;
+    uint8_t bytes[ICM20948_FIFO_BURST_LEN];
+    uint16_t sets = getFifoCount() / setSize;
+    if (sets > maxSets) {
+        sets = maxSets;
+    }
+    /* a batch does not span a range switch, getFifoAccRangeFactor() / getFifoGyrRangeFactor()
+     * return the range of the whole batch */
+    if (fifoRangeSegCount > 0) {
+        uint16_t segSets = (fifoRangeSegs[0].bytes + setSize - 1) / setSize;
+        if (sets > segSets) {
+            sets = segSets;
+        }
+    }
+
+    uint16_t done = 0;
+    uint16_t accPeak = 0;
+    uint16_t gyrPeak = 0;
+    uint8_t gyrStart = (fifoType == ICM20948_FIFO_GYR) ? 0 : 6;
+    while (done < sets) {
+        uint8_t n = ((sets - done) > setsPerBurst) ? setsPerBurst : (sets - done);
+        readFifoBytes(bytes, n * setSize);
+        for (uint8_t i = 0; i < n * setSize; i += 2) {
+            *data++ = (int16_t)((bytes[i] << 8) | bytes[i + 1]);
+        }
+        if (autoRangeAcc || autoRangeGyr) {
+            const int16_t* set = data - n * setSize / 2;
+            for (uint8_t i = 0; i < n; i++, set += setSize / 2) {
+                uint16_t peak;
+                if (fifoType != ICM20948_FIFO_GYR) {
+                    peak = rawPeak(set[0], set[1], set[2]);
+                    accPeak = (peak > accPeak) ? peak : accPeak;
+                }
+                if (fifoType != ICM20948_FIFO_ACC) {
+                    peak = rawPeak(set[gyrStart / 2], set[gyrStart / 2 + 1], set[gyrStart / 2 + 2]);
+                    gyrPeak = (peak > gyrPeak) ? peak : gyrPeak;
+                }
+            }
+        }
+        done += n;
+    }
+    if ((done > 0) && (autoRangeAcc || autoRangeGyr)) {
+        checkAutoRange(accPeak, gyrPeak, (fifoType != ICM20948_FIFO_GYR) ? fifoAccRangeFactor : 0,
+            (fifoType != ICM20948_FIFO_ACC) ? fifoGyrRangeFactor : 0, done);
+    }
+    return done;
+}
+
 ///////////////////////////////////////////////
 // Magnetometer
 ///////////////////////////////////////////////
 
 bool ICM20948::initMagnetometer()
 {
-    enableI2CMaster();
-    resetMag();
-    resetICM20948();
-    wakeup();
-    writeRegister8(2, ICM20948_ODR_ALIGN_EN, 1); // aligns ODR
-    delay(10);
-    enableI2CMaster();
-    delay(10);
+    finishAsync();
+    initMagnetometerAsync();
+    return finishAsync() == ICM20948_ASYNC_DONE;
+}
 
-    int16_t whoAmI = whoAmIMag();
-    if (!((whoAmI == AK09916_WHO_AM_I_1) || (whoAmI == AK09916_WHO_AM_I_2))) {
+bool ICM20948::initMagnetometerAsync()
+{
+    asyncOpMode = AK09916_CONT_MODE_100HZ;
+    return startAsync(ICM20948_STATE_MAG_I2C_MST);
+}
+
+int16_t ICM20948::whoAmIMag()
+{
+    finishAsync();
+    whoAmIMagAsync();
+    finishAsync();
+    return asyncResult;
+}
+
+bool ICM20948::whoAmIMagAsync()
+{
+    return startAsync(ICM20948_STATE_MAG_WIA_READ);
+}
+
+void ICM20948::setMagOpMode(AK09916_opMode opMode)
+{
+    finishAsync();
+    setMagOpModeAsync(opMode);
+    finishAsync();
+}
+
+bool ICM20948::setMagOpModeAsync(AK09916_opMode opMode)
+{
+    asyncOpMode = opMode;
+    return startAsync(ICM20948_STATE_MAG_OP_MODE);
+}
+
+void ICM20948::resetMag()
+{
+    finishAsync();
+    resetMagAsync();
+    finishAsync();
+}
+
+bool ICM20948::resetMagAsync()
+{
+    return startAsync(ICM20948_STATE_MAG_SOFT_RESET);
+}
+
+///////////////////////////////////////////////
+// Auxiliary I2C sensors
+///////////////////////////////////////////////
+
+bool ICM20948::setAuxSlave(uint8_t slave, uint8_t addr, uint8_t reg, uint8_t len, bool decimate)
+{
+    if ((slave < 1) || (slave > ICM20948_AUX_SLAVES) || (len == 0) || (len > 15)) {
+        return false;
+    }
+    /* the magnetometer block is reserved, initMagnetometer() may still follow */
+    uint8_t total = AK09916_DATA_BLOCK_LEN + len;
+    for (uint8_t i = 0; i < ICM20948_AUX_SLAVES; i++) {
+        if (i != (slave - 1)) {
+            total += auxLen[i];
+        }
+    }
+    if (total > ICM20948_EXT_SENS_DATA_LEN) {
         return false;
     }
-    setMagOpMode(AK09916_CONT_MODE_100HZ);
 
+    auxAddr[slave - 1] = addr;
+    auxReg[slave - 1] = reg;
+    auxLen[slave - 1] = len;
+    if (decimate) {
+        auxDecimated |= (1 << slave);
+    } else {
+        auxDecimated &= ~(1 << slave);
+    }
+    writeAuxSlave(slave);
+    updateDataBlockLen();
     return true;
 }
 
-int16_t ICM20948::whoAmIMag()
+void ICM20948::disableAuxSlave(uint8_t slave)
 {
-    return readAK09916Register16(AK09916_WIA_1);
+    if ((slave < 1) || (slave > ICM20948_AUX_SLAVES)) {
+        return;
+    }
+    writeRegister8(3, ICM20948_I2C_SLV1_ADDR + (slave - 1) * 4 + 2, 0x00);
+    auxLen[slave - 1] = 0;
+    auxDecimated &= ~(1 << slave);
+    updateDataBlockLen();
 }
 
-void ICM20948::setMagOpMode(AK09916_opMode opMode)
+void ICM20948::setAuxDecimation(uint8_t i2cMstDly)
 {
-    writeAK09916Register8(AK09916_CNTL_2, opMode);
-    delay(10);
-    if (opMode != AK09916_PWR_DOWN) {
-        enableMagDataRead(AK09916_HXL, 0x08);
+    /* slaves with decimation are read every (1 + i2cMstDly) I2C master cycles */
+    auxMstDly = i2cMstDly & 0x1F;
+    beginBusSequence();
+    regVal = readRegister8(3, ICM20948_I2C_SLV4_CTRL);
+    regVal = (regVal & ~0x1F) | (i2cMstDly & 0x1F);
+    writeRegister8(3, ICM20948_I2C_SLV4_CTRL, regVal);
+    endBusSequence();
+}
+
+bool ICM20948::getAuxData(uint8_t slave, uint8_t* data)
+{
+    if ((slave < 1) || (slave > ICM20948_AUX_SLAVES) || (auxLen[slave - 1] == 0)) {
+        return false;
     }
+    /* the data of the active slaves is stored one after the other */
+    uint8_t pos = 14 + slv0Len;
+    for (uint8_t i = 0; i < (slave - 1); i++) {
+        pos += auxLen[i];
+    }
+    memcpy(data, &buffer[pos], auxLen[slave - 1]);
+    return true;
 }
 
-void ICM20948::resetMag()
+bool ICM20948::writeAuxRegister(uint8_t addr, uint8_t reg, uint8_t val)
 {
-    writeAK09916Register8(AK09916_CNTL_3, 0x01);
-    delay(100);
+    beginBusSequence();
+    writeRegister8(3, ICM20948_I2C_SLV4_ADDR, addr);
+    writeRegister8(3, ICM20948_I2C_SLV4_REG, reg);
+    writeRegister8(3, ICM20948_I2C_SLV4_DO, val);
+    regVal = readRegister8(3, ICM20948_I2C_SLV4_CTRL);
+    writeRegister8(3, ICM20948_I2C_SLV4_CTRL, regVal | 0x80);
+    bool done = waitForSlv4();
+    endBusSequence();
+    return done;
+}
+
+bool ICM20948::readAuxRegister(uint8_t addr, uint8_t reg, uint8_t* val)
+{
+    beginBusSequence();
+    writeRegister8(3, ICM20948_I2C_SLV4_ADDR, addr | AK09916_READ);
+    writeRegister8(3, ICM20948_I2C_SLV4_REG, reg);
+    regVal = readRegister8(3, ICM20948_I2C_SLV4_CTRL);
+    writeRegister8(3, ICM20948_I2C_SLV4_CTRL, regVal | 0x80);
+    bool done = waitForSlv4();
+    if (done) {
+        *val = readRegister8(3, ICM20948_I2C_SLV4_DI);
+    }
+    endBusSequence();
+    return done;
 }
 
+///////////////////////////////////////////////
+// Non-blocking execution
+///////////////////////////////////////////////
+
+ICM20948_asyncStatus ICM20948::step()
+{
+    if (asyncState == ICM20948_STATE_IDLE) {
+        return ICM20948_ASYNC_DONE;
+    }
+    if ((int32_t)(micros() - asyncReadyAt) < 0) {
+        return ICM20948_ASYNC_BUSY;
+    }
+
+    switch (asyncState) {
+    case ICM20948_STATE_RESET:
+        resetICM20948();
+        return asyncWait(ICM20948_STATE_INIT, 10); // wait for registers to reset
+
+    case ICM20948_STATE_INIT:
+        if (whoAmI() != ICM20948_WHO_AM_I_CONTENT) {
+            asyncState = ICM20948_STATE_IDLE;
+            return ICM20948_ASYNC_ERROR;
+        }
+        resetSettings();
+
+        wakeup();
+        writeRegister8(2, ICM20948_ODR_ALIGN_EN, 1); // aligns ODR
+        asyncState = ICM20948_STATE_IDLE;
+        return ICM20948_ASYNC_DONE;
+
+    case ICM20948_STATE_MAG_I2C_MST:
+        enableI2CMaster();
+        return asyncWait(ICM20948_STATE_MAG_RESET, 10);
+
+    case ICM20948_STATE_MAG_RESET:
+        writeAK09916Register8(AK09916_CNTL_3, 0x01);
+        return asyncWait(ICM20948_STATE_MAG_DEV_RESET, 100);
+
+    case ICM20948_STATE_MAG_DEV_RESET:
+        resetICM20948();
+        clearDeviceState();
+        return asyncWait(ICM20948_STATE_MAG_WAKEUP, 10);
+
+    case ICM20948_STATE_MAG_WAKEUP:
+        wakeup();
+        writeRegister8(2, ICM20948_ODR_ALIGN_EN, 1); // aligns ODR
+        return asyncWait(ICM20948_STATE_MAG_I2C_MST_2, 10);
+
+    case ICM20948_STATE_MAG_I2C_MST_2:
+        enableI2CMaster();
+        restoreAuxSlaves(); // the reset in MAG_DEV_RESET cleared them
+        return asyncWait(ICM20948_STATE_MAG_WHO_AM_I, 20);
+
+    case ICM20948_STATE_MAG_WHO_AM_I:
+        enableMagDataRead(AK09916_WIA_1, 0x02);
+        return asyncWait(ICM20948_STATE_MAG_CHECK, 10);
+
+    case ICM20948_STATE_MAG_CHECK: {
+        int16_t whoAmI = readRegister16(0, ICM20948_EXT_SLV_SENS_DATA_00);
+        enableMagDataRead(AK09916_STATUS_1, AK09916_DATA_BLOCK_LEN);
+        if (!((whoAmI == AK09916_WHO_AM_I_1) || (whoAmI == AK09916_WHO_AM_I_2))) {
+            asyncState = ICM20948_STATE_IDLE;
+            return ICM20948_ASYNC_ERROR;
+        }
+        return asyncWait(ICM20948_STATE_MAG_OP_MODE, 10);
+    }
+
+    case ICM20948_STATE_MAG_OP_MODE:
+        writeAK09916Register8(AK09916_CNTL_2, asyncOpMode);
+        return asyncWait((asyncOpMode != AK09916_PWR_DOWN) ? ICM20948_STATE_MAG_DATA_READ : ICM20948_STATE_FINISH, 10);
+
+    case ICM20948_STATE_MAG_DATA_READ:
+        enableMagDataRead(AK09916_STATUS_1, AK09916_DATA_BLOCK_LEN);
+        return asyncWait(ICM20948_STATE_FINISH, 10);
+
+    case ICM20948_STATE_MAG_SOFT_RESET:
+        writeAK09916Register8(AK09916_CNTL_3, 0x01);
+        return asyncWait(ICM20948_STATE_FINISH, 100);
+
+    case ICM20948_STATE_MAG_WIA_READ:
+        enableMagDataRead(AK09916_WIA_1, 0x02);
+        return asyncWait(ICM20948_STATE_MAG_WIA_RESULT, 10);
+
+    case ICM20948_STATE_MAG_WIA_RESULT:
+        asyncResult = readRegister16(0, ICM20948_EXT_SLV_SENS_DATA_00);
+        enableMagDataRead(AK09916_STATUS_1, AK09916_DATA_BLOCK_LEN);
+        return asyncWait(ICM20948_STATE_FINISH, 10);
+
+    default:
+        asyncState = ICM20948_STATE_IDLE;
+        return ICM20948_ASYNC_DONE;
+    }
+}
+
+bool ICM20948::isAsyncBusy()
+{
+    return asyncState != ICM20948_STATE_IDLE;
+}
+
+int16_t ICM20948::getAsyncResult()
+{
+    return asyncResult;
+}
+
+uint32_t ICM20948::getAsyncReadyAt()
+{
+    return asyncReadyAt;
+}
+
+///////////////////////////////////////////////
+// Recording
+///////////////////////////////////////////////
+
+void ICM20948::setRecorder(ICM20948_Recorder* rec)
+{
+    recorder = rec;
+    if (recorder) {
+        ICM20948_recConfig config;
+        config.accRangeFactor = accRangeFactor;
+        config.gyrRangeFactor = gyrRangeFactor;
+        config.fifoType = fifoType;
+        config.accOffsetVal = accOffsetVal;
+        config.accCorrFactor = accCorrFactor;
+        config.gyrOffsetVal = gyrOffsetVal;
+        recorder->writeHeader(config);
+    }
+}
+
+///////////////////////////////////////////////
+// Shared bus
+///////////////////////////////////////////////
+
+bool ICM20948::setBusArbiter(ICM20948_BusArbiter* arb, uint8_t priority)
+{
+    /* call before init(); nullptr: exclusive use of the bus */
+    arbiter = nullptr;
+    if (arb) {
+        busClient = arb->addClient(priority);
+        if (busClient == ICM20948_BUS_NO_CLIENT) {
+            return false;
+        }
+        arbiter = arb;
+    }
+    return true;
+}
+
+void ICM20948::beginBusSequence()
+{
+    /* the transactions until endBusSequence() are not interrupted by other clients */
+    if (arbiter) {
+        arbiter->lock(busClient);
+    }
+}
+
+bool ICM20948::requestBusSequence()
+{
+    /* non-blocking beginBusSequence(): if false, the request is queued and the sequence
+     * may start as soon as isBusSequenceGranted() returns true */
+    if (arbiter) {
+        return arbiter->request(busClient);
+    }
+    return true;
+}
+
+bool ICM20948::isBusSequenceGranted()
+{
+    if (arbiter) {
+        return arbiter->isOwner(busClient);
+    }
+    return true;
+}
+
+void ICM20948::endBusSequence()
+{
+    if (arbiter) {
+        arbiter->release(busClient);
+    }
+}
+
+///////////////////////////////////////////////
+// Diagnostics
+///////////////////////////////////////////////
+
+void ICM20948::dumpRegisters(ICM20948_regDump* dump)
+{
+    /* reserved registers within a range are read as well, this saves transactions */
+    uint8_t* data = dump->data;
+    beginBusSequence();
+    dump->time = millis();
+    for (uint8_t i = 0; i < ICM20948_REG_DUMP_RANGES; i++) {
+        uint8_t pos = 0;
+        while (pos < regDumpRanges[i].len) {
+            uint16_t len = regDumpRanges[i].len - pos;
+            if (len > ICM20948_WIRE_BUFFER_SIZE) {
+                len = ICM20948_WIRE_BUFFER_SIZE;
+            }
+            readRegisters(regDumpRanges[i].bank, regDumpRanges[i].first + pos, data + pos, len);
+            pos += len;
+        }
+        data += regDumpRanges[i].len;
+    }
+    endBusSequence();
+}
+
+bool ICM20948::getDumpValue(const ICM20948_regDump* dump, uint8_t bank, uint8_t reg, uint8_t* val)
+{
+    uint8_t offset = 0;
+    for (uint8_t i = 0; i < ICM20948_REG_DUMP_RANGES; i++) {
+        const ICM20948_regDumpRange& r = regDumpRanges[i];
+        if ((r.bank == bank) && (reg >= r.first) && (reg < r.first + r.len)) {
+            *val = dump->data[offset + reg - r.first];
+            return true;
+        }
+        offset += r.len;
+    }
+    return false;
+}
+
+uint8_t ICM20948::diffRegisterDumps(
+    const ICM20948_regDump* expected, const ICM20948_regDump* actual, ICM20948_regDiff* diffs, uint8_t maxDiffs)
+{
+    /* compares the configuration; measured values (data, FIFO count, ...) are skipped.
+     * Returns the number of differences, diffs holds the first maxDiffs of them. */
+    uint8_t n = 0;
+    uint8_t offset = 0;
+    for (uint8_t i = 0; i < ICM20948_REG_DUMP_RANGES; i++) {
+        const ICM20948_regDumpRange& r = regDumpRanges[i];
+        for (uint8_t j = 0; j < r.len; j++) {
+            uint8_t reg = r.first + j;
+            if (isVolatileRegister(r.bank, reg) || (expected->data[offset + j] == actual->data[offset + j])) {
+                continue;
+            }
+            if (n < maxDiffs) {
+                diffs[n].bank = r.bank;
+                diffs[n].reg = reg;
+                diffs[n].expected = expected->data[offset + j];
+                diffs[n].actual = actual->data[offset + j];
+            }
+            if (n < 0xFF) {
+                n++;
+            }
+        }
+        offset += r.len;
+    }
+    return n;
+}
+
+#ifdef ICM20948_ENABLE_STATS
+///////////////////////////////////////////////
+// Statistics
+///////////////////////////////////////////////
+
+ICM20948_stats ICM20948::getStats()
+{
+    return stats;
+}
+
+void ICM20948::resetStats()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+#endif
+
 ///////////////////////////////////////////////
 // Private Functions
 ///////////////////////////////////////////////
@@ -748,121 +1612,352 @@ void ICM20948::setClockToAutoSelect()
 
 xyzFloat ICM20948::correctAccRawValues(xyzFloat accRawVal)
 {
-    accRawVal.x = (accRawVal.x - (accOffsetVal.x / accRangeFactor)) / accCorrFactor.x;
-    accRawVal.y = (accRawVal.y - (accOffsetVal.y / accRangeFactor)) / accCorrFactor.y;
-    accRawVal.z = (accRawVal.z - (accOffsetVal.z / accRangeFactor)) / accCorrFactor.z;
+    return correctAccRawValues(accRawVal, accRangeFactor);
+}
+
+xyzFloat ICM20948::correctAccRawValues(xyzFloat accRawVal, uint8_t rangeFactor)
+{
+    /* offsets are stored for the +/-2 g range and scaled to the range the data was taken at */
+    if (tempCompEnabled) {
+        updateTempBias();
+    }
+    accRawVal.x = (accRawVal.x - ((accOffsetVal.x + accTempBias.x) / rangeFactor)) / accCorrFactor.x;
+    accRawVal.y = (accRawVal.y - ((accOffsetVal.y + accTempBias.y) / rangeFactor)) / accCorrFactor.y;
+    accRawVal.z = (accRawVal.z - ((accOffsetVal.z + accTempBias.z) / rangeFactor)) / accCorrFactor.z;
 
     return accRawVal;
 }
 
 xyzFloat ICM20948::correctGyrRawValues(xyzFloat gyrRawVal)
 {
-    gyrRawVal.x -= (gyrOffsetVal.x / gyrRangeFactor);
-    gyrRawVal.y -= (gyrOffsetVal.y / gyrRangeFactor);
-    gyrRawVal.z -= (gyrOffsetVal.z / gyrRangeFactor);
+    return correctGyrRawValues(gyrRawVal, gyrRangeFactor);
+}
+
+xyzFloat ICM20948::correctGyrRawValues(xyzFloat gyrRawVal, uint8_t rangeFactor)
+{
+    if (tempCompEnabled) {
+        updateTempBias();
+    }
+    gyrRawVal.x -= ((gyrOffsetVal.x + gyrTempBias.x) / rangeFactor);
+    gyrRawVal.y -= ((gyrOffsetVal.y + gyrTempBias.y) / rangeFactor);
+    gyrRawVal.z -= ((gyrOffsetVal.z + gyrTempBias.z) / rangeFactor);
 
     return gyrRawVal;
 }
 
+void ICM20948::applyRangeFactors(uint8_t accFactor, uint8_t gyrFactor)
+{
+    /* for ranges written without setAccRange() / setGyrRange(), e.g. at reset or in init()
+     * of ICM20948T: the data registers and the FIFO hold no data of another range */
+    accRangeFactor = accFactor;
+    gyrRangeFactor = gyrFactor;
+    dataAccRangeFactor = accFactor;
+    dataGyrRangeFactor = gyrFactor;
+    dataRangeChanged = false;
+    fifoAccRangeFactor = accFactor;
+    fifoGyrRangeFactor = gyrFactor;
+    fifoRangeSegCount = 0;
+}
+
+void ICM20948::markFifoRangeChange()
+{
+    /* Called after the range register was written, before the range factor is updated.
+     * The unread FIFO bytes which are not yet assigned to an older range were taken at
+     * the range which is about to be replaced. Without FIFO data, there is nothing to
+     * assign and FIFO_COUNT is not read. */
+    if (!fifoEnabled || !fifoHoldsData) {
+        return;
+    }
+    uint16_t assigned = 0;
+    for (uint8_t i = 0; i < fifoRangeSegCount; i++) {
+        assigned += fifoRangeSegs[i].bytes;
+    }
+    int16_t count = getFifoCount();
+    if (count <= (int16_t)assigned) {
+        return;
+    }
+    if (fifoRangeSegCount == ICM20948_RANGE_SEGMENTS) { // should not happen with hysteresis
+        fifoRangeSegs[ICM20948_RANGE_SEGMENTS - 1].bytes += count - assigned;
+        return;
+    }
+    fifoRangeSegs[fifoRangeSegCount].bytes = count - assigned;
+    fifoRangeSegs[fifoRangeSegCount].accRangeFactor = accRangeFactor;
+    fifoRangeSegs[fifoRangeSegCount].gyrRangeFactor = gyrRangeFactor;
+    fifoRangeSegCount++;
+}
+
+void ICM20948::takeFifoBytes(uint16_t len)
+{
+    /* the data is tagged with the range of its first byte */
+    if (fifoRangeSegCount == 0) {
+        fifoAccRangeFactor = accRangeFactor;
+        fifoGyrRangeFactor = gyrRangeFactor;
+        return;
+    }
+    fifoAccRangeFactor = fifoRangeSegs[0].accRangeFactor;
+    fifoGyrRangeFactor = fifoRangeSegs[0].gyrRangeFactor;
+    while ((len > 0) && (fifoRangeSegCount > 0)) {
+        if (len < fifoRangeSegs[0].bytes) {
+            fifoRangeSegs[0].bytes -= len;
+            return;
+        }
+        len -= fifoRangeSegs[0].bytes;
+        fifoRangeSegCount--;
+        for (uint8_t i = 0; i < fifoRangeSegCount; i++) {
+            fifoRangeSegs[i] = fifoRangeSegs[i + 1];
+        }
+    }
+}
+
+void ICM20948::updateDataRange(const uint8_t* prevData)
+{
+    /* Right after a range switch the data registers may still hold the last sample taken
+     * at the old range. It is identical to the previous read, so it keeps the old range. */
+    if (dataRangeChanged) {
+        if (memcmp(prevData, buffer, 12) == 0) {
+            return;
+        }
+        dataAccRangeFactor = accRangeFactor;
+        dataGyrRangeFactor = gyrRangeFactor;
+        dataRangeChanged = false;
+    }
+    if (autoRangeAcc || autoRangeGyr) {
+        int16_t v[6];
+        for (uint8_t i = 0; i < 6; i++) {
+            v[i] = (int16_t)((buffer[2 * i] << 8) | buffer[2 * i + 1]);
+        }
+        checkAutoRange(rawPeak(v[0], v[1], v[2]), rawPeak(v[3], v[4], v[5]), dataAccRangeFactor, dataGyrRangeFactor, 1);
+    }
+}
+
+void ICM20948::checkAutoRange(uint16_t accPeak, uint16_t gyrPeak, uint8_t accFactor, uint8_t gyrFactor, uint16_t samples)
+{
+    /* Only data taken at the current range is evaluated, a factor of 0 means no data.
+     * Up immediately if the peak is close to full scale, down if it stayed below the lower
+     * limit for autoRangeLowSamples. The lower limit is less than half of the upper limit,
+     * so the doubled values after switching down do not trigger switching up again. */
+    if (autoRangeAcc && (accFactor == accRangeFactor)) {
+        if ((accPeak >= autoRangeUpper) && (accRangeFactor < 8)) {
+            setAccRange((ICM20948_accRange)(rangeIndex(accRangeFactor) + 1));
+        } else if ((accPeak < autoRangeLower) && (accRangeFactor > 1)) {
+            accLowCount += samples;
+            if (accLowCount >= autoRangeLowSamples) {
+                setAccRange((ICM20948_accRange)(rangeIndex(accRangeFactor) - 1));
+            }
+        } else {
+            accLowCount = 0;
+        }
+    }
+    if (autoRangeGyr && (gyrFactor == gyrRangeFactor)) {
+        if ((gyrPeak >= autoRangeUpper) && (gyrRangeFactor < 8)) {
+            setGyrRange((ICM20948_gyroRange)(rangeIndex(gyrRangeFactor) + 1));
+        } else if ((gyrPeak < autoRangeLower) && (gyrRangeFactor > 1)) {
+            gyrLowCount += samples;
+            if (gyrLowCount >= autoRangeLowSamples) {
+                setGyrRange((ICM20948_gyroRange)(rangeIndex(gyrRangeFactor) - 1));
+            }
+        } else {
+            gyrLowCount = 0;
+        }
+    }
+}
+
+void ICM20948::updateTempBias()
+{
+    /* the temperature is taken from the last readSensor() call, also for FIFO data */
+    float temp = getTemperature();
+    if (!tempCompDirty && (fabs(temp - tempCompEvalTemp) < tempCompThreshold)) {
+        return;
+    }
+    tempCompEvalTemp = temp;
+    tempCompDirty = false;
+
+    if (!isTempCompModelValid()) {
+        accTempBias = { 0.0, 0.0, 0.0 };
+        gyrTempBias = { 0.0, 0.0, 0.0 };
+        return;
+    }
+
+    float dTemp = (temp - tempCompRefTemp) / tempCompTempM2;
+    accTempBias.x = accTempCoMoment.x * dTemp;
+    accTempBias.y = accTempCoMoment.y * dTemp;
+    accTempBias.z = accTempCoMoment.z * dTemp;
+    gyrTempBias.x = gyrTempCoMoment.x * dTemp;
+    gyrTempBias.y = gyrTempCoMoment.y * dTemp;
+    gyrTempBias.z = gyrTempCoMoment.z * dTemp;
+}
+
 void ICM20948::switchBank(uint8_t newBank)
 {
     if (newBank != currentBank) {
+        beginBusSequence();
+        ICM20948_STATS_BEGIN();
         currentBank = newBank;
         _wire->beginTransmission(i2cAddress);
         _wire->write(ICM20948_REG_BANK_SEL);
         _wire->write(currentBank << 4);
-        _wire->endTransmission();
+        uint8_t status = _wire->endTransmission();
+        ICM20948_STATS_END(2, 0, 0, status);
+#ifdef ICM20948_ENABLE_STATS
+        stats.bankSwitches++;
+#endif
+        endBusSequence();
     }
 }
 
 void ICM20948::writeRegister8(uint8_t bank, uint8_t reg, uint8_t val)
 {
+    beginBusSequence();
     switchBank(bank);
+    ICM20948_STATS_BEGIN();
 
     _wire->beginTransmission(i2cAddress);
     _wire->write(reg);
     _wire->write(val);
-    _wire->endTransmission();
+    uint8_t status = _wire->endTransmission();
+    ICM20948_STATS_END(2, 0, 0, status);
+    endBusSequence();
 }
 
 void ICM20948::writeRegister16(uint8_t bank, uint8_t reg, int16_t val)
 {
+    beginBusSequence();
     switchBank(bank);
     int8_t MSByte = (int8_t)((val >> 8) & 0xFF);
     uint8_t LSByte = val & 0xFF;
+    ICM20948_STATS_BEGIN();
 
     _wire->beginTransmission(i2cAddress);
     _wire->write(reg);
     _wire->write(MSByte);
     _wire->write(LSByte);
-    _wire->endTransmission();
+    uint8_t status = _wire->endTransmission();
+    ICM20948_STATS_END(3, 0, 0, status);
+    endBusSequence();
 }
 
 uint8_t ICM20948::readRegister8(uint8_t bank, uint8_t reg)
 {
+    beginBusSequence();
     switchBank(bank);
     uint8_t regValue = 0;
+    ICM20948_STATS_BEGIN();
 
     _wire->beginTransmission(i2cAddress);
     _wire->write(reg);
-    _wire->endTransmission(false);
-    _wire->requestFrom(i2cAddress, 1);
+    uint8_t status = _wire->endTransmission(false);
+    uint8_t received = _wire->requestFrom(i2cAddress, 1);
     if (_wire->available()) {
         regValue = _wire->read();
     }
+    ICM20948_STATS_END(1, 1, received, status);
+    endBusSequence();
+    recordRead(bank, reg, &regValue, 1);
 
     return regValue;
 }
 
 int16_t ICM20948::readRegister16(uint8_t bank, uint8_t reg)
 {
+    beginBusSequence();
     switchBank(bank);
     uint8_t MSByte = 0, LSByte = 0;
     int16_t reg16Val = 0;
+    ICM20948_STATS_BEGIN();
 
     _wire->beginTransmission(i2cAddress);
     _wire->write(reg);
-    _wire->endTransmission(false);
-    _wire->requestFrom(i2cAddress, 2);
+    uint8_t status = _wire->endTransmission(false);
+    uint8_t received = _wire->requestFrom(i2cAddress, 2);
     if (_wire->available()) {
         MSByte = _wire->read();
         LSByte = _wire->read();
     }
+    ICM20948_STATS_END(1, 2, received, status);
+    endBusSequence();
+    uint8_t data[2] = { MSByte, LSByte };
+    recordRead(bank, reg, data, 2);
 
     reg16Val = (MSByte << 8) + LSByte;
     return reg16Val;
 }
 
-void ICM20948::readAllData(uint8_t* data)
+void ICM20948::updateMagStatus(bool prevDataReady)
 {
-    switchBank(0);
+    /* The I2C master reads the magnetometer at its own rate. Therefore DRDY may be seen
+     * several times for the same sample, or not at all. A new sample is detected by
+     * changed data or by a new DRDY flag. */
+    magNewData = false;
+    if (slv0Len != AK09916_DATA_BLOCK_LEN) {
+        return; // SLV0 does not read the magnetometer data block
+    }
+    if (memcmp(&buffer[15], lastMagData, 6) != 0) {
+        magNewData = true;
+    } else if ((buffer[14] & AK09916_DRDY) && !prevDataReady) {
+        magNewData = true;
+    }
+    if (magNewData) {
+        memcpy(lastMagData, &buffer[15], 6);
+        magSequence++;
+    }
+}
+
+void ICM20948::readRegisters(uint8_t bank, uint8_t reg, uint8_t* data, uint8_t len)
+{
+    beginBusSequence();
+    switchBank(bank);
+    ICM20948_STATS_BEGIN();
 
     _wire->beginTransmission(i2cAddress);
-    _wire->write(ICM20948_ACCEL_OUT);
-    _wire->endTransmission(false);
-    _wire->requestFrom(i2cAddress, 20);
-    if (_wire->available()) {
-        for (int i = 0; i < 20; i++) {
-            data[i] = _wire->read();
+    _wire->write(reg);
+    uint8_t status = _wire->endTransmission(false);
+    uint8_t received = _wire->requestFrom(i2cAddress, (int)len);
+    for (uint8_t i = 0; i < len; i++) {
+        data[i] = _wire->available() ? _wire->read() : 0;
+    }
+    ICM20948_STATS_END(1, len, received, status);
+    endBusSequence();
+    recordRead(bank, reg, data, len);
+}
+
+void ICM20948::readAllData(uint8_t* data)
+{
+    /* acc, gyr, temp and the external sensor data of all active slaves; in one
+     * transaction if the Wire buffer is large enough */
+    uint8_t pos = 0;
+    beginBusSequence();
+    while (pos < dataBlockLen) {
+        uint16_t len = dataBlockLen - pos;
+        if (len > ICM20948_WIRE_BUFFER_SIZE) {
+            len = ICM20948_WIRE_BUFFER_SIZE;
         }
+        readRegisters(0, ICM20948_ACCEL_OUT + pos, data + pos, len);
+        pos += len;
     }
+    endBusSequence();
 }
 
 xyzFloat ICM20948::readICM20948xyzValFromFifo()
 {
     uint8_t fifoTriple[6];
     xyzFloat xyzResult = { 0.0, 0.0, 0.0 };
+    takeFifoBytes(6);
+    beginBusSequence();
     switchBank(0);
+    ICM20948_STATS_BEGIN();
 
     _wire->beginTransmission(i2cAddress);
     _wire->write(ICM20948_FIFO_R_W);
-    _wire->endTransmission(false);
-    _wire->requestFrom(i2cAddress, 6);
+    uint8_t status = _wire->endTransmission(false);
+    uint8_t received = _wire->requestFrom(i2cAddress, 6);
     if (_wire->available()) {
         for (int i = 0; i < 6; i++) {
             fifoTriple[i] = _wire->read();
         }
     }
+    ICM20948_STATS_END(1, 6, received, status);
+    endBusSequence();
+    recordRead(0, ICM20948_FIFO_R_W, fifoTriple, 6);
 
     xyzResult.x = ((int16_t)((fifoTriple[0] << 8) + fifoTriple[1])) * 1.0;
     xyzResult.y = ((int16_t)((fifoTriple[2] << 8) + fifoTriple[3])) * 1.0;
@@ -871,47 +1966,231 @@ xyzFloat ICM20948::readICM20948xyzValFromFifo()
     return xyzResult;
 }
 
+void ICM20948::readFifoBytes(uint8_t* data, uint16_t len)
+{
+    takeFifoBytes(len);
+
+    /* each chunk is locked on its own, other clients can use the bus in between */
+    while (len > 0) {
+        uint8_t chunk = (len > ICM20948_FIFO_BURST_LEN) ? ICM20948_FIFO_BURST_LEN : len;
+        beginBusSequence();
+        switchBank(0);
+        ICM20948_STATS_BEGIN();
+
+        _wire->beginTransmission(i2cAddress);
+        _wire->write(ICM20948_FIFO_R_W);
+        uint8_t status = _wire->endTransmission(false);
+        uint8_t received = _wire->requestFrom(i2cAddress, (int)chunk);
+        for (int i = 0; i < chunk; i++) {
+            data[i] = _wire->available() ? _wire->read() : 0;
+        }
+        ICM20948_STATS_END(1, chunk, received, status);
+        endBusSequence();
+        recordRead(0, ICM20948_FIFO_R_W, data, chunk);
+
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+void ICM20948::recordRead(uint8_t bank, uint8_t reg, const uint8_t* data, uint8_t len)
+{
+    if (recorder) {
+        recorder->record(bank, reg, data, len);
+    }
+}
+
 void ICM20948::writeAK09916Register8(uint8_t reg, uint8_t val)
 {
+    beginBusSequence();
     writeRegister8(3, ICM20948_I2C_SLV0_ADDR, AK09916_ADDRESS); // write AK09916
     writeRegister8(3, ICM20948_I2C_SLV0_REG, reg); // define AK09916 register to be written to
     writeRegister8(3, ICM20948_I2C_SLV0_DO, val);
+    endBusSequence();
 }
 
-uint8_t ICM20948::readAK09916Register8(uint8_t reg)
+void ICM20948::resetICM20948()
 {
-    enableMagDataRead(reg, 0x01);
-    enableMagDataRead(AK09916_HXL, 0x08);
-    regVal = readRegister8(0, ICM20948_EXT_SLV_SENS_DATA_00);
-    return regVal;
+    writeRegister8(0, ICM20948_PWR_MGMT_1, ICM20948_RESET); // needs 10 ms
 }
 
-int16_t ICM20948::readAK09916Register16(uint8_t reg)
+void ICM20948::initMembers()
 {
-    int16_t regValue = 0;
-    enableMagDataRead(reg, 0x02);
-    regValue = readRegister16(0, ICM20948_EXT_SLV_SENS_DATA_00);
-    enableMagDataRead(AK09916_HXL, 0x08);
-    return regValue;
+    /* everything that is valid before init(): setters may be called first */
+    asyncState = ICM20948_STATE_IDLE;
+    asyncReadyAt = 0;
+    asyncResult = 0;
+    asyncOpMode = AK09916_PWR_DOWN;
+    currentBank = 0;
+    regVal = 0;
+    arbiter = nullptr;
+    busClient = ICM20948_BUS_NO_CLIENT;
+    recorder = nullptr;
+#ifdef ICM20948_ENABLE_STATS
+    resetStats();
+#endif
+    resetSettings();
 }
 
-void ICM20948::resetICM20948()
+void ICM20948::resetSettings()
 {
-    writeRegister8(0, ICM20948_PWR_MGMT_1, ICM20948_RESET);
-    delay(10); // wait for registers to reset
+    /* settings of the library, init() returns to them; pointers set by the user are kept */
+    accOffsetVal.x = 0.0;
+    accOffsetVal.y = 0.0;
+    accOffsetVal.z = 0.0;
+    accCorrFactor.x = 1.0;
+    accCorrFactor.y = 1.0;
+    accCorrFactor.z = 1.0;
+    gyrOffsetVal.x = 0.0;
+    gyrOffsetVal.y = 0.0;
+    gyrOffsetVal.z = 0.0;
+    memset(auxLen, 0, sizeof(auxLen));
+    memset(auxAddr, 0, sizeof(auxAddr));
+    memset(auxReg, 0, sizeof(auxReg));
+    auxDecimated = 0;
+    auxMstDly = 0;
+    clearDeviceState();
+    autoRangeAcc = false;
+    autoRangeGyr = false;
+    setAutoRangeLimits(ICM20948_AUTO_RANGE_UPPER, ICM20948_AUTO_RANGE_LOWER, ICM20948_AUTO_RANGE_LOW_SAMPLES);
+    memset(lastMagData, 0, sizeof(lastMagData));
+    magSequence = 0;
+    tempCompEnabled = false;
+    tempCompRefTemp = 21.0;
+    tempCompThreshold = ICM20948_TEMP_COMP_THRESHOLD;
+    resetTempCompModel();
+    accLowCount = 0;
+    gyrLowCount = 0;
+    tempCompEvalTemp = 0.0;
+}
+
+void ICM20948::clearDeviceState()
+{
+    /* cached settings of the device, at their reset values after resetICM20948(); the
+     * aux slave configuration is kept for restoreAuxSlaves() */
+    applyRangeFactors(1, 1);
+    fifoEnabled = false;
+    fifoRunning = false;
+    fifoHoldsData = false;
+    fifoType = ICM20948_FIFO_ACC;
+    memset(buffer, 0, sizeof(buffer));
+    slv0Len = 0;
+    updateDataBlockLen();
+    magNewData = false;
 }
 
 void ICM20948::enableI2CMaster()
 {
+    beginBusSequence();
     writeRegister8(0, ICM20948_USER_CTRL, ICM20948_I2C_MST_EN); // enable I2C master
+    fifoEnabled = false; // USER_CTRL is overwritten
     writeRegister8(3, ICM20948_I2C_MST_CTRL, 0x07); // set I2C clock to 345.60 kHz
-    delay(10);
+    endBusSequence();
 }
 
 void ICM20948::enableMagDataRead(uint8_t reg, uint8_t bytes)
 {
+    beginBusSequence();
     writeRegister8(3, ICM20948_I2C_SLV0_ADDR, AK09916_ADDRESS | AK09916_READ); // read AK09916
     writeRegister8(3, ICM20948_I2C_SLV0_REG, reg); // define AK09916 register to be read
     writeRegister8(3, ICM20948_I2C_SLV0_CTRL, 0x80 | bytes); // enable read | number of byte
-    delay(10);
+    endBusSequence();
+    slv0Len = bytes;
+    updateDataBlockLen();
+}
+
+void ICM20948::writeAuxSlave(uint8_t slave)
+{
+    uint8_t base = ICM20948_I2C_SLV1_ADDR + (slave - 1) * 4;
+    beginBusSequence();
+    writeRegister8(3, base, auxAddr[slave - 1] | AK09916_READ);
+    writeRegister8(3, base + 1, auxReg[slave - 1]);
+    writeRegister8(3, base + 2, 0x80 | auxLen[slave - 1]); // enable read | number of bytes
+    regVal = readRegister8(3, ICM20948_I2C_MST_DELAY_CTRL);
+    regVal = (regVal & ~(1 << slave)) | (auxDecimated & (1 << slave));
+    writeRegister8(3, ICM20948_I2C_MST_DELAY_CTRL, regVal);
+    endBusSequence();
+}
+
+void ICM20948::restoreAuxSlaves()
+{
+    for (uint8_t slave = 1; slave <= ICM20948_AUX_SLAVES; slave++) {
+        if (auxLen[slave - 1] > 0) {
+            writeAuxSlave(slave);
+        }
+    }
+    if (auxMstDly > 0) {
+        setAuxDecimation(auxMstDly);
+    }
+    updateDataBlockLen();
+}
+
+void ICM20948::updateDataBlockLen()
+{
+    /* the magnetometer data is expected at EXT_SLV_SENS_DATA_00, even if SLV0 is off */
+    uint8_t extLen = slv0Len;
+    for (uint8_t i = 0; i < ICM20948_AUX_SLAVES; i++) {
+        extLen += auxLen[i];
+    }
+    if (extLen < AK09916_DATA_BLOCK_LEN) {
+        extLen = AK09916_DATA_BLOCK_LEN;
+    }
+    dataBlockLen = 14 + extLen;
+}
+
+bool ICM20948::waitForSlv4()
+{
+    uint32_t start = millis();
+    while (!(readRegister8(0, ICM20948_I2C_MST_STATUS) & 0x40)) { // I2C_SLV4_DONE
+        if ((millis() - start) > ICM20948_SLV4_TIMEOUT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ICM20948::startAsync(uint8_t state)
+{
+    if (asyncState != ICM20948_STATE_IDLE) {
+        return false;
+    }
+    asyncState = state;
+    asyncReadyAt = micros();
+    return true;
+}
+
+ICM20948_asyncStatus ICM20948::asyncWait(uint8_t nextState, uint16_t ms)
+{
+    asyncState = nextState;
+    asyncReadyAt = micros() + ms * 1000UL;
+    return ICM20948_ASYNC_BUSY;
+}
+
+ICM20948_asyncStatus ICM20948::finishAsync()
+{
+    ICM20948_asyncStatus status;
+    while ((status = step()) == ICM20948_ASYNC_BUSY) {
+        int32_t wait = asyncReadyAt - micros();
+        if (wait > 0) {
+            delay((wait + 999) / 1000);
+        }
+    }
+    return status;
+}
+
+#ifdef ICM20948_ENABLE_STATS
+void ICM20948::updateStats(uint32_t start, uint8_t written, uint8_t received, bool error)
+{
+    uint32_t latency = micros() - start;
+    stats.transactions++;
+    stats.bytesWritten += written;
+    stats.bytesRead += received;
+    if (error) {
+        stats.errors++;
+    }
+    stats.busyMicros += latency;
+    if (latency > stats.maxLatencyMicros) {
+        stats.maxLatencyMicros = latency;
+    }
 }
+#endif
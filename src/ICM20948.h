@@ -27,6 +27,17 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+/* Uncomment to count I2C transactions, bytes and bus time, see getStats() */
+// #define ICM20948_ENABLE_STATS
+
+#if defined(BUFFER_LENGTH)
+#define ICM20948_WIRE_BUFFER_SIZE BUFFER_LENGTH
+#elif defined(I2C_BUFFER_LENGTH)
+#define ICM20948_WIRE_BUFFER_SIZE I2C_BUFFER_LENGTH
+#else
+#define ICM20948_WIRE_BUFFER_SIZE 32
+#endif
+
 #define ICM20948_ADDRESS 0x69
 #define AK09916_ADDRESS 0x0C
 
@@ -106,6 +117,12 @@
 #define ICM20948_I2C_SLV0_REG 0x04
 #define ICM20948_I2C_SLV0_CTRL 0x05
 #define ICM20948_I2C_SLV0_DO 0x06
+#define ICM20948_I2C_SLV1_ADDR 0x07 // SLV1 ... SLV3: ADDR, REG, CTRL, DO in steps of 4
+#define ICM20948_I2C_SLV4_ADDR 0x13
+#define ICM20948_I2C_SLV4_REG 0x14
+#define ICM20948_I2C_SLV4_CTRL 0x15
+#define ICM20948_I2C_SLV4_DO 0x16
+#define ICM20948_I2C_SLV4_DI 0x17
 
 /* Registers ICM20948 ALL BANKS */
 #define ICM20948_REG_BANK_SEL 0x7F
@@ -139,6 +156,8 @@
 #define ICM20948_INT_ANYRD_2CLEAR 0x10
 #define ICM20948_FSYNC_INT_MODE_EN 0x06
 #define AK09916_16_BIT 0x10
+#define AK09916_DRDY 0x01
+#define AK09916_DOR 0x02
 #define AK09916_OVF 0x08
 #define AK09916_READ 0x80
 
@@ -149,6 +168,24 @@
 #define ICM20948_ROOM_TEMP_OFFSET 0.0f
 #define ICM20948_T_SENSITIVITY 333.87f
 #define AK09916_MAG_LSB 0.1495f
+#define AK09916_DATA_BLOCK_LEN 9 // ST1, HXL ... HZH, TMPS, ST2
+#define ICM20948_BASE_SAMPLE_RATE 1125.0f // output rate [Hz] with DLPF enabled and divider 0
+#define ICM20948_I2C_MST_BASE_RATE 1100.0f // I2C master rate [Hz] for I2C_MST_ODR_CONFIG = 0
+#define ICM20948_FIFO_SIZE 4096 // bytes, found in tests (data sheet: 512)
+#define ICM20948_FIFO_BURST_LEN (ICM20948_WIRE_BUFFER_SIZE / 12 * 12) // complete data sets per read
+#define ICM20948_DATA_BLOCK_LEN (14 + AK09916_DATA_BLOCK_LEN) // acc, gyr, temp, magnetometer
+#define ICM20948_INT_BLOCK_LEN (ICM20948_INT_STATUS_3 - ICM20948_I2C_MST_STATUS + 1)
+#define ICM20948_INT_DATA_BLOCK_LEN (ICM20948_ACCEL_OUT - ICM20948_I2C_MST_STATUS + ICM20948_DATA_BLOCK_LEN)
+#define ICM20948_EXT_SENS_DATA_LEN 24 // EXT_SLV_SENS_DATA_00 ... 23, shared by SLV0 ... SLV3
+#define ICM20948_MAX_DATA_BLOCK_LEN (14 + ICM20948_EXT_SENS_DATA_LEN)
+#define ICM20948_AUX_SLAVES 3 // SLV1 ... SLV3, SLV0 reads the magnetometer
+#define ICM20948_SLV4_TIMEOUT 20 // ms
+#define ICM20948_TEMP_COMP_THRESHOLD 0.1f // default temperature change [°C] until the bias is re-evaluated
+#define ICM20948_TEMP_COMP_MIN_VAR 0.25f // minimum temperature variance [°C²] needed for a valid model
+#define ICM20948_AUTO_RANGE_UPPER 0.9f // default fraction of full scale to switch to the next higher range
+#define ICM20948_AUTO_RANGE_LOWER 0.3f // default fraction of full scale to switch to the next lower range...
+#define ICM20948_AUTO_RANGE_LOW_SAMPLES 100 // ...if not exceeded by this number of consecutive samples
+#define ICM20948_RANGE_SEGMENTS 4 // range switches with FIFO data still pending at the old range
 
 /* Enums */
 
@@ -243,12 +280,81 @@ typedef enum AK09916_OP_MODE {
     AK09916_CONT_MODE_100HZ = 0x08
 } AK09916_opMode;
 
+typedef enum ICM20948_ASYNC_STATUS {
+    ICM20948_ASYNC_DONE,
+    ICM20948_ASYNC_BUSY,
+    ICM20948_ASYNC_ERROR
+} ICM20948_asyncStatus;
+
 struct xyzFloat {
     float x;
     float y;
     float z;
 };
 
+#ifdef ICM20948_ENABLE_STATS
+struct ICM20948_stats {
+    uint32_t transactions;
+    uint32_t bytesWritten; // including register addresses
+    uint32_t bytesRead;
+    uint32_t bankSwitches;
+    uint32_t errors; // NACK or less bytes received than requested
+    uint32_t busyMicros; // cumulative time spent in I2C transactions
+    uint32_t maxLatencyMicros; // longest single transaction
+};
+#endif
+
+class ICM20948_Recorder;
+class ICM20948_BusArbiter;
+
+struct ICM20948_intSnapshot {
+    uint8_t source; // ICM20948_intType bits, as returned by readAndClearInterrupts()
+    uint8_t i2cMstStatus;
+    uint8_t intStatus;
+    uint8_t intStatus1;
+    uint8_t intStatus2;
+    uint8_t intStatus3;
+    bool hasData; // data registers read, the get...Values() functions return the new values
+    int16_t fifoCount; // -1 if not read
+};
+
+/* register ranges read by dumpRegisters(); the clear on read status registers (I2C_MST_STATUS,
+ * INT_STATUS...) and FIFO_R_W are left out */
+#define ICM20948_REG_DUMP_RANGES 10
+#define ICM20948_REG_DUMP_LEN 151
+
+struct ICM20948_regDump {
+    uint32_t time; // millis() of the capture
+    uint8_t data[ICM20948_REG_DUMP_LEN]; // the ranges one after the other, bank 0 ... 3
+};
+
+struct ICM20948_regDiff {
+    uint8_t bank;
+    uint8_t reg;
+    uint8_t expected;
+    uint8_t actual;
+};
+
+struct ICM20948_rangeSegment {
+    uint16_t bytes; // FIFO bytes still pending at these range factors
+    uint8_t accRangeFactor;
+    uint8_t gyrRangeFactor;
+};
+
+struct ICM20948_ratePlan {
+    uint16_t accDiv;
+    uint8_t gyrDiv;
+    ICM20948_dlpf accDlpf;
+    ICM20948_dlpf gyrDlpf;
+    uint8_t i2cMstRateExp;
+    AK09916_opMode magOpMode;
+    float accRate; // achieved output data rates [Hz]
+    float gyrRate;
+    float magRate;
+    float accDelay; // estimated delay of the filter and sampling [ms]
+    float gyrDelay;
+};
+
 class ICM20948 {
 public:
     /* Constructors */
@@ -261,9 +367,12 @@ public:
     /* Basic settings */
 
     bool init();
+    bool initAsync();
     void autoOffsets(uint8_t runs = 200);
     void setAccOffsets(float xMin, float xMax, float yMin, float yMax, float zMin, float zMax);
     void setGyrOffsets(float xOffset, float yOffset, float zOffset);
+    xyzFloat getGyrOffsets();
+    void setGyrHardwareOffsets(float xOffset, float yOffset, float zOffset);
     uint8_t whoAmI();
     void enableAcc();
     void disableAcc();
@@ -277,6 +386,19 @@ public:
     void setGyrSampleRateDivider(uint8_t gyrSplRateDiv);
     void setTempDLPF(ICM20948_dlpf dlpf);
     void setI2CMstSampleRate(uint8_t rateExp);
+    ICM20948_ratePlan planSampleRates(float accRate, float gyrRate, float magRate = 0.0, float maxDelay = 0.0);
+    void applySampleRatePlan(ICM20948_ratePlan plan);
+    ICM20948_ratePlan setSampleRates(float accRate, float gyrRate, float magRate = 0.0, float maxDelay = 0.0);
+
+    /* Automatic range switching */
+
+    void enableAutoRange(bool acc, bool gyr);
+    void disableAutoRange();
+    void setAutoRangeLimits(float upper, float lower, uint16_t lowSamples);
+    uint8_t getAccRangeFactor();
+    uint8_t getGyrRangeFactor();
+    uint8_t getFifoAccRangeFactor();
+    uint8_t getFifoGyrRangeFactor();
 
     /* x,y,z results */
 
@@ -294,6 +416,25 @@ public:
     xyzFloat getGyrValues();
     xyzFloat getGyrValuesFromFifo();
     xyzFloat getMagValues();
+    bool isNewMagData();
+    bool isMagOverflow();
+    bool isMagDataOverrun();
+    uint32_t getMagSequence();
+
+    /* Temperature compensation: linear model per axis (offset change per °C), fitted
+     * from the samples added with addTempCompSample() while the ICM20948 is at rest,
+     * e.g. while the board warms up. Samples are not collected automatically: there is
+     * no rest detection, and the accelerometer slope is only valid if the orientation
+     * does not change. The bias is re-evaluated when the temperature changes by more
+     * than the threshold (setTempCompThreshold()). */
+
+    void enableTempCompensation();
+    void disableTempCompensation();
+    void setTempCompReference(float refTemp);
+    void setTempCompThreshold(float deltaTemp);
+    void addTempCompSample();
+    void resetTempCompModel();
+    bool isTempCompModelValid();
 
     /* Power, Sleep, Standby */
 
@@ -316,6 +457,7 @@ public:
     void enableInterrupt(ICM20948_intType intType);
     void disableInterrupt(ICM20948_intType intType);
     uint8_t readAndClearInterrupts();
+    ICM20948_intSnapshot readInterruptSnapshot(bool withData = false, bool withFifoCount = false);
     bool checkInterrupt(uint8_t source, ICM20948_intType type);
     void setWakeOnMotionThreshold(uint8_t womThresh, ICM20948_womCompEn womCompEn);
 
@@ -330,42 +472,165 @@ public:
     int16_t getFifoCount();
     int16_t getNumberOfFifoDataSets();
     void findFifoBegin();
+    uint16_t readFifoRawDataSets(int16_t* data, uint16_t maxSets);
 
     /* Magnetometer */
 
-    bool initMagnetometer();
+    bool initMagnetometer(); // resets the ICM20948 as well: call it before the other settings
     int16_t whoAmIMag();
     void setMagOpMode(AK09916_opMode opMode);
     void resetMag();
+    bool initMagnetometerAsync();
+    bool setMagOpModeAsync(AK09916_opMode opMode);
+    bool resetMagAsync();
+    bool whoAmIMagAsync(); // result: getAsyncResult()
+
+    /* Auxiliary I2C sensors: SLV1 ... SLV3 share the 24 bytes of EXT_SLV_SENS_DATA with
+     * the magnetometer block (9 bytes, always reserved). The configuration is restored
+     * after the reset in initMagnetometer(). */
+
+    bool setAuxSlave(uint8_t slave, uint8_t addr, uint8_t reg, uint8_t len, bool decimate = false);
+    void disableAuxSlave(uint8_t slave);
+    void setAuxDecimation(uint8_t i2cMstDly);
+    bool getAuxData(uint8_t slave, uint8_t* data);
+    bool writeAuxRegister(uint8_t addr, uint8_t reg, uint8_t val);
+    bool readAuxRegister(uint8_t addr, uint8_t reg, uint8_t* val);
+
+    /* Non-blocking execution of the ...Async() functions. The blocking counterparts
+     * (init(), initMagnetometer(), setMagOpMode(), resetMag(), whoAmIMag()) run the same
+     * sequence to the end. autoOffsets() always blocks (~100 ms + 10 ms per run). */
+
+    ICM20948_asyncStatus step();
+    bool isAsyncBusy();
+    int16_t getAsyncResult();
+    uint32_t getAsyncReadyAt();
+
+    /* Recording */
+
+    void setRecorder(ICM20948_Recorder* rec);
 
-private:
+    /* Shared bus */
+
+    bool setBusArbiter(ICM20948_BusArbiter* arb, uint8_t priority);
+    void beginBusSequence();
+    bool requestBusSequence();
+    bool isBusSequenceGranted();
+    void endBusSequence();
+
+    /* Diagnostics */
+
+    void dumpRegisters(ICM20948_regDump* dump);
+    static bool getDumpValue(const ICM20948_regDump* dump, uint8_t bank, uint8_t reg, uint8_t* val);
+    static uint8_t diffRegisterDumps(
+        const ICM20948_regDump* expected, const ICM20948_regDump* actual, ICM20948_regDiff* diffs, uint8_t maxDiffs);
+
+#ifdef ICM20948_ENABLE_STATS
+    /* Statistics */
+
+    ICM20948_stats getStats();
+    void resetStats();
+#endif
+
+protected:
     TwoWire* _wire;
     int i2cAddress;
     uint8_t currentBank;
-    uint8_t buffer[20];
+    uint8_t buffer[ICM20948_MAX_DATA_BLOCK_LEN];
+    uint8_t dataBlockLen;
+    uint8_t slv0Len;
+    uint8_t auxLen[ICM20948_AUX_SLAVES];
+    uint8_t auxAddr[ICM20948_AUX_SLAVES];
+    uint8_t auxReg[ICM20948_AUX_SLAVES];
+    uint8_t auxDecimated; // bit n: SLVn is decimated (I2C_MST_DELAY_CTRL)
+    uint8_t auxMstDly;
+    uint8_t lastMagData[6];
+    bool magNewData;
+    uint32_t magSequence;
+    uint8_t asyncState;
+    uint32_t asyncReadyAt;
+    int16_t asyncResult; // value read by the last sequence, e.g. whoAmIMagAsync()
+    AK09916_opMode asyncOpMode;
     xyzFloat accOffsetVal;
     xyzFloat accCorrFactor;
     xyzFloat gyrOffsetVal;
-    uint8_t accRangeFactor;
+    uint8_t accRangeFactor; // current setting
     uint8_t gyrRangeFactor;
+    uint8_t dataAccRangeFactor; // range of the data in buffer
+    uint8_t dataGyrRangeFactor;
+    bool dataRangeChanged; // range switched, buffer may still get a sample taken at the old range
+    uint8_t fifoAccRangeFactor; // range of the last data read from the FIFO
+    uint8_t fifoGyrRangeFactor;
+    ICM20948_rangeSegment fifoRangeSegs[ICM20948_RANGE_SEGMENTS];
+    uint8_t fifoRangeSegCount;
+    bool fifoEnabled; // cached FIFO_EN of USER_CTRL
+    bool fifoRunning; // started and not stopped
+    bool fifoHoldsData; // may hold data: started since the last reset
+    bool autoRangeAcc;
+    bool autoRangeGyr;
+    uint16_t autoRangeUpper; // raw values
+    uint16_t autoRangeLower;
+    uint16_t autoRangeLowSamples;
+    uint16_t accLowCount;
+    uint16_t gyrLowCount;
     uint8_t regVal; // intermediate storage of register values
+    ICM20948_Recorder* recorder;
+    ICM20948_BusArbiter* arbiter;
+    uint8_t busClient;
     ICM20948_fifoType fifoType;
+    bool tempCompEnabled;
+    bool tempCompDirty; // model changed, cached bias has to be re-evaluated
+    float tempCompRefTemp; // temperature at which the offsets were determined
+    float tempCompThreshold;
+    float tempCompEvalTemp; // temperature of the cached bias evaluation
+    uint32_t tempCompSamples;
+    float tempCompMeanTemp;
+    float tempCompTempM2;
+    xyzFloat accTempMean;
+    xyzFloat accTempCoMoment;
+    xyzFloat accTempBias;
+    xyzFloat gyrTempMean;
+    xyzFloat gyrTempCoMoment;
+    xyzFloat gyrTempBias;
     void setClockToAutoSelect();
     xyzFloat correctAccRawValues(xyzFloat accRawVal);
+    xyzFloat correctAccRawValues(xyzFloat accRawVal, uint8_t rangeFactor);
     xyzFloat correctGyrRawValues(xyzFloat gyrRawVal);
+    xyzFloat correctGyrRawValues(xyzFloat gyrRawVal, uint8_t rangeFactor);
+    void applyRangeFactors(uint8_t accFactor, uint8_t gyrFactor);
+    void markFifoRangeChange();
+    void takeFifoBytes(uint16_t len);
+    void updateDataRange(const uint8_t* prevData);
+    void checkAutoRange(uint16_t accPeak, uint16_t gyrPeak, uint8_t accFactor, uint8_t gyrFactor, uint16_t samples);
+    void updateTempBias();
     void switchBank(uint8_t newBank);
     void writeRegister8(uint8_t bank, uint8_t reg, uint8_t val);
     void writeRegister16(uint8_t bank, uint8_t reg, int16_t val);
     uint8_t readRegister8(uint8_t bank, uint8_t reg);
     int16_t readRegister16(uint8_t bank, uint8_t reg);
     void readAllData(uint8_t* data);
+    void readRegisters(uint8_t bank, uint8_t reg, uint8_t* data, uint8_t len);
+    void updateMagStatus(bool prevDataReady);
+#ifdef ICM20948_ENABLE_STATS
+    ICM20948_stats stats;
+    void updateStats(uint32_t start, uint8_t written, uint8_t received, bool error);
+#endif
     xyzFloat readICM20948xyzValFromFifo();
+    void readFifoBytes(uint8_t* data, uint16_t len);
+    void recordRead(uint8_t bank, uint8_t reg, const uint8_t* data, uint8_t len);
     void writeAK09916Register8(uint8_t reg, uint8_t val);
-    uint8_t readAK09916Register8(uint8_t reg);
-    int16_t readAK09916Register16(uint8_t reg);
     void resetICM20948();
+    void initMembers();
+    void resetSettings();
+    void clearDeviceState();
     void enableI2CMaster();
     void enableMagDataRead(uint8_t reg, uint8_t bytes);
+    void writeAuxSlave(uint8_t slave);
+    void restoreAuxSlaves();
+    void updateDataBlockLen();
+    bool waitForSlv4();
+    bool startAsync(uint8_t state);
+    ICM20948_asyncStatus asyncWait(uint8_t nextState, uint16_t ms);
+    ICM20948_asyncStatus finishAsync();
 };
 
 #endif
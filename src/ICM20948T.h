@@ -0,0 +1,199 @@
+/******************************************************************************
+ *
+ * Compile time configured variant of the ICM20948 class. Ranges, DLPF levels,
+ * sample rate dividers and the FIFO content are template parameters. Register
+ * values, scale factors and the FIFO data set size are constants, the settings
+ * are written from a precomputed table in init() and the decoding does not
+ * depend on runtime settings: the offsets are scaled once per call, the loop over
+ * the data sets has no branches on settings.
+ *
+ * Example:
+ * ICM20948T<ICM20948_ACC_RANGE_4G, ICM20948_GYRO_RANGE_500, ICM20948_FIFO_ACC_GYR> myIMU;
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948T_H_
+#define ICM20948T_H_
+
+#include "ICM20948.h"
+
+template <ICM20948_accRange ACC_RANGE, ICM20948_gyroRange GYR_RANGE, ICM20948_fifoType FIFO_TYPE = ICM20948_FIFO_ACC_GYR,
+    ICM20948_dlpf ACC_DLPF = ICM20948_DLPF_6, ICM20948_dlpf GYR_DLPF = ICM20948_DLPF_6, uint16_t ACC_DIV = 0,
+    uint8_t GYR_DIV = 0>
+class ICM20948T : public ICM20948 {
+public:
+    static constexpr uint8_t FIFO_SET_SIZE = (FIFO_TYPE == ICM20948_FIFO_ACC_GYR) ? 12 : 6;
+    static constexpr float ACC_SCALE = (1 << ACC_RANGE) / 16384.0f; // g per LSB
+    static constexpr float GYR_SCALE = (1 << GYR_RANGE) * 250.0f / 32768.0f; // degrees/s per LSB
+    static constexpr uint8_t ACCEL_CONFIG_VAL
+        = (ACC_RANGE << 1) | ((ACC_DLPF == ICM20948_DLPF_OFF) ? 0x00 : (0x01 | (ACC_DLPF << 3)));
+    static constexpr uint8_t GYRO_CONFIG_1_VAL
+        = (GYR_RANGE << 1) | ((GYR_DLPF == ICM20948_DLPF_OFF) ? 0x00 : (0x01 | (GYR_DLPF << 3)));
+
+    /* Constructors */
+
+    ICM20948T(int addr)
+        : ICM20948(addr)
+    {
+    }
+    ICM20948T()
+        : ICM20948()
+    {
+    }
+    ICM20948T(TwoWire* w, int addr)
+        : ICM20948(w, addr)
+    {
+    }
+    ICM20948T(TwoWire* w)
+        : ICM20948(w)
+    {
+    }
+
+    /* Basic settings */
+
+    bool init()
+    {
+        if (!ICM20948::init()) {
+            return false;
+        }
+
+        /* bank, register, value - sorted by bank to avoid bank switches */
+        static const uint8_t initTable[][3] = {
+            { 2, ICM20948_GYRO_SMPLRT_DIV, GYR_DIV },
+            { 2, ICM20948_GYRO_CONFIG_1, GYRO_CONFIG_1_VAL },
+            { 2, ICM20948_ACCEL_SMPLRT_DIV_1, (uint8_t)(ACC_DIV >> 8) },
+            { 2, ICM20948_ACCEL_SMPLRT_DIV_2, (uint8_t)(ACC_DIV & 0xFF) },
+            { 2, ICM20948_ACCEL_CONFIG, ACCEL_CONFIG_VAL },
+        };
+        for (uint8_t i = 0; i < sizeof(initTable) / sizeof(initTable[0]); i++) {
+            writeRegister8(initTable[i][0], initTable[i][1], initTable[i][2]);
+        }
+
+        /* keep the runtime members consistent for the functions of the base class */
+        applyRangeFactors(1 << ACC_RANGE, 1 << GYR_RANGE);
+        fifoType = FIFO_TYPE;
+        return true;
+    }
+
+    /* x,y,z results */
+
+    xyzFloat getGValues()
+    {
+        correction c = prepareCorrection();
+        return correctAcc(getAccRawValues(), c);
+    }
+
+    xyzFloat getGyrValues()
+    {
+        correction c = prepareCorrection();
+        return correctGyr(getGyrRawValues(), c);
+    }
+
+    /* FIFO */
+
+    void startFifo()
+    {
+        ICM20948::startFifo(FIFO_TYPE);
+    }
+
+    int16_t getNumberOfFifoDataSets()
+    {
+        return getFifoCount() / FIFO_SET_SIZE;
+    }
+
+    void findFifoBegin()
+    {
+        uint8_t skip[FIFO_SET_SIZE];
+        readFifoBytes(skip, getFifoCount() % FIFO_SET_SIZE);
+    }
+
+    /* Reads up to maxSets data sets in bursts. Depending on FIFO_TYPE, acc or gyr
+     * may be NULL. Returns the number of data sets read. */
+    uint16_t readFifoDataSets(xyzFloat* acc, xyzFloat* gyr, uint16_t maxSets)
+    {
+        const uint8_t setsPerBurst = ICM20948_FIFO_BURST_LEN / FIFO_SET_SIZE;
+        uint8_t data[setsPerBurst * FIFO_SET_SIZE];
+        uint16_t sets = getNumberOfFifoDataSets();
+        if (sets > maxSets) {
+            sets = maxSets;
+        }
+
+        correction c = prepareCorrection();
+        uint16_t done = 0;
+        while (done < sets) {
+            uint8_t n = ((sets - done) > setsPerBurst) ? setsPerBurst : (sets - done);
+            readFifoBytes(data, n * FIFO_SET_SIZE);
+            for (uint8_t i = 0; i < n; i++) {
+                const uint8_t* set = &data[i * FIFO_SET_SIZE];
+                if (FIFO_TYPE != ICM20948_FIFO_GYR) {
+                    acc[done + i] = correctAcc(decode(set), c);
+                }
+                if (FIFO_TYPE != ICM20948_FIFO_ACC) {
+                    gyr[done + i] = correctGyr(decode(set + FIFO_SET_SIZE - 6), c);
+                }
+            }
+            done += n;
+        }
+        return done;
+    }
+
+protected:
+    /* Offsets (incl. temperature bias) at the range of the template and the scale
+     * factors divided by the correction factors. Evaluated once per call, so the
+     * per data set correction is a subtraction and a multiplication. */
+    struct correction {
+        xyzFloat accOffs;
+        xyzFloat accScale;
+        xyzFloat gyrOffs;
+    };
+
+    correction prepareCorrection()
+    {
+        correction c;
+        if (tempCompEnabled) {
+            updateTempBias();
+        }
+        c.accOffs.x = (accOffsetVal.x + accTempBias.x) * (1.0f / (1 << ACC_RANGE));
+        c.accOffs.y = (accOffsetVal.y + accTempBias.y) * (1.0f / (1 << ACC_RANGE));
+        c.accOffs.z = (accOffsetVal.z + accTempBias.z) * (1.0f / (1 << ACC_RANGE));
+        c.accScale.x = ACC_SCALE / accCorrFactor.x;
+        c.accScale.y = ACC_SCALE / accCorrFactor.y;
+        c.accScale.z = ACC_SCALE / accCorrFactor.z;
+        c.gyrOffs.x = (gyrOffsetVal.x + gyrTempBias.x) * (1.0f / (1 << GYR_RANGE));
+        c.gyrOffs.y = (gyrOffsetVal.y + gyrTempBias.y) * (1.0f / (1 << GYR_RANGE));
+        c.gyrOffs.z = (gyrOffsetVal.z + gyrTempBias.z) * (1.0f / (1 << GYR_RANGE));
+        return c;
+    }
+
+    static xyzFloat correctAcc(xyzFloat raw, const correction& c)
+    {
+        raw.x = (raw.x - c.accOffs.x) * c.accScale.x;
+        raw.y = (raw.y - c.accOffs.y) * c.accScale.y;
+        raw.z = (raw.z - c.accOffs.z) * c.accScale.z;
+        return raw;
+    }
+
+    static xyzFloat correctGyr(xyzFloat raw, const correction& c)
+    {
+        raw.x = (raw.x - c.gyrOffs.x) * GYR_SCALE;
+        raw.y = (raw.y - c.gyrOffs.y) * GYR_SCALE;
+        raw.z = (raw.z - c.gyrOffs.z) * GYR_SCALE;
+        return raw;
+    }
+
+    static xyzFloat decode(const uint8_t* d)
+    {
+        xyzFloat raw;
+        raw.x = (int16_t)((d[0] << 8) | d[1]);
+        raw.y = (int16_t)((d[2] << 8) | d[3]);
+        raw.z = (int16_t)((d[4] << 8) | d[5]);
+        return raw;
+    }
+};
+
+#endif
@@ -0,0 +1,197 @@
+/********************************************************************
+ * Streaming Allan deviation for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_AllanVariance.h"
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_AllanVariance::ICM20948_AllanVariance(float sampleRate)
+{
+    rate = sampleRate;
+    reset();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_AllanVariance::reset()
+{
+    samples = 0;
+    hasPending = 0;
+    hasPrev = 0;
+    for (uint8_t k = 0; k < ICM20948_ALLAN_LEVELS; k++) {
+        sqSum[k].x = 0.0;
+        sqSum[k].y = 0.0;
+        sqSum[k].z = 0.0;
+        sqBlock[k] = sqSum[k];
+        diffs[k] = 0;
+    }
+}
+
+///////////////////////////////////////////////
+// Processing
+///////////////////////////////////////////////
+
+void ICM20948_AllanVariance::addSample(xyzFloat val)
+{
+    if (samples == 0) {
+        ref = val;
+    }
+    samples++;
+
+    /* a completed cluster of level k is the difference for level k and half a cluster of level k+1 */
+    xyzFloat avg;
+    avg.x = val.x - ref.x;
+    avg.y = val.y - ref.y;
+    avg.z = val.z - ref.z;
+    for (uint8_t k = 0; k < ICM20948_ALLAN_LEVELS; k++) {
+        uint32_t bit = (uint32_t)1 << k;
+        if (hasPrev & bit) {
+            float dx = avg.x - prev[k].x;
+            float dy = avg.y - prev[k].y;
+            float dz = avg.z - prev[k].z;
+            sqBlock[k].x += dx * dx;
+            sqBlock[k].y += dy * dy;
+            sqBlock[k].z += dz * dz;
+            diffs[k]++;
+            if ((diffs[k] % ICM20948_ALLAN_BLOCK) == 0) {
+                sqSum[k] = getSqSum(k);
+                sqBlock[k].x = 0.0;
+                sqBlock[k].y = 0.0;
+                sqBlock[k].z = 0.0;
+            }
+        }
+        prev[k] = avg;
+        hasPrev |= bit;
+
+        if (!(hasPending & bit)) {
+            pending[k] = avg;
+            hasPending |= bit;
+            return;
+        }
+        hasPending &= ~bit;
+        avg.x = (pending[k].x + avg.x) / 2.0;
+        avg.y = (pending[k].y + avg.y) / 2.0;
+        avg.z = (pending[k].z + avg.z) / 2.0;
+    }
+}
+
+uint32_t ICM20948_AllanVariance::getSamples()
+{
+    return samples;
+}
+
+uint8_t ICM20948_AllanVariance::getLevels()
+{
+    /* number of levels with at least one difference */
+    uint8_t levels = 0;
+    while ((levels < ICM20948_ALLAN_LEVELS) && (diffs[levels] > 0)) {
+        levels++;
+    }
+    return levels;
+}
+
+float ICM20948_AllanVariance::getTau(uint8_t level)
+{
+    return ((uint32_t)1 << level) / rate;
+}
+
+uint32_t ICM20948_AllanVariance::getClusters(uint8_t level)
+{
+    return diffs[level];
+}
+
+xyzFloat ICM20948_AllanVariance::getAdev(uint8_t level)
+{
+    xyzFloat adev = { 0.0, 0.0, 0.0 };
+    if ((level >= ICM20948_ALLAN_LEVELS) || (diffs[level] == 0)) {
+        return adev;
+    }
+    xyzFloat sum = getSqSum(level);
+    adev.x = sqrt(sum.x / (2.0 * diffs[level]));
+    adev.y = sqrt(sum.y / (2.0 * diffs[level]));
+    adev.z = sqrt(sum.z / (2.0 * diffs[level]));
+    return adev;
+}
+
+xyzFloat ICM20948_AllanVariance::getNoiseDensity()
+{
+    xyzFloat density;
+    density.x = estimateNoiseDensity(0);
+    density.y = estimateNoiseDensity(1);
+    density.z = estimateNoiseDensity(2);
+    return density;
+}
+
+xyzFloat ICM20948_AllanVariance::getBiasInstability()
+{
+    xyzFloat bias;
+    bias.x = estimateBiasInstability(0);
+    bias.y = estimateBiasInstability(1);
+    bias.z = estimateBiasInstability(2);
+    return bias;
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+xyzFloat ICM20948_AllanVariance::getSqSum(uint8_t level)
+{
+    xyzFloat sum;
+    sum.x = sqSum[level].x + sqBlock[level].x;
+    sum.y = sqSum[level].y + sqBlock[level].y;
+    sum.z = sqSum[level].z + sqBlock[level].z;
+    return sum;
+}
+
+float ICM20948_AllanVariance::getAxis(const xyzFloat& val, uint8_t axis)
+{
+    return (axis == 0) ? val.x : ((axis == 1) ? val.y : val.z);
+}
+
+float ICM20948_AllanVariance::estimateNoiseDensity(uint8_t axis)
+{
+    /* white noise: ADEV(tau) = N / sqrt(tau); levels with a slope of -1/2 +/- 1/4 to the next level */
+    float sum = 0.0;
+    uint8_t n = 0;
+    float first = 0.0;
+    for (uint8_t k = 0; (k + 1 < ICM20948_ALLAN_LEVELS) && (diffs[k + 1] >= ICM20948_ALLAN_MIN_CLUSTERS); k++) {
+        float adev = getAxis(getAdev(k), axis);
+        float nextAdev = getAxis(getAdev(k + 1), axis);
+        if (k == 0) {
+            first = adev * sqrt(getTau(0));
+        }
+        if ((adev <= 0.0) || (nextAdev <= 0.0)) {
+            continue;
+        }
+        float slope = log(nextAdev / adev) / log(2.0);
+        if ((slope > -0.75) && (slope < -0.25)) {
+            sum += adev * sqrt(getTau(k));
+            n++;
+        }
+    }
+    return (n > 0) ? sum / n : first;
+}
+
+float ICM20948_AllanVariance::estimateBiasInstability(uint8_t axis)
+{
+    float minAdev = 0.0;
+    for (uint8_t k = 0; (k < ICM20948_ALLAN_LEVELS) && (diffs[k] >= ICM20948_ALLAN_MIN_CLUSTERS); k++) {
+        float adev = getAxis(getAdev(k), axis);
+        if ((k == 0) || (adev < minAdev)) {
+            minAdev = adev;
+        }
+    }
+    return minAdev / ICM20948_ALLAN_BIAS_FACTOR;
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * Streaming Allan deviation for the ICM20948 library. The Allan deviation
+ * ADEV(tau) of a sensor at rest shows its noise at different averaging times
+ * tau: white noise falls with slope -1/2 (log-log), bias instability is the
+ * flat minimum, random walk rises again. With it, DLPF and averaging settings
+ * (setAccDLPF(), setGyrAverageInCycleMode(), ...) can be compared by numbers.
+ *
+ * The accumulator processes one xyzFloat stream (e.g. gyroscope values in
+ * degrees/s or g values) sample by sample. Level k averages clusters of 2^k
+ * samples: each level keeps the previous cluster average, a half finished
+ * cluster and the sum of the squared differences of consecutive averages.
+ * So the memory grows with log2 of the duration (ICM20948_ALLAN_LEVELS
+ * levels) and each sample costs O(1) (amortized). The clusters do not
+ * overlap; the host tool extras/host/examples/allan.cpp computes the
+ * overlapping Allan deviation from complete captures.
+ *
+ * getNoiseDensity()      mean of ADEV(tau) * sqrt(tau) in the range where
+ *                        the slope is about -1/2 (white noise), units/sqrt(Hz)
+ * getBiasInstability()   minimum of ADEV / 0.664
+ *
+ * Only levels with at least ICM20948_ALLAN_MIN_CLUSTERS differences are used
+ * for the estimates.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_ALLAN_VARIANCE_H_
+#define ICM20948_ALLAN_VARIANCE_H_
+
+#include "ICM20948.h"
+
+#ifndef ICM20948_ALLAN_LEVELS
+#define ICM20948_ALLAN_LEVELS 20 // 2^19 samples per cluster: ~8 min at 1125 Hz
+#endif
+#define ICM20948_ALLAN_MIN_CLUSTERS 8
+#define ICM20948_ALLAN_BLOCK 256
+#define ICM20948_ALLAN_BIAS_FACTOR 0.664 // ADEV minimum / bias instability for flicker noise
+
+class ICM20948_AllanVariance {
+public:
+    /* Constructors */
+
+    ICM20948_AllanVariance(float sampleRate);
+
+    /* Settings */
+
+    void reset();
+
+    /* Processing */
+
+    void addSample(xyzFloat val);
+    uint32_t getSamples();
+    uint8_t getLevels();
+    float getTau(uint8_t level);
+    uint32_t getClusters(uint8_t level);
+    xyzFloat getAdev(uint8_t level);
+    xyzFloat getNoiseDensity();
+    xyzFloat getBiasInstability();
+
+private:
+    float rate;
+    uint32_t samples;
+    xyzFloat ref; // first sample, the values are shifted for precision
+    xyzFloat pending[ICM20948_ALLAN_LEVELS]; // first half of the next cluster of the level
+    xyzFloat prev[ICM20948_ALLAN_LEVELS]; // last cluster average of the level
+    xyzFloat sqSum[ICM20948_ALLAN_LEVELS];
+    xyzFloat sqBlock[ICM20948_ALLAN_LEVELS]; // last ICM20948_ALLAN_BLOCK differences, keeps the float sums precise
+    uint32_t diffs[ICM20948_ALLAN_LEVELS];
+    uint32_t hasPending; // bit per level
+    uint32_t hasPrev;
+    xyzFloat getSqSum(uint8_t level);
+    float getAxis(const xyzFloat& val, uint8_t axis);
+    float estimateNoiseDensity(uint8_t axis);
+    float estimateBiasInstability(uint8_t axis);
+};
+
+#endif
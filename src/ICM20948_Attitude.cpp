@@ -0,0 +1,210 @@
+/********************************************************************
+ * Orientation and dead reckoning for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_Attitude.h"
+
+#define ICM20948_ATT_NORMALIZE_INTERVAL 16 // samples between quaternion normalizations
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_Attitude::ICM20948_Attitude(float sampleRate)
+{
+    deadReckoning = false;
+    setSampleRate(sampleRate);
+    reset();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_Attitude::setSampleRate(float sampleRate)
+{
+    dt = 1.0 / sampleRate;
+    radPerDegDt = dt * PI / 180.0;
+}
+
+void ICM20948_Attitude::enableDeadReckoning(bool enable)
+{
+    deadReckoning = enable;
+}
+
+void ICM20948_Attitude::reset()
+{
+    q.w = 1.0;
+    q.x = q.y = q.z = 0.0;
+    prevDTheta.x = prevDTheta.y = prevDTheta.z = 0.0;
+    samples = 0;
+    resetVelocityAndPosition();
+}
+
+void ICM20948_Attitude::setOrientation(ICM20948_quaternion newQ)
+{
+    q = newQ;
+}
+
+void ICM20948_Attitude::alignToGravity(xyzFloat gVal)
+{
+    /* roll and pitch from the gravity vector, yaw = 0 */
+    float roll = atan2(gVal.y, gVal.z);
+    float pitch = atan2(-gVal.x, sqrt(gVal.y * gVal.y + gVal.z * gVal.z));
+    float cr = cos(roll / 2.0), sr = sin(roll / 2.0);
+    float cp = cos(pitch / 2.0), sp = sin(pitch / 2.0);
+    q.w = cr * cp;
+    q.x = sr * cp;
+    q.y = cr * sp;
+    q.z = -sr * sp;
+    prevDTheta.x = prevDTheta.y = prevDTheta.z = 0.0;
+}
+
+void ICM20948_Attitude::resetVelocityAndPosition()
+{
+    linAcc.x = linAcc.y = linAcc.z = 0.0;
+    velocity = linAcc;
+    position = linAcc;
+}
+
+///////////////////////////////////////////////
+// Integration
+///////////////////////////////////////////////
+
+void ICM20948_Attitude::addSample(xyzFloat gyr)
+{
+    rotate(gyr);
+}
+
+void ICM20948_Attitude::addSample(xyzFloat gyr, xyzFloat acc)
+{
+    rotate(gyr);
+    if (deadReckoning) {
+        integrateAcc(acc);
+    }
+}
+
+void ICM20948_Attitude::addSamples(const xyzFloat* gyr, const xyzFloat* acc, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        rotate(gyr[i]);
+        if (deadReckoning && acc) {
+            integrateAcc(acc[i]);
+        }
+    }
+}
+
+void ICM20948_Attitude::rotate(xyzFloat gyr)
+{
+    xyzFloat dTheta = { gyr.x * radPerDegDt, gyr.y * radPerDegDt, gyr.z * radPerDegDt };
+
+    /* coning correction with the previous increment */
+    xyzFloat phi;
+    phi.x = dTheta.x + (prevDTheta.y * dTheta.z - prevDTheta.z * dTheta.y) / 12.0;
+    phi.y = dTheta.y + (prevDTheta.z * dTheta.x - prevDTheta.x * dTheta.z) / 12.0;
+    phi.z = dTheta.z + (prevDTheta.x * dTheta.y - prevDTheta.y * dTheta.x) / 12.0;
+    prevDTheta = dTheta;
+
+    /* exponential map: dq = (cos(|phi|/2), sin(|phi|/2) * phi/|phi|) */
+    float angle2 = phi.x * phi.x + phi.y * phi.y + phi.z * phi.z;
+    float dw, s;
+    if (angle2 < 1e-8) {
+        dw = 1.0 - angle2 / 8.0;
+        s = 0.5 - angle2 / 48.0;
+    } else {
+        float angle = sqrt(angle2);
+        dw = cos(angle / 2.0);
+        s = sin(angle / 2.0) / angle;
+    }
+    float dx = s * phi.x, dy = s * phi.y, dz = s * phi.z;
+
+    /* q = q * dq, rotation in the sensor frame */
+    ICM20948_quaternion r;
+    r.w = q.w * dw - q.x * dx - q.y * dy - q.z * dz;
+    r.x = q.w * dx + q.x * dw + q.y * dz - q.z * dy;
+    r.y = q.w * dy - q.x * dz + q.y * dw + q.z * dx;
+    r.z = q.w * dz + q.x * dy - q.y * dx + q.z * dw;
+    q = r;
+
+    samples++;
+    if ((samples % ICM20948_ATT_NORMALIZE_INTERVAL) == 0) {
+        float norm = sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+        q.w /= norm;
+        q.x /= norm;
+        q.y /= norm;
+        q.z /= norm;
+    }
+}
+
+void ICM20948_Attitude::integrateAcc(xyzFloat acc)
+{
+    /* rotate into the world frame: v' = q * v * q^-1 */
+    float tx = 2.0 * (q.y * acc.z - q.z * acc.y);
+    float ty = 2.0 * (q.z * acc.x - q.x * acc.z);
+    float tz = 2.0 * (q.x * acc.y - q.y * acc.x);
+    xyzFloat world;
+    world.x = acc.x + q.w * tx + (q.y * tz - q.z * ty);
+    world.y = acc.y + q.w * ty + (q.z * tx - q.x * tz);
+    world.z = acc.z + q.w * tz + (q.x * ty - q.y * tx);
+
+    linAcc.x = world.x * ICM20948_STANDARD_GRAVITY;
+    linAcc.y = world.y * ICM20948_STANDARD_GRAVITY;
+    linAcc.z = (world.z - 1.0) * ICM20948_STANDARD_GRAVITY;
+
+    position.x += (velocity.x + 0.5 * linAcc.x * dt) * dt;
+    position.y += (velocity.y + 0.5 * linAcc.y * dt) * dt;
+    position.z += (velocity.z + 0.5 * linAcc.z * dt) * dt;
+    velocity.x += linAcc.x * dt;
+    velocity.y += linAcc.y * dt;
+    velocity.z += linAcc.z * dt;
+}
+
+///////////////////////////////////////////////
+// Results
+///////////////////////////////////////////////
+
+ICM20948_quaternion ICM20948_Attitude::getOrientation()
+{
+    return q;
+}
+
+xyzFloat ICM20948_Attitude::getEulerAngles()
+{
+    xyzFloat angles;
+    float sinPitch = 2.0 * (q.w * q.y - q.z * q.x);
+    if (sinPitch > 1.0) {
+        sinPitch = 1.0;
+    } else if (sinPitch < -1.0) {
+        sinPitch = -1.0;
+    }
+    angles.x = atan2(2.0 * (q.w * q.x + q.y * q.z), 1.0 - 2.0 * (q.x * q.x + q.y * q.y)) * 180.0 / PI;
+    angles.y = asin(sinPitch) * 180.0 / PI;
+    angles.z = atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z)) * 180.0 / PI;
+    return angles;
+}
+
+xyzFloat ICM20948_Attitude::getLinearAcceleration()
+{
+    return linAcc;
+}
+
+xyzFloat ICM20948_Attitude::getVelocity()
+{
+    return velocity;
+}
+
+xyzFloat ICM20948_Attitude::getPosition()
+{
+    return position;
+}
+
+uint32_t ICM20948_Attitude::getSampleCount()
+{
+    return samples;
+}
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Orientation by integration of every gyroscope sample, e.g. from the FIFO.
+ * The time step is derived from the output data rate, so no sample is lost
+ * as with integrating getGyrValues() at loop rate.
+ *
+ * Each sample is converted into a rotation vector (angular rate * dt) with a
+ * coning correction based on the previous sample:
+ *     phi = dTheta(k) + 1/12 * dTheta(k-1) x dTheta(k)
+ * and applied as a quaternion (exponential map). Optionally, the acceleration
+ * is rotated into the world frame, gravity is removed and the result is
+ * integrated to velocity and position (dead reckoning). Please note: without
+ * external corrections the position error grows quickly, within seconds.
+ *
+ * World frame: z points up, the start orientation can be aligned to gravity
+ * with alignToGravity(). Gyroscope values in degrees/s, acceleration in g.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_ATTITUDE_H_
+#define ICM20948_ATTITUDE_H_
+
+#include "ICM20948.h"
+
+#define ICM20948_STANDARD_GRAVITY 9.80665f // m/s²
+
+struct ICM20948_quaternion {
+    float w;
+    float x;
+    float y;
+    float z;
+};
+
+class ICM20948_Attitude {
+public:
+    /* Constructors */
+
+    ICM20948_Attitude(float sampleRate);
+
+    /* Settings */
+
+    void setSampleRate(float sampleRate);
+    void enableDeadReckoning(bool enable);
+    void reset();
+    void setOrientation(ICM20948_quaternion q);
+    void alignToGravity(xyzFloat gVal);
+    void resetVelocityAndPosition();
+
+    /* Integration */
+
+    void addSample(xyzFloat gyr);
+    void addSample(xyzFloat gyr, xyzFloat acc);
+    void addSamples(const xyzFloat* gyr, const xyzFloat* acc, uint16_t n);
+
+    /* Results */
+
+    ICM20948_quaternion getOrientation();
+    xyzFloat getEulerAngles(); // roll (x), pitch (y), yaw (z) in degrees
+    xyzFloat getLinearAcceleration(); // m/s², world frame, last sample
+    xyzFloat getVelocity(); // m/s
+    xyzFloat getPosition(); // m
+    uint32_t getSampleCount();
+
+private:
+    float dt;
+    float radPerDegDt;
+    bool deadReckoning;
+    ICM20948_quaternion q;
+    xyzFloat prevDTheta;
+    xyzFloat linAcc;
+    xyzFloat velocity;
+    xyzFloat position;
+    uint32_t samples;
+
+    void rotate(xyzFloat gyr);
+    void integrateAcc(xyzFloat acc);
+};
+
+#endif
@@ -0,0 +1,204 @@
+/********************************************************************
+ * Online gyroscope bias estimator for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_BiasEstimator.h"
+
+#define ICM20948_GYR_LSB_PER_DPS (32768.0 / 250.0)
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_BiasEstimator::ICM20948_BiasEstimator(ICM20948* icm, float sampleRate)
+{
+    _icm = icm;
+    rate = sampleRate;
+    gyrStdDevMax = 0.3; // dps
+    accStdDevMax = 0.005; // g
+    maxRate = 3.0; // dps
+    weight = 0.1;
+    hardware = false;
+    bias.x = 0.0;
+    bias.y = 0.0;
+    bias.z = 0.0;
+    setWindow(1.0);
+    updates = 0;
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_BiasEstimator::begin()
+{
+    /* starts with the current (software) offsets, e.g. from autoOffsets() */
+    bias = _icm->getGyrOffsets();
+    still = false;
+    stillWindows = 0;
+    updates = 0;
+    resetWindow();
+    if (hardware) {
+        applyBias();
+    }
+}
+
+void ICM20948_BiasEstimator::setWindow(float seconds)
+{
+    float len = seconds * rate;
+    windowLen = (len < 2.0) ? 2 : ((len > 65535.0) ? 65535 : (uint16_t)len);
+    resetWindow();
+    stillWindows = 0;
+    still = false;
+}
+
+void ICM20948_BiasEstimator::setStillThresholds(float gyrStdDev, float accStdDev, float maxRateDps)
+{
+    gyrStdDevMax = gyrStdDev;
+    accStdDevMax = accStdDev;
+    maxRate = maxRateDps;
+}
+
+void ICM20948_BiasEstimator::setWeight(float w)
+{
+    weight = w;
+}
+
+void ICM20948_BiasEstimator::enableHardwareOffsets(bool enable)
+{
+    /* enabling takes effect with begin() or the next update */
+    if (hardware && !enable) {
+        _icm->setGyrHardwareOffsets(0.0, 0.0, 0.0);
+        _icm->setGyrOffsets(bias.x, bias.y, bias.z);
+    }
+    hardware = enable;
+}
+
+///////////////////////////////////////////////
+// Processing
+///////////////////////////////////////////////
+
+bool ICM20948_BiasEstimator::addSample(xyzFloat gVal, xyzFloat gyrVal)
+{
+    /* gyrVal: corrected values, e.g. getGyrValues(); returns true if the bias was updated */
+    float acc = sqrt(sq(gVal.x) + sq(gVal.y) + sq(gVal.z));
+    if (n == 0) {
+        gyrRef = gyrVal;
+        accRef = acc;
+    }
+    float dx = gyrVal.x - gyrRef.x;
+    float dy = gyrVal.y - gyrRef.y;
+    float dz = gyrVal.z - gyrRef.z;
+    float da = acc - accRef;
+    gyrSum.x += dx;
+    gyrSum.y += dy;
+    gyrSum.z += dz;
+    gyrSqSum.x += dx * dx;
+    gyrSqSum.y += dy * dy;
+    gyrSqSum.z += dz * dz;
+    accSum += da;
+    accSqSum += da * da;
+    n++;
+
+    if (n < windowLen) {
+        return false;
+    }
+    uint32_t prevUpdates = updates;
+    evaluateWindow();
+    resetWindow();
+    return updates != prevUpdates;
+}
+
+bool ICM20948_BiasEstimator::isStill()
+{
+    return still;
+}
+
+xyzFloat ICM20948_BiasEstimator::getBias()
+{
+    xyzFloat dps;
+    dps.x = bias.x / ICM20948_GYR_LSB_PER_DPS;
+    dps.y = bias.y / ICM20948_GYR_LSB_PER_DPS;
+    dps.z = bias.z / ICM20948_GYR_LSB_PER_DPS;
+    return dps;
+}
+
+uint32_t ICM20948_BiasEstimator::getUpdates()
+{
+    return updates;
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+void ICM20948_BiasEstimator::resetWindow()
+{
+    n = 0;
+    gyrSum.x = 0.0;
+    gyrSum.y = 0.0;
+    gyrSum.z = 0.0;
+    gyrSqSum.x = 0.0;
+    gyrSqSum.y = 0.0;
+    gyrSqSum.z = 0.0;
+    accSum = 0.0;
+    accSqSum = 0.0;
+}
+
+void ICM20948_BiasEstimator::evaluateWindow()
+{
+    xyzFloat mean, var;
+    mean.x = gyrSum.x / n;
+    mean.y = gyrSum.y / n;
+    mean.z = gyrSum.z / n;
+    var.x = gyrSqSum.x / n - sq(mean.x);
+    var.y = gyrSqSum.y / n - sq(mean.y);
+    var.z = gyrSqSum.z / n - sq(mean.z);
+    float accMean = accSum / n;
+    float accVar = accSqSum / n - sq(accMean);
+    mean.x += gyrRef.x;
+    mean.y += gyrRef.y;
+    mean.z += gyrRef.z;
+
+    float gyrVarMax = sq(gyrStdDevMax);
+    still = (var.x < gyrVarMax) && (var.y < gyrVarMax) && (var.z < gyrVarMax) && (accVar < sq(accStdDevMax))
+        && (fabs(mean.x) < maxRate) && (fabs(mean.y) < maxRate) && (fabs(mean.z) < maxRate);
+    if (!still) {
+        stillWindows = 0;
+        return;
+    }
+    if (stillWindows < ICM20948_BIAS_STILL_WINDOWS) {
+        stillWindows++;
+    }
+    if (stillWindows < ICM20948_BIAS_STILL_WINDOWS) {
+        return;
+    }
+
+    /* the values are corrected with the current bias, the mean is what is left */
+    bias.x += weight * mean.x * ICM20948_GYR_LSB_PER_DPS;
+    bias.y += weight * mean.y * ICM20948_GYR_LSB_PER_DPS;
+    bias.z += weight * mean.z * ICM20948_GYR_LSB_PER_DPS;
+    applyBias();
+    updates++;
+}
+
+void ICM20948_BiasEstimator::applyBias()
+{
+    if (!hardware) {
+        _icm->setGyrOffsets(bias.x, bias.y, bias.z);
+        return;
+    }
+    /* hardware offsets have a resolution of 4 raw values, the remainder is corrected in software */
+    xyzFloat hw;
+    hw.x = round(bias.x / 4.0) * 4.0;
+    hw.y = round(bias.y / 4.0) * 4.0;
+    hw.z = round(bias.z / 4.0) * 4.0;
+    _icm->setGyrHardwareOffsets(hw.x, hw.y, hw.z);
+    _icm->setGyrOffsets(bias.x - hw.x, bias.y - hw.y, bias.z - hw.z);
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ * Online gyroscope bias estimator for the ICM20948 library. The gyroscope
+ * offsets determined by autoOffsets() or setGyrOffsets() drift with time and
+ * temperature. The estimator processes the acceleration (g) and gyroscope
+ * (degrees/s) values sample by sample and detects stationary periods: windows
+ * in which the standard deviations of the gyroscope values and of the
+ * resultant g are below the thresholds and the mean rotation rate is small.
+ * After ICM20948_BIAS_STILL_WINDOWS still windows in a row, the mean gyroscope
+ * value of the window is the remaining bias. It is added to the offsets with
+ * an exponential weight:
+ *
+ *   bias = bias + weight * remaining bias
+ *
+ * The offsets are applied with setGyrOffsets() or, with
+ * enableHardwareOffsets(true), in the XG_OFFS_USR registers of the ICM20948
+ * (setGyrHardwareOffsets()), so that FIFO data is corrected as well. The
+ * rounding remainder of the hardware offsets stays in the software offsets.
+ *
+ * Note: a constant rotation (e.g. a turntable) looks like a bias. The maximum
+ * rate setting (setStillThresholds()) limits the bias which is accepted.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_BIAS_ESTIMATOR_H_
+#define ICM20948_BIAS_ESTIMATOR_H_
+
+#include "ICM20948.h"
+
+#define ICM20948_BIAS_STILL_WINDOWS 2 // consecutive still windows needed for an update
+
+class ICM20948_BiasEstimator {
+public:
+    /* Constructors */
+
+    ICM20948_BiasEstimator(ICM20948* icm, float sampleRate);
+
+    /* Settings */
+
+    void begin();
+    void setWindow(float seconds);
+    void setStillThresholds(float gyrStdDev, float accStdDev, float maxRate);
+    void setWeight(float weight);
+    void enableHardwareOffsets(bool enable);
+
+    /* Processing */
+
+    bool addSample(xyzFloat gVal, xyzFloat gyrVal);
+    bool isStill();
+    xyzFloat getBias();
+    uint32_t getUpdates();
+
+private:
+    ICM20948* _icm;
+    float rate;
+    uint16_t windowLen;
+    float gyrStdDevMax;
+    float accStdDevMax;
+    float maxRate;
+    float weight;
+    bool hardware;
+    xyzFloat bias; // raw values at +/-250 dps, like setGyrOffsets()
+    uint16_t n;
+    xyzFloat gyrRef; // first sample of the window, the sums are shifted for precision
+    float accRef;
+    xyzFloat gyrSum;
+    xyzFloat gyrSqSum;
+    float accSum;
+    float accSqSum;
+    uint8_t stillWindows;
+    bool still;
+    uint32_t updates;
+    void resetWindow();
+    void evaluateWindow();
+    void applyBias();
+};
+
+#endif
@@ -0,0 +1,227 @@
+/********************************************************************
+ * Bus arbiter for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_BusArbiter.h"
+
+/* The state is also changed from interrupts. The interrupt state is saved and
+ * restored, so the functions can be called from an ISR as well (on ESP32 with a
+ * spinlock, which also covers the second core). Other architectures fall back to
+ * noInterrupts() / interrupts(), which enables the interrupts at the end, so
+ * there the functions must not be called from an ISR. */
+#if defined(__AVR__)
+#define ICM20948_BUS_CRITICAL_BEGIN() \
+    uint8_t sreg = SREG;              \
+    cli()
+#define ICM20948_BUS_CRITICAL_END() SREG = sreg
+#elif defined(ARDUINO_ARCH_ESP32)
+static portMUX_TYPE icm20948BusMux = portMUX_INITIALIZER_UNLOCKED;
+#define ICM20948_BUS_CRITICAL_BEGIN() portENTER_CRITICAL_SAFE(&icm20948BusMux)
+#define ICM20948_BUS_CRITICAL_END() portEXIT_CRITICAL_SAFE(&icm20948BusMux)
+#elif defined(ARDUINO_ARCH_ESP8266)
+#define ICM20948_BUS_CRITICAL_BEGIN() uint32_t savedPS = xt_rsil(15)
+#define ICM20948_BUS_CRITICAL_END() xt_wsr_ps(savedPS)
+#elif defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'M')
+#define ICM20948_BUS_CRITICAL_BEGIN()                    \
+    uint32_t primask;                                    \
+    __asm__ volatile("mrs %0, primask" : "=r"(primask)); \
+    __asm__ volatile("cpsid i" ::: "memory")
+#define ICM20948_BUS_CRITICAL_END() __asm__ volatile("msr primask, %0" ::"r"(primask) : "memory")
+#else
+#define ICM20948_BUS_CRITICAL_BEGIN() noInterrupts()
+#define ICM20948_BUS_CRITICAL_END() interrupts()
+#endif
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_BusArbiter::ICM20948_BusArbiter()
+{
+    numClients = 0;
+    owner = ICM20948_BUS_NO_CLIENT;
+    depth = 0;
+    nextTicket = 0;
+}
+
+///////////////////////////////////////////////
+// Clients
+///////////////////////////////////////////////
+
+uint8_t ICM20948_BusArbiter::addClient(uint8_t priority, ICM20948_busGrantCallback callback, void* arg)
+{
+    if (numClients >= ICM20948_BUS_MAX_CLIENTS) {
+        return ICM20948_BUS_NO_CLIENT;
+    }
+    Client& c = clients[numClients];
+    c.priority = priority;
+    c.pending = false;
+    c.ticket = 0;
+    c.requestedAt = 0;
+    c.callback = callback;
+    c.arg = arg;
+    c.grants = 0;
+    c.maxLatency = 0;
+    memset(c.hist, 0, sizeof(c.hist));
+    return numClients++;
+}
+
+///////////////////////////////////////////////
+// Locking
+///////////////////////////////////////////////
+
+bool ICM20948_BusArbiter::request(uint8_t client)
+{
+    bool granted = true;
+    ICM20948_BUS_CRITICAL_BEGIN();
+    if (owner == client) {
+        depth++; // nested lock, e.g. a transaction within a sequence
+    } else if (owner == ICM20948_BUS_NO_CLIENT) {
+        clients[client].requestedAt = micros();
+        grant(client);
+    } else {
+        if (!clients[client].pending) {
+            clients[client].pending = true;
+            clients[client].ticket = nextTicket++;
+            clients[client].requestedAt = micros();
+        }
+        granted = false;
+    }
+    ICM20948_BUS_CRITICAL_END();
+    return granted;
+}
+
+void ICM20948_BusArbiter::lock(uint8_t client)
+{
+    if (request(client)) {
+        return;
+    }
+    while (owner != client) {
+        yield();
+    }
+}
+
+void ICM20948_BusArbiter::release(uint8_t client)
+{
+    uint8_t next = ICM20948_BUS_NO_CLIENT;
+    ICM20948_BUS_CRITICAL_BEGIN();
+    if ((owner == client) && (depth > 0)) {
+        depth--;
+        if (depth == 0) {
+            owner = ICM20948_BUS_NO_CLIENT;
+            next = nextPending();
+            if (next != ICM20948_BUS_NO_CLIENT) {
+                grant(next);
+            }
+        }
+    }
+    ICM20948_BUS_CRITICAL_END();
+
+    /* a client waiting in lock() continues by itself, queued requests with callback run here */
+    if ((next != ICM20948_BUS_NO_CLIENT) && clients[next].callback) {
+        clients[next].callback(clients[next].arg);
+        release(next);
+    }
+}
+
+void ICM20948_BusArbiter::cancel(uint8_t client)
+{
+    ICM20948_BUS_CRITICAL_BEGIN();
+    clients[client].pending = false;
+    ICM20948_BUS_CRITICAL_END();
+}
+
+bool ICM20948_BusArbiter::isOwner(uint8_t client)
+{
+    return owner == client;
+}
+
+bool ICM20948_BusArbiter::isHigherPriorityPending(uint8_t client)
+{
+    /* a long sequence of a low priority client can release the bus if this is true */
+    for (uint8_t i = 0; i < numClients; i++) {
+        if (clients[i].pending && (clients[i].priority > clients[client].priority)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////
+// Statistics
+///////////////////////////////////////////////
+
+const uint16_t* ICM20948_BusArbiter::getLatencyHistogram(uint8_t client)
+{
+    return clients[client].hist;
+}
+
+uint32_t ICM20948_BusArbiter::getMaxLatency(uint8_t client)
+{
+    return clients[client].maxLatency;
+}
+
+uint32_t ICM20948_BusArbiter::getGrants(uint8_t client)
+{
+    return clients[client].grants;
+}
+
+void ICM20948_BusArbiter::resetStats()
+{
+    ICM20948_BUS_CRITICAL_BEGIN();
+    for (uint8_t i = 0; i < numClients; i++) {
+        clients[i].grants = 0;
+        clients[i].maxLatency = 0;
+        memset(clients[i].hist, 0, sizeof(clients[i].hist));
+    }
+    ICM20948_BUS_CRITICAL_END();
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+uint8_t ICM20948_BusArbiter::nextPending()
+{
+    /* highest priority first, the oldest ticket within a priority */
+    uint8_t next = ICM20948_BUS_NO_CLIENT;
+    for (uint8_t i = 0; i < numClients; i++) {
+        if (!clients[i].pending) {
+            continue;
+        }
+        if ((next == ICM20948_BUS_NO_CLIENT) || (clients[i].priority > clients[next].priority)
+            || ((clients[i].priority == clients[next].priority)
+                && ((int16_t)(clients[i].ticket - clients[next].ticket) < 0))) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+void ICM20948_BusArbiter::grant(uint8_t client)
+{
+    /* called with interrupts disabled */
+    Client& c = clients[client];
+    owner = client;
+    depth = 1;
+    c.pending = false;
+
+    uint32_t latency = micros() - c.requestedAt;
+    uint8_t bin = 0;
+    while ((bin < ICM20948_BUS_HIST_BINS - 1) && (latency >> (bin + 1))) {
+        bin++;
+    }
+    if (c.hist[bin] < 0xFFFF) {
+        c.hist[bin]++;
+    }
+    if (latency > c.maxLatency) {
+        c.maxLatency = latency;
+    }
+    c.grants++;
+}
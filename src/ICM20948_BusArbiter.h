@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Bus arbiter for an I2C bus which is shared by several drivers, e.g. the
+ * ICM20948 and other sensors on the same TwoWire. Each driver is a client
+ * with a priority. A client locks the bus for one transaction or for a
+ * sequence of transactions (nested locks of the same client are counted).
+ * When the bus is released, it is handed to the waiting client with the
+ * highest priority (first come, first served within a priority). So between
+ * two transactions of a low priority driver, a high priority IMU read gets the
+ * bus first.
+ *
+ * request()    non-blocking: returns true if the bus is granted, otherwise
+ *              the client is queued. If the client has a grant callback, the
+ *              callback is executed with the bus locked as soon as the bus is
+ *              released, and the bus is released after the callback. This is
+ *              the way for interrupt service routines: they must not wait.
+ *              Calls from an ISR are supported on AVR, ARM Cortex-M, ESP32 and
+ *              ESP8266 (the interrupt state is restored).
+ * lock()       waits until the bus is granted. Only useful if the owner runs
+ *              in another context (RTOS task, interrupt), otherwise it blocks
+ *              forever.
+ * release()    releases one lock level.
+ *
+ * With setBusArbiter(), the ICM20948 locks the bus for each transaction
+ * together with the bank switch, and for multi-transaction sequences such as
+ * the magnetometer register access. Then the bank cache stays consistent,
+ * even if other clients use the bus in between. The bus is not locked while
+ * the ICM20948 waits for its I2C master (AK09916 access, 10 ms each).
+ *
+ * The time from request to grant is collected per client in a histogram with
+ * log2 bins: bin i counts latencies of 2^i ... 2^(i+1) - 1 µs (bin 0: 0-1 µs).
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_BUS_ARBITER_H_
+#define ICM20948_BUS_ARBITER_H_
+
+#include <Arduino.h>
+
+#ifndef ICM20948_BUS_MAX_CLIENTS
+#define ICM20948_BUS_MAX_CLIENTS 8
+#endif
+#define ICM20948_BUS_HIST_BINS 16
+#define ICM20948_BUS_NO_CLIENT 0xFF
+
+typedef void (*ICM20948_busGrantCallback)(void* arg);
+
+class ICM20948_BusArbiter {
+public:
+    /* Constructors */
+
+    ICM20948_BusArbiter();
+
+    /* Clients */
+
+    uint8_t addClient(uint8_t priority, ICM20948_busGrantCallback callback = nullptr, void* arg = nullptr);
+
+    /* Locking */
+
+    bool request(uint8_t client);
+    void lock(uint8_t client);
+    void release(uint8_t client);
+    void cancel(uint8_t client);
+    bool isOwner(uint8_t client);
+    bool isHigherPriorityPending(uint8_t client);
+
+    /* Statistics */
+
+    const uint16_t* getLatencyHistogram(uint8_t client);
+    uint32_t getMaxLatency(uint8_t client);
+    uint32_t getGrants(uint8_t client);
+    void resetStats();
+
+private:
+    struct Client {
+        uint8_t priority; // higher value, higher priority
+        volatile bool pending;
+        uint16_t ticket; // order of the requests within a priority
+        uint32_t requestedAt;
+        ICM20948_busGrantCallback callback;
+        void* arg;
+        uint32_t grants;
+        uint32_t maxLatency;
+        uint16_t hist[ICM20948_BUS_HIST_BINS];
+    };
+    Client clients[ICM20948_BUS_MAX_CLIENTS];
+    uint8_t numClients;
+    volatile uint8_t owner;
+    uint8_t depth; // only changed within critical sections
+    uint16_t nextTicket;
+    uint8_t nextPending();
+    void grant(uint8_t client);
+};
+
+#endif
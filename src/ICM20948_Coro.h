@@ -0,0 +1,274 @@
+/******************************************************************************
+ *
+ * C++20 coroutine interface for the ICM20948 library. The functions below are
+ * coroutines which can be awaited with co_await. Instead of delay() they
+ * suspend and let other coroutines run on the same thread, e.g. to serve
+ * several ICM20948 at the same time:
+ *
+ * icm20948Init(imu, ex)                 init() based on initAsync() / step()
+ * icm20948InitMagnetometer(imu, ex)     initMagnetometer()
+ * icm20948SetMagOpMode(imu, ex, mode)   setMagOpMode()
+ * icm20948ReadSensor(imu, ex, at)       readSensor() at micros() = at
+ * icm20948DrainFifo(imu, ex, data, valuesPerSet, maxSets, chunkSets)
+ *                                       readFifoRawDataSets() in chunks, other
+ *                                       coroutines can run between the chunks
+ * icm20948LockBus(imu, ex)              beginBusSequence() without blocking
+ * icm20948SleepUntil(ex, at)            suspend until micros() = at
+ * icm20948Yield(ex)                     let the other coroutines run
+ *
+ * The application provides the executor: a class derived from
+ * ICM20948_Executor which resumes the handle passed to schedule() at or after
+ * the given time (micros()). A simple executor keeps a list of the suspended
+ * handles and resumes the ones which are due in its main loop.
+ *
+ * Shared bus (setBusArbiter()): the register accesses of the ICM20948 wait
+ * with lock() if another client owns the bus. On a single thread, this waits
+ * forever if the owner is a suspended coroutine. Therefore the coroutines
+ * above acquire the bus with request() and suspend until it is granted
+ * (icm20948LockBus()) and never keep it across a suspension. Own coroutines
+ * which use beginBusSequence() or other clients of the arbiter must follow
+ * the same rule.
+ *
+ * The header is empty if the compiler does not support coroutines (C++20 and
+ * <coroutine> required), so it can be included unconditionally.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_CORO_H_
+#define ICM20948_CORO_H_
+
+#if defined(__has_include)
+#if (__cplusplus >= 202002L) && __has_include(<coroutine>)
+#define ICM20948_HAS_COROUTINES
+#endif
+#endif
+
+#ifdef ICM20948_HAS_COROUTINES
+
+#include "ICM20948.h"
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+
+class ICM20948_Executor {
+public:
+    virtual ~ICM20948_Executor() { }
+    virtual void schedule(std::coroutine_handle<> handle, uint32_t wakeAt) = 0;
+};
+
+/* Awaitable which suspends until micros() reaches wakeAt */
+class ICM20948_SleepUntil {
+public:
+    ICM20948_SleepUntil(ICM20948_Executor& ex, uint32_t wakeAt)
+        : _ex(ex)
+        , _wakeAt(wakeAt)
+    {
+    }
+    bool await_ready() { return (int32_t)(micros() - _wakeAt) >= 0; }
+    void await_suspend(std::coroutine_handle<> handle) { _ex.schedule(handle, _wakeAt); }
+    void await_resume() { }
+
+private:
+    ICM20948_Executor& _ex;
+    uint32_t _wakeAt;
+};
+
+/* Awaitable which always suspends, so that other coroutines can run */
+class ICM20948_Yield {
+public:
+    explicit ICM20948_Yield(ICM20948_Executor& ex)
+        : _ex(ex)
+    {
+    }
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { _ex.schedule(handle, micros()); }
+    void await_resume() { }
+
+private:
+    ICM20948_Executor& _ex;
+};
+
+/* Return type of the coroutines. A task starts when it is awaited (or when start()
+ * is called for a top level task) and resumes the awaiting coroutine when done. */
+template <typename T>
+class ICM20948_Task;
+
+template <typename T>
+struct ICM20948_TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept { }
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { std::terminate(); }
+};
+
+template <typename T>
+struct ICM20948_TaskPromise : ICM20948_TaskPromiseBase<T> {
+    T value;
+    ICM20948_Task<T> get_return_object();
+    void return_value(T v) { value = v; }
+};
+
+template <>
+struct ICM20948_TaskPromise<void> : ICM20948_TaskPromiseBase<void> {
+    ICM20948_Task<void> get_return_object();
+    void return_void() { }
+};
+
+template <typename T>
+class ICM20948_Task {
+public:
+    typedef ICM20948_TaskPromise<T> promise_type;
+
+    explicit ICM20948_Task(std::coroutine_handle<promise_type> handle)
+        : _handle(handle)
+    {
+    }
+    ICM20948_Task(ICM20948_Task&& other) noexcept
+        : _handle(other._handle)
+    {
+        other._handle = nullptr;
+    }
+    ICM20948_Task(const ICM20948_Task&) = delete;
+    ICM20948_Task& operator=(const ICM20948_Task&) = delete;
+    ~ICM20948_Task()
+    {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool await_ready() { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+    {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+    T await_resume() { return result(); }
+
+    /* top level task: runs until the first suspension, the executor does the rest */
+    void start() { _handle.resume(); }
+    bool isDone() { return _handle.done(); }
+    T result()
+    {
+        if constexpr (!std::is_void<T>::value) {
+            return _handle.promise().value;
+        }
+    }
+
+private:
+    std::coroutine_handle<promise_type> _handle;
+};
+
+template <typename T>
+inline ICM20948_Task<T> ICM20948_TaskPromise<T>::get_return_object()
+{
+    return ICM20948_Task<T>(std::coroutine_handle<ICM20948_TaskPromise<T>>::from_promise(*this));
+}
+
+inline ICM20948_Task<void> ICM20948_TaskPromise<void>::get_return_object()
+{
+    return ICM20948_Task<void>(std::coroutine_handle<ICM20948_TaskPromise<void>>::from_promise(*this));
+}
+
+inline ICM20948_SleepUntil icm20948SleepUntil(ICM20948_Executor& ex, uint32_t wakeAt)
+{
+    return ICM20948_SleepUntil(ex, wakeAt);
+}
+
+inline ICM20948_Yield icm20948Yield(ICM20948_Executor& ex)
+{
+    return ICM20948_Yield(ex);
+}
+
+/* locks the bus like beginBusSequence(), but suspends instead of waiting in lock();
+ * release with endBusSequence() before the next suspension */
+inline ICM20948_Task<void> icm20948LockBus(ICM20948& imu, ICM20948_Executor& ex)
+{
+    if (imu.requestBusSequence()) {
+        co_return;
+    }
+    while (!imu.isBusSequenceGranted()) {
+        co_await ICM20948_Yield(ex);
+    }
+}
+
+/* runs an ...Async() sequence which was started successfully, each step locks the bus */
+inline ICM20948_Task<bool> icm20948RunAsync(ICM20948& imu, ICM20948_Executor& ex, bool started)
+{
+    if (!started) {
+        co_return false;
+    }
+    ICM20948_asyncStatus status;
+    while (true) {
+        co_await icm20948LockBus(imu, ex);
+        status = imu.step();
+        imu.endBusSequence();
+        if (status != ICM20948_ASYNC_BUSY) {
+            break;
+        }
+        co_await ICM20948_SleepUntil(ex, imu.getAsyncReadyAt());
+    }
+    co_return status == ICM20948_ASYNC_DONE;
+}
+
+inline ICM20948_Task<bool> icm20948Init(ICM20948& imu, ICM20948_Executor& ex)
+{
+    co_return co_await icm20948RunAsync(imu, ex, imu.initAsync());
+}
+
+inline ICM20948_Task<bool> icm20948InitMagnetometer(ICM20948& imu, ICM20948_Executor& ex)
+{
+    co_return co_await icm20948RunAsync(imu, ex, imu.initMagnetometerAsync());
+}
+
+inline ICM20948_Task<bool> icm20948SetMagOpMode(ICM20948& imu, ICM20948_Executor& ex, AK09916_opMode opMode)
+{
+    co_return co_await icm20948RunAsync(imu, ex, imu.setMagOpModeAsync(opMode));
+}
+
+inline ICM20948_Task<void> icm20948ReadSensor(ICM20948& imu, ICM20948_Executor& ex, uint32_t at)
+{
+    co_await ICM20948_SleepUntil(ex, at);
+    co_await icm20948LockBus(imu, ex);
+    imu.readSensor();
+    imu.endBusSequence();
+}
+
+inline ICM20948_Task<uint16_t> icm20948DrainFifo(ICM20948& imu, ICM20948_Executor& ex, int16_t* data,
+    uint8_t valuesPerSet, uint16_t maxSets, uint16_t chunkSets)
+{
+    /* valuesPerSet: 6 for ICM20948_FIFO_ACC_GYR, otherwise 3, see readFifoRawDataSets() */
+    uint16_t done = 0;
+    while (done < maxSets) {
+        uint16_t n = ((maxSets - done) < chunkSets) ? (maxSets - done) : chunkSets;
+        co_await icm20948LockBus(imu, ex);
+        uint16_t sets = imu.readFifoRawDataSets(data + done * valuesPerSet, n);
+        imu.endBusSequence();
+        done += sets;
+        if (sets < n) {
+            break;
+        }
+        co_await ICM20948_Yield(ex);
+    }
+    co_return done;
+}
+
+#endif // ICM20948_HAS_COROUTINES
+
+#endif
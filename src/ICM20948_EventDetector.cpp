@@ -0,0 +1,321 @@
+/********************************************************************
+ * Motion event detector for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_EventDetector.h"
+
+#define ICM20948_EVT_STEP_CUTOFF 4.0 // Hz, smoothing of the resultant g for step detection
+#define ICM20948_EVT_MEAN_CUTOFF 0.2 // Hz, slow mean (gravity)
+#define ICM20948_EVT_STEP_QUIET 500 // ms without step detection after taps and falls
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_EventDetector::ICM20948_EventDetector(ICM20948* icm, float sampleRate)
+{
+    _icm = icm;
+    stepMinThreshold = 0.05;
+    stepMinInterval = 250;
+    tapThreshold = 1.0;
+    tapMaxDuration = 60;
+    doubleTapWindow = 400;
+    freeFallThreshold = 0.3;
+    freeFallMinDuration = 100;
+    movingThreshold = 0.03;
+    runningThreshold = 0.4;
+    setSampleRate(sampleRate);
+    reset();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_EventDetector::setSampleRate(float sampleRate)
+{
+    msPerSample = 1000.0 / sampleRate;
+    smoothAlpha = 1.0 - exp(-2.0 * PI * ICM20948_EVT_STEP_CUTOFF / sampleRate);
+    meanAlpha = 1.0 - exp(-2.0 * PI * ICM20948_EVT_MEAN_CUTOFF / sampleRate);
+}
+
+void ICM20948_EventDetector::setStepParameters(float minThreshold, uint16_t minIntervalMs)
+{
+    stepMinThreshold = minThreshold;
+    stepMinInterval = minIntervalMs;
+}
+
+void ICM20948_EventDetector::setTapParameters(float threshold, uint16_t maxDurationMs, uint16_t doubleTapWindowMs)
+{
+    tapThreshold = threshold;
+    tapMaxDuration = maxDurationMs;
+    doubleTapWindow = doubleTapWindowMs;
+}
+
+void ICM20948_EventDetector::setFreeFallParameters(float threshold, uint16_t minDurationMs)
+{
+    freeFallThreshold = threshold;
+    freeFallMinDuration = minDurationMs;
+}
+
+void ICM20948_EventDetector::setActivityThresholds(float moving, float running)
+{
+    movingThreshold = moving;
+    runningThreshold = running;
+}
+
+void ICM20948_EventDetector::reset()
+{
+    msFraction = 0.0;
+    now = 0;
+    filterInit = false;
+    smoothG = 1.0;
+    meanG = 1.0;
+
+    stepPeakAvg = 2.0 * stepMinThreshold;
+    lastSignal = 0.0;
+    rising = false;
+    stepArmed = true;
+    lastStepTime = 0;
+    quietUntil = 0;
+    steps = 0;
+
+    inSpike = false;
+    spikeStart = 0;
+    spikePeak = 0.0;
+    tapPending = false;
+    tapTime = 0;
+    tapValue = 0;
+
+    inFreeFall = false;
+    freeFallReported = false;
+    freeFallStart = 0;
+    freeFallMin = 1.0;
+
+    activityStart = 0;
+    activityN = 0;
+    activitySum = 0.0;
+    activitySumSq = 0.0;
+    activity = ICM20948_ACT_STILL;
+
+    head = 0;
+    count = 0;
+    lostEvents = 0;
+}
+
+///////////////////////////////////////////////
+// Processing
+///////////////////////////////////////////////
+
+void ICM20948_EventDetector::addSample(xyzFloat gVal)
+{
+    float resultant = _icm->getResultantG(gVal);
+
+    msFraction += msPerSample;
+    uint16_t wholeMs = (uint16_t)msFraction;
+    now += wholeMs;
+    msFraction -= wholeMs;
+
+    if (!filterInit) {
+        smoothG = resultant;
+        meanG = resultant;
+        filterInit = true;
+    }
+    smoothG += smoothAlpha * (resultant - smoothG);
+    meanG += meanAlpha * (resultant - meanG);
+
+    detectTap(fabs(resultant - meanG));
+    detectFreeFall(resultant);
+    detectStep(smoothG - meanG);
+    detectActivity(resultant);
+}
+
+void ICM20948_EventDetector::addSamples(const xyzFloat* gVal, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        addSample(gVal[i]);
+    }
+}
+
+void ICM20948_EventDetector::detectStep(float signal)
+{
+    /* threshold follows the mean step peak; a valley below -threshold/2
+     * is required between two steps */
+    float threshold = 0.5 * stepPeakAvg;
+    if (threshold < stepMinThreshold) {
+        threshold = stepMinThreshold;
+    }
+    if (inSpike || inFreeFall || ((int32_t)(quietUntil - now) > 0)) {
+        lastSignal = signal; // taps and falls are no steps
+        rising = false;
+        return;
+    }
+    if (signal < -0.5 * threshold) {
+        stepArmed = true;
+    }
+
+    if (signal > lastSignal) {
+        rising = true;
+    } else if (rising) {
+        rising = false; // lastSignal was a local maximum
+        if (stepArmed && (lastSignal > threshold) && ((now - lastStepTime) >= stepMinInterval)) {
+            steps++;
+            lastStepTime = now;
+            stepArmed = false;
+            stepPeakAvg += 0.25 * (lastSignal - stepPeakAvg);
+            pushEvent(now, ICM20948_EVT_STEP, (uint16_t)steps);
+        }
+    }
+    lastSignal = signal;
+
+    if ((now - lastStepTime) > 2000) {
+        stepPeakAvg = 2.0 * stepMinThreshold; // walking stopped, start again with the minimum
+    }
+}
+
+void ICM20948_EventDetector::detectTap(float deviation)
+{
+    if (tapPending && ((now - tapTime) > doubleTapWindow)) {
+        tapPending = false;
+        pushEvent(tapTime, ICM20948_EVT_TAP, tapValue);
+    }
+
+    if (!inSpike) {
+        if (deviation > tapThreshold) {
+            inSpike = true;
+            spikeStart = now;
+            spikePeak = deviation;
+        }
+        return;
+    }
+
+    if (deviation > spikePeak) {
+        spikePeak = deviation;
+    }
+    if (deviation > 0.5 * tapThreshold) {
+        return;
+    }
+
+    inSpike = false;
+    quietUntil = now + ICM20948_EVT_STEP_QUIET;
+    if ((now - spikeStart) > tapMaxDuration) {
+        return; // too long for a tap
+    }
+    uint16_t value = (uint16_t)(spikePeak * 1000.0);
+    if (tapPending) {
+        tapPending = false;
+        pushEvent(spikeStart, ICM20948_EVT_DOUBLE_TAP, (value > tapValue) ? value : tapValue);
+    } else {
+        tapPending = true;
+        tapTime = spikeStart;
+        tapValue = value;
+    }
+}
+
+void ICM20948_EventDetector::detectFreeFall(float resultant)
+{
+    if (resultant >= freeFallThreshold) {
+        if (inFreeFall) {
+            inFreeFall = false;
+            quietUntil = now + ICM20948_EVT_STEP_QUIET;
+        }
+        return;
+    }
+    if (!inFreeFall) {
+        inFreeFall = true;
+        freeFallReported = false;
+        freeFallStart = now;
+        freeFallMin = resultant;
+    }
+    if (resultant < freeFallMin) {
+        freeFallMin = resultant;
+    }
+    if (!freeFallReported && ((now - freeFallStart) >= freeFallMinDuration)) {
+        freeFallReported = true;
+        pushEvent(freeFallStart, ICM20948_EVT_FREE_FALL, (uint16_t)(freeFallMin * 1000.0));
+    }
+}
+
+void ICM20948_EventDetector::detectActivity(float resultant)
+{
+    float diff = resultant - 1.0; // reduces the cancellation in the variance
+    activitySum += diff;
+    activitySumSq += diff * diff;
+    activityN++;
+    if ((now - activityStart) < 1000) {
+        return;
+    }
+
+    float mean = activitySum / activityN;
+    float var = activitySumSq / activityN - mean * mean;
+    float stdDev = (var > 0.0) ? sqrt(var) : 0.0;
+    ICM20948_activity level = ICM20948_ACT_STILL;
+    if (stdDev > runningThreshold) {
+        level = ICM20948_ACT_RUNNING;
+    } else if (stdDev > movingThreshold) {
+        level = ICM20948_ACT_MOVING;
+    }
+    if (level != activity) {
+        activity = level;
+        pushEvent(now, ICM20948_EVT_ACTIVITY, level);
+    }
+
+    activityStart = now;
+    activityN = 0;
+    activitySum = 0.0;
+    activitySumSq = 0.0;
+}
+
+///////////////////////////////////////////////
+// Events
+///////////////////////////////////////////////
+
+uint8_t ICM20948_EventDetector::available()
+{
+    return count;
+}
+
+bool ICM20948_EventDetector::getEvent(ICM20948_event* evt)
+{
+    if (count == 0) {
+        return false;
+    }
+    *evt = queue[head];
+    head = (head + 1) % ICM20948_EVT_QUEUE_LEN;
+    count--;
+    return true;
+}
+
+uint32_t ICM20948_EventDetector::getStepCount()
+{
+    return steps;
+}
+
+ICM20948_activity ICM20948_EventDetector::getActivity()
+{
+    return activity;
+}
+
+uint32_t ICM20948_EventDetector::getLostEvents()
+{
+    return lostEvents;
+}
+
+void ICM20948_EventDetector::pushEvent(uint32_t time, ICM20948_eventType type, uint16_t value)
+{
+    if (count == ICM20948_EVT_QUEUE_LEN) {
+        lostEvents++;
+        return;
+    }
+    ICM20948_event& evt = queue[(head + count) % ICM20948_EVT_QUEUE_LEN];
+    evt.time = time;
+    evt.type = type;
+    evt.value = value;
+    count++;
+}
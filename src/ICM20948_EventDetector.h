@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ * Motion event detector for the ICM20948 library. It processes acceleration
+ * values (g), e.g. decoded FIFO batches, sample by sample and reports compact
+ * events instead of raw data:
+ *
+ * ICM20948_EVT_STEP        peak of the resultant g with adaptive threshold,
+ *                          value = number of steps (lower 16 bits)
+ * ICM20948_EVT_TAP         short spike, reported when no second tap followed,
+ *                          value = peak deviation from the mean in mg
+ * ICM20948_EVT_DOUBLE_TAP  two taps within the double tap window, value as TAP
+ * ICM20948_EVT_FREE_FALL   resultant g below the threshold for the minimum
+ *                          duration, value = minimum resultant g in mg
+ * ICM20948_EVT_ACTIVITY    change of the activity level (standard deviation of
+ *                          the resultant g per second), value = ICM20948_activity
+ *
+ * The time of an event is in milliseconds, counted from begin() / reset()
+ * using the sample rate. The processing needs constant time and memory per
+ * sample, events are stored in a small ring buffer.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_EVENT_DETECTOR_H_
+#define ICM20948_EVENT_DETECTOR_H_
+
+#include "ICM20948.h"
+
+#ifndef ICM20948_EVT_QUEUE_LEN
+#define ICM20948_EVT_QUEUE_LEN 16
+#endif
+
+typedef enum ICM20948_EVENT_TYPE {
+    ICM20948_EVT_STEP,
+    ICM20948_EVT_TAP,
+    ICM20948_EVT_DOUBLE_TAP,
+    ICM20948_EVT_FREE_FALL,
+    ICM20948_EVT_ACTIVITY
+} ICM20948_eventType;
+
+typedef enum ICM20948_ACTIVITY {
+    ICM20948_ACT_STILL,
+    ICM20948_ACT_MOVING,
+    ICM20948_ACT_RUNNING
+} ICM20948_activity;
+
+struct ICM20948_event {
+    uint32_t time; // ms
+    uint8_t type; // ICM20948_eventType
+    uint16_t value;
+};
+
+class ICM20948_EventDetector {
+public:
+    /* Constructors */
+
+    ICM20948_EventDetector(ICM20948* icm, float sampleRate);
+
+    /* Settings */
+
+    void setSampleRate(float sampleRate);
+    void setStepParameters(float minThreshold, uint16_t minIntervalMs);
+    void setTapParameters(float threshold, uint16_t maxDurationMs, uint16_t doubleTapWindowMs);
+    void setFreeFallParameters(float threshold, uint16_t minDurationMs);
+    void setActivityThresholds(float moving, float running);
+    void reset();
+
+    /* Processing */
+
+    void addSample(xyzFloat gVal);
+    void addSamples(const xyzFloat* gVal, uint16_t n);
+
+    /* Events */
+
+    uint8_t available();
+    bool getEvent(ICM20948_event* evt);
+    uint32_t getStepCount();
+    ICM20948_activity getActivity();
+    uint32_t getLostEvents();
+
+private:
+    ICM20948* _icm;
+    float msPerSample;
+    float msFraction;
+    uint32_t now; // ms
+    float smoothAlpha;
+    float meanAlpha;
+    float smoothG;
+    float meanG;
+    bool filterInit;
+
+    /* steps */
+    float stepMinThreshold;
+    uint16_t stepMinInterval;
+    float stepPeakAvg;
+    float lastSignal;
+    bool rising;
+    bool stepArmed;
+    uint32_t lastStepTime;
+    uint32_t quietUntil;
+    uint32_t steps;
+
+    /* taps */
+    float tapThreshold;
+    uint16_t tapMaxDuration;
+    uint16_t doubleTapWindow;
+    bool inSpike;
+    uint32_t spikeStart;
+    float spikePeak;
+    bool tapPending;
+    uint32_t tapTime;
+    uint16_t tapValue;
+
+    /* free fall */
+    float freeFallThreshold;
+    uint16_t freeFallMinDuration;
+    bool inFreeFall;
+    bool freeFallReported;
+    uint32_t freeFallStart;
+    float freeFallMin;
+
+    /* activity */
+    float movingThreshold;
+    float runningThreshold;
+    uint32_t activityStart;
+    uint16_t activityN;
+    float activitySum;
+    float activitySumSq;
+    ICM20948_activity activity;
+
+    /* event queue */
+    ICM20948_event queue[ICM20948_EVT_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+    uint32_t lostEvents;
+
+    void detectStep(float signal);
+    void detectTap(float deviation);
+    void detectFreeFall(float resultant);
+    void detectActivity(float resultant);
+    void pushEvent(uint32_t time, ICM20948_eventType type, uint16_t value);
+};
+
+#endif
@@ -0,0 +1,194 @@
+/********************************************************************
+ * FIFO polling scheduler for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_FifoScheduler.h"
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_FifoScheduler::ICM20948_FifoScheduler(ICM20948* icm)
+{
+    _icm = icm;
+    setSize = 12;
+    targetSets = 32;
+    margin = ICM20948_SCHED_MARGIN;
+    weight = ICM20948_SCHED_WEIGHT;
+    fillRate = 0.0;
+    level = 0.0;
+    lastTime = 0;
+    nextPoll = 0;
+    resetStats();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_FifoScheduler::begin(float setRate, uint8_t bytesPerSet)
+{
+    /* call after the FIFO was reset and started */
+    setSize = bytesPerSet;
+    fillRate = setRate * setSize / 1000000.0;
+    level = 0.0;
+    lastTime = micros();
+    schedule();
+}
+
+void ICM20948_FifoScheduler::setTargetBatch(uint16_t sets)
+{
+    targetSets = sets;
+    schedule();
+}
+
+void ICM20948_FifoScheduler::setSafetyMargin(uint16_t bytes)
+{
+    margin = (bytes < ICM20948_FIFO_SIZE) ? bytes : ICM20948_FIFO_SIZE - 1;
+    schedule();
+}
+
+void ICM20948_FifoScheduler::setCorrectionWeight(float w)
+{
+    weight = w;
+}
+
+///////////////////////////////////////////////
+// Scheduling
+///////////////////////////////////////////////
+
+bool ICM20948_FifoScheduler::isPollDue()
+{
+    return (int32_t)(micros() - nextPoll) >= 0;
+}
+
+uint32_t ICM20948_FifoScheduler::getNextPollTime()
+{
+    return nextPoll;
+}
+
+uint32_t ICM20948_FifoScheduler::getTimeToNextPoll()
+{
+    int32_t wait = (int32_t)(nextPoll - micros());
+    return (wait > 0) ? wait : 0;
+}
+
+int16_t ICM20948_FifoScheduler::poll()
+{
+    uint32_t now = micros();
+    int16_t count = _icm->getFifoCount();
+    observe(now, count, true);
+    schedule();
+    return count;
+}
+
+void ICM20948_FifoScheduler::consumed(uint16_t sets)
+{
+    float bytes = (float)sets * setSize;
+    level = (bytes < level) ? (level - bytes) : 0.0;
+    setsRead += sets;
+    schedule();
+}
+
+uint16_t ICM20948_FifoScheduler::read(int16_t* data, uint16_t maxSets)
+{
+    /* readFifoRawDataSets() reads FIFO_COUNT anyway; if it returns less than maxSets,
+     * the number of sets tells the fill level (rounded down to a complete set) */
+    uint32_t now = micros();
+    uint16_t sets = _icm->readFifoRawDataSets(data, maxSets);
+    bool exact = sets < maxSets;
+    observe(now, sets * setSize, exact);
+    consumed(sets);
+    if (!exact) {
+        nextPoll = micros(); // more data waiting
+    }
+    return sets;
+}
+
+///////////////////////////////////////////////
+// Statistics
+///////////////////////////////////////////////
+
+float ICM20948_FifoScheduler::getFillRate()
+{
+    return fillRate * 1000000.0; // bytes/s
+}
+
+uint32_t ICM20948_FifoScheduler::getPolls()
+{
+    return polls;
+}
+
+uint32_t ICM20948_FifoScheduler::getSetsRead()
+{
+    return setsRead;
+}
+
+float ICM20948_FifoScheduler::getPollsPerSet()
+{
+    return (setsRead > 0) ? (float)polls / setsRead : 0.0;
+}
+
+uint32_t ICM20948_FifoScheduler::getOverflows()
+{
+    return overflows;
+}
+
+void ICM20948_FifoScheduler::resetStats()
+{
+    polls = 0;
+    setsRead = 0;
+    overflows = 0;
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+void ICM20948_FifoScheduler::observe(uint32_t time, int16_t count, bool exact)
+{
+    uint32_t dt = time - lastTime;
+    polls++;
+
+    if (count >= (ICM20948_FIFO_SIZE - setSize)) {
+        overflows++; // full (or overflowed): the count says nothing about the rate
+    } else if ((dt > 0) && (count >= level)) {
+        /* a lower bound only corrects an estimate which is too low */
+        float observed = (count - level) / dt;
+        if (exact || (observed > fillRate)) {
+            fillRate += weight * (observed - fillRate);
+        }
+    }
+    level = count;
+    lastTime = time;
+}
+
+void ICM20948_FifoScheduler::schedule()
+{
+    /* time to reach the target batch at the estimated rate, but not later than the
+     * time to reach the limit at a rate which is ICM20948_SCHED_RATE_MARGIN higher */
+    float limit = ICM20948_FIFO_SIZE - margin;
+    float target = (float)targetSets * setSize;
+    if (target > limit) {
+        target = limit;
+    }
+
+    float wait = ICM20948_SCHED_MAX_WAIT;
+    if (fillRate > 0.0) {
+        float toTarget = (target - level) / fillRate;
+        float toLimit = (limit - level) / (fillRate * ICM20948_SCHED_RATE_MARGIN);
+        wait = (toTarget < toLimit) ? toTarget : toLimit;
+        if (wait < 0.0) {
+            wait = 0.0;
+        } else if (wait > ICM20948_SCHED_MAX_WAIT) {
+            wait = ICM20948_SCHED_MAX_WAIT;
+        }
+    }
+    nextPoll = lastTime + (uint32_t)wait;
+}
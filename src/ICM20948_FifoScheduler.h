@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ * FIFO polling scheduler for the ICM20948 library. Without interrupts, the
+ * FIFO has to be polled. Polling too often wastes bus time on an almost empty
+ * FIFO, polling too late lets it overflow. The scheduler models the fill level
+ * from the data set rate and the data set size, tells the application when the
+ * next poll is due to get a batch of the target size and corrects its fill rate
+ * estimate (EWMA) with the counts observed at each poll. The polls are limited
+ * so that the predicted fill level, including a safety margin for a faster
+ * than expected fill rate, stays below the 4096 byte FIFO size.
+ *
+ * Usage:
+ *
+ *   sched.begin(plan.gyrRate, 12);  // data sets/s, bytes per data set
+ *   sched.setTargetBatch(32);       // data sets per poll
+ *   ...
+ *   if (sched.isPollDue()) {
+ *       uint16_t sets = sched.read(data, 32); // reads FIFO_COUNT only once
+ *   }
+ *
+ * If the FIFO is read differently, call poll() (reads FIFO_COUNT) and
+ * consumed() after reading the data sets.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_FIFO_SCHEDULER_H_
+#define ICM20948_FIFO_SCHEDULER_H_
+
+#include "ICM20948.h"
+
+#define ICM20948_SCHED_MARGIN 512 // default safety margin [bytes] below the FIFO size
+#define ICM20948_SCHED_RATE_MARGIN 1.25 // fill rate uncertainty used for the overflow limit
+#define ICM20948_SCHED_WEIGHT 0.2 // default EWMA weight of a new fill rate observation
+#define ICM20948_SCHED_MAX_WAIT 1000000UL // µs, upper limit if the FIFO does not fill
+
+class ICM20948_FifoScheduler {
+public:
+    /* Constructors */
+
+    ICM20948_FifoScheduler(ICM20948* icm);
+
+    /* Settings */
+
+    void begin(float setRate, uint8_t bytesPerSet);
+    void setTargetBatch(uint16_t sets);
+    void setSafetyMargin(uint16_t bytes);
+    void setCorrectionWeight(float weight);
+
+    /* Scheduling */
+
+    bool isPollDue();
+    uint32_t getNextPollTime();
+    uint32_t getTimeToNextPoll();
+    int16_t poll();
+    void consumed(uint16_t sets);
+    uint16_t read(int16_t* data, uint16_t maxSets);
+
+    /* Statistics */
+
+    float getFillRate();
+    uint32_t getPolls();
+    uint32_t getSetsRead();
+    float getPollsPerSet();
+    uint32_t getOverflows();
+    void resetStats();
+
+private:
+    ICM20948* _icm;
+    uint8_t setSize;
+    uint16_t targetSets;
+    uint16_t margin;
+    float weight;
+    float fillRate; // bytes/µs
+    float level; // fill level [bytes] at lastTime
+    uint32_t lastTime;
+    uint32_t nextPoll;
+    uint32_t polls;
+    uint32_t setsRead;
+    uint32_t overflows;
+    void observe(uint32_t time, int16_t count, bool exact);
+    void schedule();
+};
+
+#endif
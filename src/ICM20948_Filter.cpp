@@ -0,0 +1,253 @@
+/********************************************************************
+ * Fixed-point filters for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_Filter.h"
+
+static int16_t saturate16(int64_t val)
+{
+    if (val > 32767) {
+        return 32767;
+    }
+    if (val < -32768) {
+        return -32768;
+    }
+    return (int16_t)val;
+}
+
+static int32_t toQ14(float val)
+{
+    return (int32_t)(val * 16384.0 + ((val < 0) ? -0.5 : 0.5));
+}
+
+static bool isDcResolvable(float a1, float a2)
+{
+    /* 1 + a1 + a2 is the DC gain denominator; below about fs/1000 it rounds to 0 in Q14 */
+    return (16384 + toQ14(a1) + toQ14(a2)) > 0;
+}
+
+///////////////////////////////////////////////
+// Decimator
+///////////////////////////////////////////////
+
+ICM20948_Decimator::ICM20948_Decimator()
+{
+    taps = 1;
+    h[0] = 32767;
+    decimation = 1;
+    reset();
+}
+
+bool ICM20948_Decimator::design(uint8_t factor, uint8_t numTaps, float cutoff)
+{
+    if ((factor == 0) || (numTaps == 0) || (numTaps > ICM20948_FILTER_MAX_TAPS)) {
+        return false;
+    }
+    /* windowed sinc (Hamming), cutoff relative to the input sample rate */
+    if (cutoff <= 0.0) {
+        cutoff = 0.4 / factor;
+    }
+    float coeff[ICM20948_FILTER_MAX_TAPS];
+    float sum = 0.0;
+    float mid = (numTaps - 1) / 2.0;
+    for (uint8_t i = 0; i < numTaps; i++) {
+        float t = i - mid;
+        float sinc = (t == 0.0) ? 2.0 * cutoff : sin(2.0 * PI * cutoff * t) / (PI * t);
+        float window = (numTaps > 1) ? 0.54 - 0.46 * cos(2.0 * PI * i / (numTaps - 1)) : 1.0;
+        coeff[i] = sinc * window;
+        sum += coeff[i];
+    }
+
+    int16_t q15[ICM20948_FILTER_MAX_TAPS];
+    for (uint8_t i = 0; i < numTaps; i++) {
+        q15[i] = saturate16((int32_t)(coeff[i] / sum * 32768.0 + 0.5));
+    }
+    return setTaps(q15, numTaps, factor);
+}
+
+bool ICM20948_Decimator::setTaps(const int16_t* coeff, uint8_t numTaps, uint8_t factor)
+{
+    if ((factor == 0) || (numTaps == 0) || (numTaps > ICM20948_FILTER_MAX_TAPS)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < numTaps; i++) {
+        h[i] = coeff[i];
+    }
+    taps = numTaps;
+    decimation = factor;
+    reset();
+    return true;
+}
+
+uint8_t ICM20948_Decimator::getFactor()
+{
+    return decimation;
+}
+
+void ICM20948_Decimator::reset()
+{
+    for (uint8_t i = 0; i < ICM20948_FILTER_MAX_TAPS; i++) {
+        history[i] = 0;
+    }
+    pos = 0;
+    phase = 0;
+}
+
+uint16_t ICM20948_Decimator::process(int16_t* data, uint16_t len, uint8_t stride)
+{
+    uint16_t out = 0;
+    for (uint16_t n = 0; n < len; n++) {
+        history[pos] = data[n * stride];
+        pos = (pos + 1 < taps) ? pos + 1 : 0;
+        if (++phase < decimation) {
+            continue;
+        }
+        phase = 0;
+
+        /* history[pos] is the oldest value now */
+        int32_t acc = 0x4000;
+        uint8_t k = pos;
+        for (uint8_t i = taps; i > 0; i--) {
+            acc += (int32_t)h[i - 1] * history[k];
+            k = (k + 1 < taps) ? k + 1 : 0;
+        }
+        data[out * stride] = saturate16(acc >> 15); // out <= n, in place is safe
+        out++;
+    }
+    return out;
+}
+
+///////////////////////////////////////////////
+// Biquad
+///////////////////////////////////////////////
+
+ICM20948_Biquad::ICM20948_Biquad()
+{
+    numStages = 0;
+    for (uint8_t i = 0; i < ICM20948_FILTER_MAX_STAGES; i++) {
+        setCoefficients(i, 1.0, 0.0, 0.0, 0.0, 0.0);
+    }
+    numStages = 0;
+}
+
+bool ICM20948_Biquad::setLowPass(uint8_t stage, float cutoff, float sampleRate, float q)
+{
+    /* RBJ audio EQ cookbook */
+    float w0 = 2.0 * PI * cutoff / sampleRate;
+    float alpha = sin(w0) / (2.0 * q);
+    float cosW0 = cos(w0);
+    float a0 = 1.0 + alpha;
+    if (!isDcResolvable(-2.0 * cosW0 / a0, (1.0 - alpha) / a0)
+        || !setCoefficients(stage, (1.0 - cosW0) / 2.0 / a0, (1.0 - cosW0) / a0, (1.0 - cosW0) / 2.0 / a0,
+            -2.0 * cosW0 / a0, (1.0 - alpha) / a0)) {
+        return false;
+    }
+    matchDcGain(stage);
+    return true;
+}
+
+bool ICM20948_Biquad::setNotch(uint8_t stage, float freq, float sampleRate, float q)
+{
+    float w0 = 2.0 * PI * freq / sampleRate;
+    float alpha = sin(w0) / (2.0 * q);
+    float cosW0 = cos(w0);
+    float a0 = 1.0 + alpha;
+    if (!isDcResolvable(-2.0 * cosW0 / a0, (1.0 - alpha) / a0)
+        || !setCoefficients(stage, 1.0 / a0, -2.0 * cosW0 / a0, 1.0 / a0, -2.0 * cosW0 / a0, (1.0 - alpha) / a0)) {
+        return false;
+    }
+    matchDcGain(stage);
+    return true;
+}
+
+bool ICM20948_Biquad::setCoefficients(uint8_t stage, float b0, float b1, float b2, float a1, float a2)
+{
+    if (stage >= ICM20948_FILTER_MAX_STAGES) {
+        return false;
+    }
+    sec[stage].b0 = toQ14(b0);
+    sec[stage].b1 = toQ14(b1);
+    sec[stage].b2 = toQ14(b2);
+    sec[stage].a1 = toQ14(a1);
+    sec[stage].a2 = toQ14(a2);
+    sec[stage].x1 = sec[stage].x2 = sec[stage].y1 = sec[stage].y2 = 0;
+    sec[stage].err = 0;
+    if (stage >= numStages) {
+        numStages = stage + 1;
+    }
+    return true;
+}
+
+void ICM20948_Biquad::matchDcGain(uint8_t stage)
+{
+    /* DC gain = (b0 + b1 + b2) / (1 + a1 + a2). At low cutoff / sample rate ratios the b
+     * coefficients are only a few LSB and their rounding errors add up to several percent.
+     * b1 takes the difference, so the DC gain of the quantized section is exactly 1. */
+    section& f = sec[stage];
+    f.b1 = 16384 + f.a1 + f.a2 - f.b0 - f.b2;
+}
+
+void ICM20948_Biquad::setStages(uint8_t stages)
+{
+    numStages = (stages > ICM20948_FILTER_MAX_STAGES) ? ICM20948_FILTER_MAX_STAGES : stages;
+}
+
+uint8_t ICM20948_Biquad::getStages()
+{
+    return numStages;
+}
+
+void ICM20948_Biquad::reset()
+{
+    for (uint8_t i = 0; i < ICM20948_FILTER_MAX_STAGES; i++) {
+        sec[i].x1 = sec[i].x2 = sec[i].y1 = sec[i].y2 = 0;
+        sec[i].err = 0;
+    }
+}
+
+void ICM20948_Biquad::process(int16_t* data, uint16_t len, uint8_t stride)
+{
+    for (uint8_t s = 0; s < numStages; s++) {
+        section& f = sec[s];
+        int16_t* val = data;
+        for (uint16_t n = 0; n < len; n++) {
+            /* direct form I; the remainder of the shift is fed back into the next
+             * output, which keeps low cutoff filters free of limit cycles and offsets.
+             * 64 bit sum: with full scale input the products of a section with a gain
+             * above 4 (setCoefficients()) add up to more than 2^31. */
+            int64_t acc = (int64_t)f.err + (int64_t)f.b0 * *val + (int64_t)f.b1 * f.x1 + (int64_t)f.b2 * f.x2
+                - (int64_t)f.a1 * f.y1 - (int64_t)f.a2 * f.y2;
+            int16_t y = saturate16(acc >> 14);
+            f.err = (int32_t)(acc & 0x3FFF);
+            f.x2 = f.x1;
+            f.x1 = *val;
+            f.y2 = f.y1;
+            f.y1 = y;
+            *val = y;
+            val += stride;
+        }
+    }
+}
+
+///////////////////////////////////////////////
+// Axis filter
+///////////////////////////////////////////////
+
+void ICM20948_AxisFilter::reset()
+{
+    decimator.reset();
+    biquad.reset();
+}
+
+uint16_t ICM20948_AxisFilter::process(int16_t* data, uint16_t len, uint8_t stride)
+{
+    uint16_t out = decimator.process(data, len, stride);
+    biquad.process(data, out, stride);
+    return out;
+}
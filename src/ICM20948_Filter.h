@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Fixed-point filters for raw ICM20948 data, e.g. batches from
+ * ICM20948::readFifoRawDataSets(). The idea: read at a high sample rate, filter
+ * with a steeper characteristic than the DLPF of the ICM20948 and reduce the
+ * data rate before further processing.
+ *
+ * ICM20948_Decimator  FIR lowpass and decimation by a factor M. Only every M-th
+ *                     output is calculated (polyphase principle).
+ * ICM20948_Biquad     cascade of biquad sections (2nd order IIR filters)
+ * ICM20948_AxisFilter decimator followed by biquads, one object per axis
+ *
+ * All filters work in place on int16_t arrays. With stride = 1 they process
+ * one axis per array (structure of arrays), with stride = 3 or 6 they can be
+ * applied directly to the interleaved FIFO data (x,y,z,x,y,z...). Decimated
+ * values are written to the beginning of the array, with the same stride.
+ *
+ * Coefficients are Q14 (biquads) or Q15 (FIR taps). The design functions use
+ * floats but are only called once. setLowPass() and setNotch() correct the
+ * rounding so that the DC gain is exactly 1 and return false if the frequency
+ * is too low for Q14 (below about sample rate / 1000). The maximum number of taps and biquad
+ * sections can be reduced to save RAM by defining ICM20948_FILTER_MAX_TAPS and
+ * ICM20948_FILTER_MAX_STAGES before including this file.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_FILTER_H_
+#define ICM20948_FILTER_H_
+
+#include <Arduino.h>
+
+#ifndef ICM20948_FILTER_MAX_TAPS
+#define ICM20948_FILTER_MAX_TAPS 24
+#endif
+#ifndef ICM20948_FILTER_MAX_STAGES
+#define ICM20948_FILTER_MAX_STAGES 2
+#endif
+
+class ICM20948_Decimator {
+public:
+    /* Constructors */
+
+    ICM20948_Decimator();
+
+    /* Settings */
+
+    bool design(uint8_t factor, uint8_t numTaps, float cutoff = 0.0);
+    bool setTaps(const int16_t* taps, uint8_t numTaps, uint8_t factor);
+    uint8_t getFactor();
+    void reset();
+
+    /* Processing */
+
+    uint16_t process(int16_t* data, uint16_t len, uint8_t stride = 1);
+
+private:
+    int16_t h[ICM20948_FILTER_MAX_TAPS]; // Q15
+    int16_t history[ICM20948_FILTER_MAX_TAPS];
+    uint8_t taps;
+    uint8_t decimation;
+    uint8_t pos;
+    uint8_t phase;
+};
+
+class ICM20948_Biquad {
+public:
+    /* Constructors */
+
+    ICM20948_Biquad();
+
+    /* Settings */
+
+    bool setLowPass(uint8_t stage, float cutoff, float sampleRate, float q = 0.7071);
+    bool setNotch(uint8_t stage, float freq, float sampleRate, float q = 2.0);
+    bool setCoefficients(uint8_t stage, float b0, float b1, float b2, float a1, float a2);
+    void setStages(uint8_t stages);
+    uint8_t getStages();
+    void reset();
+
+    /* Processing */
+
+    void process(int16_t* data, uint16_t len, uint8_t stride = 1);
+
+private:
+    struct section {
+        int32_t b0, b1, b2, a1, a2; // Q14, a0 = 1
+        int16_t x1, x2, y1, y2;
+        int32_t err; // remainder of the last output, first order error feedback
+    };
+    section sec[ICM20948_FILTER_MAX_STAGES];
+    uint8_t numStages;
+    void matchDcGain(uint8_t stage);
+};
+
+class ICM20948_AxisFilter {
+public:
+    ICM20948_Decimator decimator;
+    ICM20948_Biquad biquad;
+
+    void reset();
+    uint16_t process(int16_t* data, uint16_t len, uint8_t stride = 1);
+};
+
+#endif
@@ -0,0 +1,339 @@
+/********************************************************************
+ * Power manager for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_PowerManager.h"
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_PowerManager::ICM20948_PowerManager(ICM20948* icm)
+{
+    _icm = icm;
+    state = ICM20948_PWR_STREAMING;
+    womThreshold = 20; // 80 mg
+    idleTimeout = 5000;
+    sleepTimeout = 0;
+    streamingEvents = 5;
+    streamingWindow = 2000;
+    womAccDiv = 225; // ~5 Hz
+    cycleAccDiv = 21; // ~51 Hz
+    cycleGyrDiv = 21;
+    streamAccDiv = 0;
+    streamGyrDiv = 0;
+    fifoBatchSize = 2400; // multiple of 12, leaves a safety margin
+    motionInBatch = false;
+
+    /* rough typical values, measure your own board for reliable figures */
+    stateCurrent[ICM20948_PWR_SLEEP] = 8.0;
+    stateCurrent[ICM20948_PWR_WAKE_ON_MOTION] = 20.0;
+    stateCurrent[ICM20948_PWR_LOW_POWER_CYCLE] = 400.0;
+    stateCurrent[ICM20948_PWR_STREAMING] = 3110.0;
+
+    resetEnergyStats();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_PowerManager::begin(ICM20948_powerState startState)
+{
+    uint32_t now = millis();
+    stateSince = now;
+    lastMotion = now;
+    windowStart = now;
+    windowEvents = 0;
+    motionInBatch = false;
+
+    _icm->setFifoMode(ICM20948_STOP_WHEN_FULL);
+    _icm->setWakeOnMotionThreshold(womThreshold, ICM20948_WOM_COMP_ENABLE);
+    _icm->readAndClearInterrupts();
+    state = startState;
+    enterState(startState);
+}
+
+void ICM20948_PowerManager::setWakeOnMotionThreshold(uint8_t womThresh)
+{
+    womThreshold = womThresh;
+}
+
+void ICM20948_PowerManager::setIdleTimeout(uint32_t ms)
+{
+    idleTimeout = ms;
+}
+
+void ICM20948_PowerManager::setSleepTimeout(uint32_t ms)
+{
+    sleepTimeout = ms;
+}
+
+void ICM20948_PowerManager::setStreamingTrigger(uint8_t motionEvents, uint32_t windowMs)
+{
+    streamingEvents = motionEvents;
+    streamingWindow = windowMs;
+}
+
+void ICM20948_PowerManager::setWakeOnMotionSampleRateDivider(uint16_t accSplRateDiv)
+{
+    womAccDiv = accSplRateDiv;
+}
+
+void ICM20948_PowerManager::setCycleSampleRateDivider(uint16_t accSplRateDiv, uint8_t gyrSplRateDiv)
+{
+    cycleAccDiv = accSplRateDiv;
+    cycleGyrDiv = gyrSplRateDiv;
+}
+
+void ICM20948_PowerManager::setStreamingSampleRateDivider(uint16_t accSplRateDiv, uint8_t gyrSplRateDiv)
+{
+    streamAccDiv = accSplRateDiv;
+    streamGyrDiv = gyrSplRateDiv;
+}
+
+void ICM20948_PowerManager::setFifoBatchSize(uint16_t bytes)
+{
+    bytes -= bytes % 12; // complete acc + gyr data sets
+    if (bytes < 12) {
+        bytes = 12; // at least one data set, 0 would always be ready
+    } else if (bytes > (ICM20948_FIFO_SIZE - 12)) {
+        bytes = ICM20948_FIFO_SIZE - 12;
+    }
+    fifoBatchSize = bytes;
+}
+
+void ICM20948_PowerManager::setStateCurrent(ICM20948_powerState pwrState, float microAmps)
+{
+    stateCurrent[pwrState] = microAmps;
+}
+
+///////////////////////////////////////////////
+// State machine
+///////////////////////////////////////////////
+
+ICM20948_powerState ICM20948_PowerManager::update(uint8_t intSource)
+{
+    uint32_t now = millis();
+    bool motion = _icm->checkInterrupt(intSource, ICM20948_WOM_INT);
+
+    if (motion) {
+        lastMotion = now;
+        motionInBatch = true;
+        if ((now - windowStart) > streamingWindow) {
+            windowStart = now;
+            windowEvents = 0;
+        }
+        if (windowEvents < 255) {
+            windowEvents++;
+        }
+    }
+    uint32_t idle = now - lastMotion;
+
+    switch (state) {
+    case ICM20948_PWR_SLEEP:
+        break; // only wakeup() leaves the sleep state
+
+    case ICM20948_PWR_WAKE_ON_MOTION:
+        if (motion) {
+            enterState(ICM20948_PWR_LOW_POWER_CYCLE);
+        } else if ((sleepTimeout > 0) && (idle > sleepTimeout)) {
+            enterState(ICM20948_PWR_SLEEP);
+        }
+        break;
+
+    case ICM20948_PWR_LOW_POWER_CYCLE:
+        if ((windowEvents >= streamingEvents) && ((now - windowStart) <= streamingWindow)) {
+            enterState(ICM20948_PWR_STREAMING);
+        } else if (_icm->getFifoCount() >= fifoBatchSize) {
+            /* a full batch with motion in it: continue at full rate, the batch counts as
+             * activity, so streaming lasts at least the idle timeout */
+            if (motionInBatch) {
+                lastMotion = now;
+                enterState(ICM20948_PWR_STREAMING);
+            } else if (idle > idleTimeout) {
+                enterState(ICM20948_PWR_WAKE_ON_MOTION);
+            }
+            motionInBatch = false;
+        } else if (idle > idleTimeout) {
+            enterState(ICM20948_PWR_WAKE_ON_MOTION);
+        }
+        break;
+
+    case ICM20948_PWR_STREAMING:
+        if (idle > idleTimeout) {
+            lastMotion = now; // the idle timeout applies to each step down
+            enterState(ICM20948_PWR_LOW_POWER_CYCLE);
+        }
+        break;
+    }
+
+    return state;
+}
+
+ICM20948_powerState ICM20948_PowerManager::getState()
+{
+    return state;
+}
+
+void ICM20948_PowerManager::wakeup()
+{
+    lastMotion = millis();
+    enterState(ICM20948_PWR_WAKE_ON_MOTION);
+}
+
+bool ICM20948_PowerManager::isFifoBatchReady()
+{
+    int16_t count = _icm->getFifoCount();
+    if (state == ICM20948_PWR_LOW_POWER_CYCLE) {
+        return count >= fifoBatchSize;
+    }
+    return count > 0; // data left over from the last low power period
+}
+
+uint32_t ICM20948_PowerManager::getTimeToNextWakeup()
+{
+    uint32_t now = millis();
+
+    switch (state) {
+    case ICM20948_PWR_LOW_POWER_CYCLE: {
+        int16_t count = _icm->getFifoCount();
+        if (count >= fifoBatchSize) {
+            return 0;
+        }
+        /* the gyroscope sample rate has priority if both sensors are enabled */
+        float bytesPerMs = 12.0 * ICM20948_BASE_SAMPLE_RATE / (1 + cycleGyrDiv) / 1000.0;
+        uint32_t fillTime = (fifoBatchSize - count) / bytesPerMs;
+        uint32_t idleTime = now - lastMotion;
+        if (idleTime < idleTimeout) {
+            uint32_t stepDown = idleTimeout - idleTime + 1;
+            return (stepDown < fillTime) ? stepDown : fillTime;
+        }
+        return 0;
+    }
+
+    case ICM20948_PWR_WAKE_ON_MOTION:
+        if (sleepTimeout > 0) {
+            uint32_t idleTime = now - lastMotion;
+            return (idleTime < sleepTimeout) ? (sleepTimeout - idleTime + 1) : 0;
+        }
+        return ICM20948_PWR_NO_WAKEUP;
+
+    case ICM20948_PWR_SLEEP:
+        return ICM20948_PWR_NO_WAKEUP;
+
+    default:
+        return 0;
+    }
+}
+
+///////////////////////////////////////////////
+// Energy estimation
+///////////////////////////////////////////////
+
+uint32_t ICM20948_PowerManager::getTimeInState(ICM20948_powerState pwrState)
+{
+    accountTime();
+    return timeInState[pwrState];
+}
+
+float ICM20948_PowerManager::getChargeConsumed()
+{
+    float charge = 0.0; // µAh
+
+    accountTime();
+    for (int i = 0; i < ICM20948_PWR_NUMBER_OF_STATES; i++) {
+        charge += stateCurrent[i] * timeInState[i] / 3600000.0;
+    }
+    return charge;
+}
+
+float ICM20948_PowerManager::getAverageCurrent()
+{
+    uint32_t totalTime = 0;
+
+    accountTime();
+    for (int i = 0; i < ICM20948_PWR_NUMBER_OF_STATES; i++) {
+        totalTime += timeInState[i];
+    }
+    if (totalTime == 0) {
+        return stateCurrent[state];
+    }
+    return getChargeConsumed() * 3600000.0 / totalTime;
+}
+
+void ICM20948_PowerManager::resetEnergyStats()
+{
+    for (int i = 0; i < ICM20948_PWR_NUMBER_OF_STATES; i++) {
+        timeInState[i] = 0;
+    }
+    stateSince = millis();
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+void ICM20948_PowerManager::enterState(ICM20948_powerState newState)
+{
+    accountTime();
+    state = newState;
+
+    switch (newState) {
+    case ICM20948_PWR_SLEEP:
+        _icm->stopFifo();
+        _icm->disableInterrupt(ICM20948_WOM_INT);
+        _icm->sleep();
+        break;
+
+    case ICM20948_PWR_WAKE_ON_MOTION:
+        _icm->wakeup();
+        _icm->stopFifo();
+        _icm->disableGyr();
+        _icm->enableAcc();
+        _icm->setAccSampleRateDivider(womAccDiv);
+        _icm->enableCycle(ICM20948_ACC_CYCLE);
+        _icm->enableLowPower();
+        _icm->enableInterrupt(ICM20948_WOM_INT);
+        break;
+
+    case ICM20948_PWR_LOW_POWER_CYCLE:
+        _icm->wakeup();
+        _icm->enableAcc();
+        _icm->enableGyr();
+        _icm->setAccSampleRateDivider(cycleAccDiv);
+        _icm->setGyrSampleRateDivider(cycleGyrDiv);
+        _icm->enableCycle(ICM20948_ACC_GYR_CYCLE);
+        _icm->enableLowPower();
+        _icm->enableInterrupt(ICM20948_WOM_INT);
+        _icm->enableFifo();
+        _icm->startFifo(ICM20948_FIFO_ACC_GYR);
+        motionInBatch = false;
+        break;
+
+    case ICM20948_PWR_STREAMING:
+        _icm->wakeup();
+        _icm->stopFifo();
+        _icm->enableAcc();
+        _icm->enableGyr();
+        _icm->disableLowPower();
+        _icm->enableCycle(ICM20948_NO_CYCLE);
+        _icm->setAccSampleRateDivider(streamAccDiv);
+        _icm->setGyrSampleRateDivider(streamGyrDiv);
+        _icm->enableInterrupt(ICM20948_WOM_INT);
+        break;
+    }
+}
+
+void ICM20948_PowerManager::accountTime()
+{
+    uint32_t now = millis();
+    timeInState[state] += now - stateSince;
+    stateSince = now;
+}
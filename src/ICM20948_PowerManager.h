@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Power manager for the ICM20948 library. It switches the ICM20948 between
+ * sleep, wake-on-motion, low power cycle mode and full rate streaming depending
+ * on the motion activity and the FIFO fill. In low power cycle mode the data is
+ * batched in the FIFO, so that the MCU only needs to wake up when a batch is
+ * complete. If there was motion while a batch was collected, the complete batch
+ * switches to streaming (and restarts the idle time before the step down).
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_POWER_MANAGER_H_
+#define ICM20948_POWER_MANAGER_H_
+
+#include "ICM20948.h"
+
+#define ICM20948_PWR_NO_WAKEUP 0xFFFFFFFF // wait for an interrupt
+
+typedef enum ICM20948_POWER_STATE {
+    ICM20948_PWR_SLEEP,
+    ICM20948_PWR_WAKE_ON_MOTION,
+    ICM20948_PWR_LOW_POWER_CYCLE,
+    ICM20948_PWR_STREAMING
+} ICM20948_powerState;
+
+#define ICM20948_PWR_NUMBER_OF_STATES 4
+
+class ICM20948_PowerManager {
+public:
+    /* Constructors */
+
+    ICM20948_PowerManager(ICM20948* icm);
+
+    /* Settings */
+
+    void begin(ICM20948_powerState state = ICM20948_PWR_WAKE_ON_MOTION);
+    void setWakeOnMotionThreshold(uint8_t womThresh);
+    void setIdleTimeout(uint32_t ms);
+    void setSleepTimeout(uint32_t ms);
+    void setStreamingTrigger(uint8_t motionEvents, uint32_t windowMs);
+    void setWakeOnMotionSampleRateDivider(uint16_t accSplRateDiv);
+    void setCycleSampleRateDivider(uint16_t accSplRateDiv, uint8_t gyrSplRateDiv);
+    void setStreamingSampleRateDivider(uint16_t accSplRateDiv, uint8_t gyrSplRateDiv);
+    void setFifoBatchSize(uint16_t bytes);
+    void setStateCurrent(ICM20948_powerState state, float microAmps);
+
+    /* State machine */
+
+    ICM20948_powerState update(uint8_t intSource);
+    ICM20948_powerState getState();
+    void wakeup();
+    bool isFifoBatchReady();
+    uint32_t getTimeToNextWakeup();
+
+    /* Energy estimation */
+
+    uint32_t getTimeInState(ICM20948_powerState state);
+    float getChargeConsumed();
+    float getAverageCurrent();
+    void resetEnergyStats();
+
+private:
+    ICM20948* _icm;
+    ICM20948_powerState state;
+    uint8_t womThreshold;
+    uint32_t idleTimeout;
+    uint32_t sleepTimeout;
+    uint8_t streamingEvents;
+    uint32_t streamingWindow;
+    uint16_t womAccDiv;
+    uint16_t cycleAccDiv;
+    uint8_t cycleGyrDiv;
+    uint16_t streamAccDiv;
+    uint8_t streamGyrDiv;
+    uint16_t fifoBatchSize;
+    float stateCurrent[ICM20948_PWR_NUMBER_OF_STATES]; // µA
+    uint32_t timeInState[ICM20948_PWR_NUMBER_OF_STATES]; // ms
+    uint32_t stateSince;
+    uint32_t lastMotion;
+    uint32_t windowStart;
+    uint8_t windowEvents;
+    bool motionInBatch; // motion since the current FIFO batch was started
+    void enterState(ICM20948_powerState newState);
+    void accountTime();
+};
+
+#endif
@@ -0,0 +1,139 @@
+/********************************************************************
+ * Recorder for the raw data of the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_Recorder.h"
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_Recorder::ICM20948_Recorder(Print* out)
+{
+    _out = out;
+    paused = false;
+    bytesWritten = 0;
+}
+
+///////////////////////////////////////////////
+// Recording
+///////////////////////////////////////////////
+
+void ICM20948_Recorder::writeHeader(const ICM20948_recConfig& config)
+{
+    uint8_t header[ICM20948_REC_HEADER_LEN];
+    uint16_t len = encodeHeader(config, header);
+    bytesWritten += _out->write(header, len);
+}
+
+void ICM20948_Recorder::record(uint8_t bank, uint8_t reg, const uint8_t* data, uint8_t len)
+{
+    if (paused) {
+        return;
+    }
+
+    uint8_t recHeader[ICM20948_REC_RECORD_HEADER_LEN];
+    uint32_t timestamp = micros();
+    recHeader[0] = bank;
+    recHeader[1] = reg;
+    recHeader[2] = len;
+    recHeader[3] = timestamp & 0xFF;
+    recHeader[4] = (timestamp >> 8) & 0xFF;
+    recHeader[5] = (timestamp >> 16) & 0xFF;
+    recHeader[6] = (timestamp >> 24) & 0xFF;
+
+    bytesWritten += _out->write(recHeader, ICM20948_REC_RECORD_HEADER_LEN);
+    bytesWritten += _out->write(data, len);
+}
+
+void ICM20948_Recorder::pause()
+{
+    paused = true;
+}
+
+void ICM20948_Recorder::resume()
+{
+    paused = false;
+}
+
+uint32_t ICM20948_Recorder::getBytesWritten()
+{
+    return bytesWritten;
+}
+
+///////////////////////////////////////////////
+// Format helpers
+///////////////////////////////////////////////
+
+uint16_t ICM20948_Recorder::encodeHeader(const ICM20948_recConfig& config, uint8_t* dest)
+{
+    dest[0] = 'I';
+    dest[1] = 'C';
+    dest[2] = 'M';
+    dest[3] = 'R';
+    dest[4] = ICM20948_REC_VERSION;
+    dest[5] = config.accRangeFactor;
+    dest[6] = config.gyrRangeFactor;
+    dest[7] = config.fifoType;
+    putFloat(&dest[8], config.accOffsetVal.x);
+    putFloat(&dest[12], config.accOffsetVal.y);
+    putFloat(&dest[16], config.accOffsetVal.z);
+    putFloat(&dest[20], config.accCorrFactor.x);
+    putFloat(&dest[24], config.accCorrFactor.y);
+    putFloat(&dest[28], config.accCorrFactor.z);
+    putFloat(&dest[32], config.gyrOffsetVal.x);
+    putFloat(&dest[36], config.gyrOffsetVal.y);
+    putFloat(&dest[40], config.gyrOffsetVal.z);
+    return ICM20948_REC_HEADER_LEN;
+}
+
+bool ICM20948_Recorder::decodeHeader(const uint8_t* src, ICM20948_recConfig& config)
+{
+    if ((src[0] != 'I') || (src[1] != 'C') || (src[2] != 'M') || (src[3] != 'R')) {
+        return false;
+    }
+    if (src[4] != ICM20948_REC_VERSION) {
+        return false;
+    }
+    config.accRangeFactor = src[5];
+    config.gyrRangeFactor = src[6];
+    config.fifoType = src[7];
+    config.accOffsetVal.x = getFloat(&src[8]);
+    config.accOffsetVal.y = getFloat(&src[12]);
+    config.accOffsetVal.z = getFloat(&src[16]);
+    config.accCorrFactor.x = getFloat(&src[20]);
+    config.accCorrFactor.y = getFloat(&src[24]);
+    config.accCorrFactor.z = getFloat(&src[28]);
+    config.gyrOffsetVal.x = getFloat(&src[32]);
+    config.gyrOffsetVal.y = getFloat(&src[36]);
+    config.gyrOffsetVal.z = getFloat(&src[40]);
+    return true;
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+void ICM20948_Recorder::putFloat(uint8_t* dest, float val)
+{
+    uint32_t bits;
+    memcpy(&bits, &val, 4);
+    dest[0] = bits & 0xFF;
+    dest[1] = (bits >> 8) & 0xFF;
+    dest[2] = (bits >> 16) & 0xFF;
+    dest[3] = (bits >> 24) & 0xFF;
+}
+
+float ICM20948_Recorder::getFloat(const uint8_t* src)
+{
+    float val;
+    uint32_t bits = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+    memcpy(&val, &bits, 4);
+    return val;
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ * Recorder for the raw data the ICM20948 returns. Attach it with
+ * ICM20948::setRecorder() and every read transaction of the driver is written
+ * to a Print object (Serial, SD card file, ...). The recording can be fed back
+ * through the ICM20948 class on a host computer, see extras/host.
+ *
+ * Format (all values little endian):
+ *
+ * Header:
+ *   "ICMR"               4 bytes magic
+ *   version              1 byte (ICM20948_REC_VERSION)
+ *   accRangeFactor       1 byte (1, 2, 4, 8)
+ *   gyrRangeFactor       1 byte (1, 2, 4, 8)
+ *   fifoType             1 byte (ICM20948_fifoType)
+ *   accOffsetVal         3 floats
+ *   accCorrFactor        3 floats
+ *   gyrOffsetVal         3 floats
+ *
+ * Records, one per read transaction:
+ *   bank                 1 byte
+ *   register             1 byte
+ *   length               1 byte
+ *   timestamp            4 bytes, micros()
+ *   data                 length bytes as returned by the ICM20948
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_RECORDER_H_
+#define ICM20948_RECORDER_H_
+
+#include <Arduino.h>
+#include "ICM20948.h"
+
+#define ICM20948_REC_VERSION 1
+#define ICM20948_REC_HEADER_LEN 44
+#define ICM20948_REC_RECORD_HEADER_LEN 7
+
+struct ICM20948_recConfig {
+    uint8_t accRangeFactor;
+    uint8_t gyrRangeFactor;
+    uint8_t fifoType;
+    xyzFloat accOffsetVal;
+    xyzFloat accCorrFactor;
+    xyzFloat gyrOffsetVal;
+};
+
+class ICM20948_Recorder {
+public:
+    /* Constructors */
+
+    ICM20948_Recorder(Print* out);
+
+    /* Recording */
+
+    void writeHeader(const ICM20948_recConfig& config);
+    void record(uint8_t bank, uint8_t reg, const uint8_t* data, uint8_t len);
+    void pause();
+    void resume();
+    uint32_t getBytesWritten();
+
+    /* Format helpers, also used on the host */
+
+    static uint16_t encodeHeader(const ICM20948_recConfig& config, uint8_t* dest);
+    static bool decodeHeader(const uint8_t* src, ICM20948_recConfig& config);
+
+private:
+    Print* _out;
+    bool paused;
+    uint32_t bytesWritten;
+    static void putFloat(uint8_t* dest, float val);
+    static float getFloat(const uint8_t* src);
+};
+
+#endif
@@ -0,0 +1,250 @@
+/********************************************************************
+ * Resampler for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_Resampler.h"
+
+/* time difference a - b in µs, valid across the micros() overflow */
+static int32_t timeDiff(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b);
+}
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_Resampler::ICM20948_Resampler(float outputRate)
+{
+    for (uint8_t i = 0; i < ICM20948_NUMBER_OF_STREAMS; i++) {
+        streams[i].mode = ICM20948_RESAMPLE_LINEAR;
+        streams[i].enabled = true;
+    }
+    streams[ICM20948_STREAM_MAG].mode = ICM20948_RESAMPLE_HOLD;
+    setOutputRate(outputRate);
+    reset();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_Resampler::setOutputRate(float outputRate)
+{
+    period = 1000000.0 / outputRate;
+}
+
+void ICM20948_Resampler::setMode(ICM20948_stream stream, ICM20948_resampleMode mode)
+{
+    streams[stream].mode = mode;
+}
+
+void ICM20948_Resampler::enableStream(ICM20948_stream stream, bool enable)
+{
+    streams[stream].enabled = enable;
+}
+
+void ICM20948_Resampler::reset()
+{
+    for (uint8_t i = 0; i < ICM20948_NUMBER_OF_STREAMS; i++) {
+        streams[i].head = 0;
+        streams[i].count = 0;
+    }
+    started = false;
+    outTime = 0;
+    outFrac = 0.0;
+    overruns = 0;
+}
+
+///////////////////////////////////////////////
+// Processing
+///////////////////////////////////////////////
+
+void ICM20948_Resampler::push(ICM20948_stream stream, uint32_t time, xyzFloat val)
+{
+    Stream& s = streams[stream];
+    if (s.count == ICM20948_RESAMPLE_HISTORY) {
+        /* the oldest sample is lost; only count it if no frame used it yet */
+        uint8_t second = (s.head + 1) % ICM20948_RESAMPLE_HISTORY;
+        if (started && (timeDiff(s.time[second], outTime) > 0)) {
+            overruns++;
+        }
+        s.head = second;
+        s.count--;
+    }
+    uint8_t idx = (s.head + s.count) % ICM20948_RESAMPLE_HISTORY;
+    s.time[idx] = time;
+    s.val[idx] = val;
+    s.count++;
+}
+
+void ICM20948_Resampler::pushBatch(
+    ICM20948_stream stream, const xyzFloat* val, uint16_t n, uint32_t firstTime, float samplePeriod)
+{
+    /* samplePeriod in µs; the time stamps are rounded, the error does not accumulate */
+    for (uint16_t i = 0; i < n; i++) {
+        push(stream, firstTime + (uint32_t)(i * samplePeriod + 0.5), val[i]);
+    }
+}
+
+bool ICM20948_Resampler::getFrame(ICM20948_frame* frame)
+{
+    if (!started && !start()) {
+        return false;
+    }
+    /* hold streams don't wait, but the time line must not run ahead of all streams */
+    bool reached = false;
+    for (uint8_t i = 0; i < ICM20948_NUMBER_OF_STREAMS; i++) {
+        const Stream& s = streams[i];
+        if (!s.enabled) {
+            continue;
+        }
+        if (!isReady(s, outTime)) {
+            return false;
+        }
+        uint8_t newest = (s.head + s.count - 1) % ICM20948_RESAMPLE_HISTORY;
+        reached = reached || (timeDiff(s.time[newest], outTime) >= 0);
+    }
+    if (!reached) {
+        return false;
+    }
+
+    frame->time = outTime;
+    frame->streams = 0;
+    xyzFloat* dest[ICM20948_NUMBER_OF_STREAMS] = { &frame->acc, &frame->gyr, &frame->mag };
+    for (uint8_t i = 0; i < ICM20948_NUMBER_OF_STREAMS; i++) {
+        if (streams[i].enabled) {
+            *dest[i] = valueAt(streams[i], outTime);
+            frame->streams |= (1 << i);
+        } else {
+            dest[i]->x = 0.0;
+            dest[i]->y = 0.0;
+            dest[i]->z = 0.0;
+        }
+    }
+
+    float step = period + outFrac;
+    uint32_t intStep = (uint32_t)step;
+    outFrac = step - intStep;
+    outTime += intStep;
+    return true;
+}
+
+uint16_t ICM20948_Resampler::getFrames(ICM20948_frame* frames, uint16_t maxFrames)
+{
+    uint16_t n = 0;
+    while ((n < maxFrames) && getFrame(&frames[n])) {
+        n++;
+    }
+    return n;
+}
+
+uint32_t ICM20948_Resampler::getOverruns()
+{
+    return overruns;
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+bool ICM20948_Resampler::start()
+{
+    /* the first frame is at the latest first sample of the enabled streams */
+    bool any = false;
+    for (uint8_t i = 0; i < ICM20948_NUMBER_OF_STREAMS; i++) {
+        const Stream& s = streams[i];
+        if (!s.enabled) {
+            continue;
+        }
+        if (s.count == 0) {
+            return false;
+        }
+        if (!any || (timeDiff(s.time[s.head], outTime) > 0)) {
+            outTime = s.time[s.head];
+        }
+        any = true;
+    }
+    if (any) {
+        outFrac = 0.0;
+        started = true;
+    }
+    return any;
+}
+
+bool ICM20948_Resampler::isReady(const Stream& s, uint32_t t)
+{
+    if (s.count == 0) {
+        return false;
+    }
+    uint8_t newest = (s.head + s.count - 1) % ICM20948_RESAMPLE_HISTORY;
+    int32_t ahead = timeDiff(s.time[newest], t);
+    switch (s.mode) {
+    case ICM20948_RESAMPLE_HOLD:
+        return true;
+    case ICM20948_RESAMPLE_LINEAR:
+        return ahead >= 0;
+    case ICM20948_RESAMPLE_CUBIC:
+        /* a sample after the interval around t is needed as well */
+        if ((ahead < 0) || (s.count < 2)) {
+            return false;
+        }
+        uint8_t second = (s.head + s.count - 2) % ICM20948_RESAMPLE_HISTORY;
+        return (ahead == 0) || (timeDiff(s.time[second], t) > 0);
+    }
+    return false;
+}
+
+xyzFloat ICM20948_Resampler::valueAt(const Stream& s, uint32_t t)
+{
+    /* p1: last sample at or before t (or the oldest one), p2: the sample after */
+    uint8_t k = 0;
+    for (uint8_t j = s.count; j > 0; j--) {
+        uint8_t idx = (s.head + j - 1) % ICM20948_RESAMPLE_HISTORY;
+        if (timeDiff(s.time[idx], t) <= 0) {
+            k = j - 1;
+            break;
+        }
+    }
+    uint8_t i1 = (s.head + k) % ICM20948_RESAMPLE_HISTORY;
+    if ((s.mode == ICM20948_RESAMPLE_HOLD) || (k + 1 >= s.count) || (timeDiff(s.time[i1], t) > 0)) {
+        return s.val[i1];
+    }
+    uint8_t i2 = (s.head + k + 1) % ICM20948_RESAMPLE_HISTORY;
+    float h = timeDiff(s.time[i2], s.time[i1]);
+    float u = timeDiff(t, s.time[i1]) / h;
+    const xyzFloat& p1 = s.val[i1];
+    const xyzFloat& p2 = s.val[i2];
+    xyzFloat res;
+
+    if ((s.mode == ICM20948_RESAMPLE_LINEAR) || (k + 2 >= s.count)) {
+        res.x = p1.x + u * (p2.x - p1.x);
+        res.y = p1.y + u * (p2.y - p1.y);
+        res.z = p1.z + u * (p2.z - p1.z);
+        return res;
+    }
+
+    /* cubic Hermite, tangents from the neighbours (Catmull-Rom for non-uniform steps) */
+    uint8_t i3 = (s.head + k + 2) % ICM20948_RESAMPLE_HISTORY;
+    uint8_t i0 = (k > 0) ? (s.head + k - 1) % ICM20948_RESAMPLE_HISTORY : i1;
+    const xyzFloat& p0 = s.val[i0];
+    const xyzFloat& p3 = s.val[i3];
+    float d1 = (k > 0) ? h / timeDiff(s.time[i2], s.time[i0]) : 1.0;
+    float d2 = h / timeDiff(s.time[i3], s.time[i1]);
+    float u2 = u * u;
+    float u3 = u2 * u;
+    float h00 = 2 * u3 - 3 * u2 + 1;
+    float h10 = u3 - 2 * u2 + u;
+    float h01 = -2 * u3 + 3 * u2;
+    float h11 = u3 - u2;
+    res.x = h00 * p1.x + h10 * d1 * (p2.x - p0.x) + h01 * p2.x + h11 * d2 * (p3.x - p1.x);
+    res.y = h00 * p1.y + h10 * d1 * (p2.y - p0.y) + h01 * p2.y + h11 * d2 * (p3.y - p1.y);
+    res.z = h00 * p1.z + h10 * d1 * (p2.z - p0.z) + h01 * p2.z + h11 * d2 * (p3.z - p1.z);
+    return res;
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ * Resampler for the ICM20948 library. Accelerometer, gyroscope and
+ * magnetometer deliver their data at different rates (e.g. 1125 Hz and
+ * 100 Hz), and readSensor() returns the last latched magnetometer value. The
+ * resampler puts the streams on a common time line: the samples are pushed
+ * with their time stamps (micros()), getFrame() returns synchronized frames
+ * at the output rate. Per stream, the value at the frame time is:
+ *
+ * ICM20948_RESAMPLE_HOLD    the last sample before (sample and hold), no delay
+ * ICM20948_RESAMPLE_LINEAR  linear interpolation between the samples before
+ *                           and after, delay up to one input sample period
+ * ICM20948_RESAMPLE_CUBIC   Catmull-Rom interpolation (non-uniform time steps)
+ *                           over four samples, delay up to two input periods
+ *
+ * A frame is available when all enabled streams have the samples needed for
+ * its time. Hold streams don't delay the frames, but at least one stream must
+ * have reached the frame time. Each stream keeps the last
+ * ICM20948_RESAMPLE_HISTORY samples, so the memory is bounded: push batches of
+ * at most ICM20948_RESAMPLE_HISTORY - 3 samples per stream before fetching the
+ * frames. Older samples are overwritten, getOverruns() counts the ones lost
+ * before they were used.
+ *
+ * FIFO data sets have no time stamps: pushBatch() assigns them from the time
+ * of the first sample and the sample period.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_RESAMPLER_H_
+#define ICM20948_RESAMPLER_H_
+
+#include "ICM20948.h"
+
+#ifndef ICM20948_RESAMPLE_HISTORY
+#define ICM20948_RESAMPLE_HISTORY 16
+#endif
+
+typedef enum ICM20948_STREAM {
+    ICM20948_STREAM_ACC,
+    ICM20948_STREAM_GYR,
+    ICM20948_STREAM_MAG
+} ICM20948_stream;
+
+#define ICM20948_NUMBER_OF_STREAMS 3
+
+typedef enum ICM20948_RESAMPLE_MODE {
+    ICM20948_RESAMPLE_HOLD,
+    ICM20948_RESAMPLE_LINEAR,
+    ICM20948_RESAMPLE_CUBIC
+} ICM20948_resampleMode;
+
+struct ICM20948_frame {
+    uint32_t time; // µs, micros() time line of the samples
+    xyzFloat acc;
+    xyzFloat gyr;
+    xyzFloat mag;
+    uint8_t streams; // bit (1 << ICM20948_stream) set if the stream is contained
+};
+
+class ICM20948_Resampler {
+public:
+    /* Constructors */
+
+    ICM20948_Resampler(float outputRate);
+
+    /* Settings */
+
+    void setOutputRate(float outputRate);
+    void setMode(ICM20948_stream stream, ICM20948_resampleMode mode);
+    void enableStream(ICM20948_stream stream, bool enable);
+    void reset();
+
+    /* Processing */
+
+    void push(ICM20948_stream stream, uint32_t time, xyzFloat val);
+    void pushBatch(ICM20948_stream stream, const xyzFloat* val, uint16_t n, uint32_t firstTime, float samplePeriod);
+    bool getFrame(ICM20948_frame* frame);
+    uint16_t getFrames(ICM20948_frame* frames, uint16_t maxFrames);
+    uint32_t getOverruns();
+
+private:
+    struct Stream {
+        uint32_t time[ICM20948_RESAMPLE_HISTORY];
+        xyzFloat val[ICM20948_RESAMPLE_HISTORY];
+        uint8_t head; // index of the oldest sample
+        uint8_t count;
+        ICM20948_resampleMode mode;
+        bool enabled;
+    };
+    Stream streams[ICM20948_NUMBER_OF_STREAMS];
+    float period; // µs
+    bool started;
+    uint32_t outTime;
+    float outFrac; // fraction of a µs, avoids drift of the output rate
+    uint32_t overruns;
+    bool isReady(const Stream& s, uint32_t t);
+    xyzFloat valueAt(const Stream& s, uint32_t t);
+    bool start();
+};
+
+#endif
@@ -0,0 +1,230 @@
+/********************************************************************
+ * Rolling statistics for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_RollingStats.h"
+
+static const uint8_t tierSize[ICM20948_STATS_TIERS]
+    = { ICM20948_STATS_SECONDS, ICM20948_STATS_MINUTES, ICM20948_STATS_HOURS };
+static const uint8_t tierOffset[ICM20948_STATS_TIERS]
+    = { 0, ICM20948_STATS_SECONDS, ICM20948_STATS_SECONDS + ICM20948_STATS_MINUTES };
+static const uint8_t bucketsPerRollUp = 60; // seconds per minute, minutes per hour
+static const float storedScale[2] = { ICM20948_STATS_ACC_SCALE, ICM20948_STATS_GYR_SCALE };
+
+static void putUint16(uint8_t* buf, uint16_t val)
+{
+    buf[0] = val & 0xFF;
+    buf[1] = val >> 8;
+}
+
+///////////////////////////////////////////////
+// Constructors
+///////////////////////////////////////////////
+
+ICM20948_RollingStats::ICM20948_RollingStats(float sampleRate)
+{
+    setSampleRate(sampleRate);
+    reset();
+}
+
+///////////////////////////////////////////////
+// Settings
+///////////////////////////////////////////////
+
+void ICM20948_RollingStats::setSampleRate(float sampleRate)
+{
+    rateMilli = (uint32_t)(sampleRate * 1000.0 + 0.5);
+    if (rateMilli < 1000) {
+        rateMilli = 1000; // at least one sample per bucket
+    }
+    phase = 0;
+}
+
+void ICM20948_RollingStats::reset()
+{
+    for (uint8_t t = 0; t < ICM20948_STATS_TIERS; t++) {
+        resetAccumulator(accu[t]);
+        head[t] = 0;
+        count[t] = 0;
+        closed[t] = 0;
+    }
+    phase = 0;
+}
+
+///////////////////////////////////////////////
+// Processing
+///////////////////////////////////////////////
+
+void ICM20948_RollingStats::addSample(xyzFloat gVal, xyzFloat gyrVal)
+{
+    float val[2];
+    val[0] = sqrt(sq(gVal.x) + sq(gVal.y) + sq(gVal.z));
+    val[1] = sqrt(sq(gyrVal.x) + sq(gyrVal.y) + sq(gyrVal.z));
+
+    Accumulator& a = accu[ICM20948_STATS_SECOND];
+    for (uint8_t i = 0; i < 2; i++) {
+        if ((a.n == 0) || (val[i] < a.min[i])) {
+            a.min[i] = val[i];
+        }
+        if ((a.n == 0) || (val[i] > a.max[i])) {
+            a.max[i] = val[i];
+        }
+        a.sum[i] += val[i];
+        a.sqSum[i] += val[i] * val[i];
+    }
+    a.n++;
+
+    phase += 1000;
+    if (phase < rateMilli) {
+        return;
+    }
+    phase -= rateMilli;
+    closeBucket(ICM20948_STATS_SECOND);
+}
+
+uint8_t ICM20948_RollingStats::getBucketCount(ICM20948_statsTier tier)
+{
+    return count[tier];
+}
+
+bool ICM20948_RollingStats::getBucket(ICM20948_statsTier tier, uint8_t age, ICM20948_statsBucket* bucket)
+{
+    /* age 0 is the last completed bucket */
+    if (age >= count[tier]) {
+        return false;
+    }
+    uint8_t idx = (head[tier] + count[tier] - 1 - age) % tierSize[tier];
+    const StoredBucket& b = buckets[tierOffset[tier] + idx];
+    ICM20948_statsValue* dest[2] = { &bucket->acc, &bucket->gyr };
+    bucket->samples = b.n;
+    for (uint8_t i = 0; i < 2; i++) {
+        dest[i]->min = b.val[4 * i] / storedScale[i];
+        dest[i]->max = b.val[4 * i + 1] / storedScale[i];
+        dest[i]->mean = b.val[4 * i + 2] / storedScale[i];
+        dest[i]->rms = b.val[4 * i + 3] / storedScale[i];
+    }
+    return true;
+}
+
+///////////////////////////////////////////////
+// Snapshot
+///////////////////////////////////////////////
+
+uint16_t ICM20948_RollingStats::getSnapshotSize()
+{
+    uint16_t len = ICM20948_STATS_HEADER_LEN + 2 + ICM20948_TLM_CRC_LEN;
+    for (uint8_t t = 0; t < ICM20948_STATS_TIERS; t++) {
+        len += 1 + (uint16_t)count[t] * ICM20948_STATS_BUCKET_LEN;
+    }
+    return len;
+}
+
+uint16_t ICM20948_RollingStats::writeSnapshot(uint8_t* buf, uint16_t maxLen)
+{
+    uint16_t len = getSnapshotSize();
+    if (maxLen < len) {
+        return 0;
+    }
+    uint16_t pos = ICM20948_STATS_HEADER_LEN;
+    putUint16(&buf[pos], (uint16_t)((rateMilli + 50) / 100));
+    pos += 2;
+    for (uint8_t t = 0; t < ICM20948_STATS_TIERS; t++) {
+        buf[pos++] = count[t];
+        for (uint8_t i = 0; i < count[t]; i++) {
+            const StoredBucket& b = buckets[tierOffset[t] + (head[t] + i) % tierSize[t]];
+            putUint16(&buf[pos], b.n & 0xFFFF);
+            putUint16(&buf[pos + 2], b.n >> 16);
+            pos += 4;
+            for (uint8_t v = 0; v < 8; v++) {
+                putUint16(&buf[pos], b.val[v]);
+                pos += 2;
+            }
+        }
+    }
+
+    uint16_t payloadLen = pos - ICM20948_STATS_HEADER_LEN;
+    buf[0] = ICM20948_STATS_SYNC_1;
+    buf[1] = ICM20948_STATS_SYNC_2;
+    putUint16(&buf[2], payloadLen);
+    buf[4] = ICM20948_STATS_VERSION;
+    putUint16(&buf[pos], icm20948Crc16(&buf[2], pos - 2));
+    return pos + ICM20948_TLM_CRC_LEN;
+}
+
+///////////////////////////////////////////////
+// Private Functions
+///////////////////////////////////////////////
+
+void ICM20948_RollingStats::resetAccumulator(Accumulator& a)
+{
+    a.n = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        a.min[i] = 0.0;
+        a.max[i] = 0.0;
+        a.sum[i] = 0.0;
+        a.sqSum[i] = 0.0;
+    }
+}
+
+void ICM20948_RollingStats::closeBucket(uint8_t tier)
+{
+    Accumulator& a = accu[tier];
+    if (a.n == 0) {
+        return;
+    }
+
+    /* store the completed bucket, the oldest one is overwritten if the ring is full */
+    uint8_t idx;
+    if (count[tier] < tierSize[tier]) {
+        idx = (head[tier] + count[tier]) % tierSize[tier];
+        count[tier]++;
+    } else {
+        idx = head[tier];
+        head[tier] = (head[tier] + 1) % tierSize[tier];
+    }
+    StoredBucket& b = buckets[tierOffset[tier] + idx];
+    b.n = a.n;
+    for (uint8_t i = 0; i < 2; i++) {
+        b.val[4 * i] = toStored(a.min[i], storedScale[i]);
+        b.val[4 * i + 1] = toStored(a.max[i], storedScale[i]);
+        b.val[4 * i + 2] = toStored(a.sum[i] / a.n, storedScale[i]);
+        b.val[4 * i + 3] = toStored(sqrt(a.sqSum[i] / a.n), storedScale[i]);
+    }
+
+    /* roll up the exact sums into the next tier */
+    if (tier + 1 < ICM20948_STATS_TIERS) {
+        Accumulator& next = accu[tier + 1];
+        for (uint8_t i = 0; i < 2; i++) {
+            if ((next.n == 0) || (a.min[i] < next.min[i])) {
+                next.min[i] = a.min[i];
+            }
+            if ((next.n == 0) || (a.max[i] > next.max[i])) {
+                next.max[i] = a.max[i];
+            }
+            next.sum[i] += a.sum[i];
+            next.sqSum[i] += a.sqSum[i];
+        }
+        next.n += a.n;
+    }
+    resetAccumulator(a);
+
+    if (tier + 1 < ICM20948_STATS_TIERS) {
+        closed[tier]++;
+        if (closed[tier] == bucketsPerRollUp) {
+            closed[tier] = 0;
+            closeBucket(tier + 1);
+        }
+    }
+}
+
+uint16_t ICM20948_RollingStats::toStored(float val, float scale)
+{
+    float stored = val * scale + 0.5;
+    return (stored > 65535.0) ? 65535 : (uint16_t)stored;
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ * Rolling statistics for the ICM20948 library. Instead of sending raw data,
+ * the device keeps min, max, mean and RMS of the resultant acceleration (g,
+ * like getResultantG()) and of the resultant rotation rate (degrees/s) in
+ * three tiers: seconds, minutes and hours. Each tier keeps a ring of the last
+ * completed buckets (ICM20948_STATS_SECONDS, _MINUTES, _HOURS), so the memory
+ * is fixed.
+ *
+ * addSample() only updates the open second bucket. When a second is complete
+ * (counted from the sample rate, so FIFO data without time stamps can be fed
+ * as well), its accumulator is folded into the open minute bucket, and a
+ * complete minute into the open hour bucket. So each sample costs O(1) and
+ * the minute and hour values are exact, not means of rounded values.
+ *
+ * The completed buckets are stored with 16 bit values (acceleration in mg,
+ * rotation rate in 0.1 degrees/s). writeSnapshot() serializes all of them:
+ *
+ *   0xA5 0x5B            sync
+ *   length               2 bytes, little endian, number of payload bytes
+ *   version              1 byte
+ *   payload:
+ *     sample rate        2 bytes, 0.1 Hz
+ *     per tier (seconds, minutes, hours):
+ *       buckets          1 byte, number of buckets
+ *       bucket           oldest first, 20 bytes each:
+ *                        samples (4 bytes), acc min, max, mean, rms,
+ *                        gyr min, max, mean, rms (2 bytes each)
+ *   crc                  2 bytes, CRC-16/CCITT over length ... payload
+ *
+ * All multi byte values are little endian.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_ROLLING_STATS_H_
+#define ICM20948_ROLLING_STATS_H_
+
+#include "ICM20948.h"
+#include "ICM20948_Telemetry.h"
+
+#ifndef ICM20948_STATS_SECONDS
+#define ICM20948_STATS_SECONDS 10
+#endif
+#ifndef ICM20948_STATS_MINUTES
+#define ICM20948_STATS_MINUTES 10
+#endif
+#ifndef ICM20948_STATS_HOURS
+#define ICM20948_STATS_HOURS 24
+#endif
+
+#define ICM20948_STATS_SYNC_1 0xA5
+#define ICM20948_STATS_SYNC_2 0x5B
+#define ICM20948_STATS_VERSION 1
+#define ICM20948_STATS_HEADER_LEN 5 // sync, length, version
+#define ICM20948_STATS_BUCKET_LEN 20
+#define ICM20948_STATS_ACC_SCALE 1000.0 // mg
+#define ICM20948_STATS_GYR_SCALE 10.0 // 0.1 dps
+
+typedef enum ICM20948_STATS_TIER {
+    ICM20948_STATS_SECOND,
+    ICM20948_STATS_MINUTE,
+    ICM20948_STATS_HOUR
+} ICM20948_statsTier;
+
+#define ICM20948_STATS_TIERS 3
+
+struct ICM20948_statsValue {
+    float min;
+    float max;
+    float mean;
+    float rms;
+};
+
+struct ICM20948_statsBucket {
+    uint32_t samples;
+    ICM20948_statsValue acc; // resultant g
+    ICM20948_statsValue gyr; // resultant degrees/s
+};
+
+class ICM20948_RollingStats {
+public:
+    /* Constructors */
+
+    ICM20948_RollingStats(float sampleRate);
+
+    /* Settings */
+
+    void setSampleRate(float sampleRate);
+    void reset();
+
+    /* Processing */
+
+    void addSample(xyzFloat gVal, xyzFloat gyrVal);
+    uint8_t getBucketCount(ICM20948_statsTier tier);
+    bool getBucket(ICM20948_statsTier tier, uint8_t age, ICM20948_statsBucket* bucket);
+
+    /* Snapshot */
+
+    uint16_t getSnapshotSize();
+    uint16_t writeSnapshot(uint8_t* buf, uint16_t maxLen);
+
+private:
+    struct Accumulator {
+        uint32_t n;
+        float min[2];
+        float max[2];
+        float sum[2];
+        float sqSum[2];
+    };
+    struct StoredBucket {
+        uint32_t n;
+        uint16_t val[8]; // acc min, max, mean, rms, gyr min, max, mean, rms
+    };
+    StoredBucket buckets[ICM20948_STATS_SECONDS + ICM20948_STATS_MINUTES + ICM20948_STATS_HOURS];
+    Accumulator accu[ICM20948_STATS_TIERS];
+    uint8_t head[ICM20948_STATS_TIERS]; // index of the oldest bucket
+    uint8_t count[ICM20948_STATS_TIERS];
+    uint8_t closed[ICM20948_STATS_TIERS]; // completed buckets since the last roll up
+    uint32_t rateMilli; // sample rate in mHz
+    uint32_t phase; // mHz steps since the last second
+    void resetAccumulator(Accumulator& a);
+    void closeBucket(uint8_t tier);
+    static uint16_t toStored(float val, float scale);
+};
+
+#endif
@@ -0,0 +1,272 @@
+/******************************************************************************
+ *
+ * Vibration spectrum of raw ICM20948 data. Samples (e.g. from
+ * ICM20948::readFifoRawDataSets()) are collected into windows of N values. Each
+ * complete window is processed:
+ *
+ * 1. removal of the mean value (gravity, offsets)
+ * 2. Hann window
+ * 3. fixed-point real FFT: an N/2 point complex radix-2 FFT, in place, scaled
+ *    by 1/2 per stage, followed by a split step
+ * 4. the power spectrum is added to an average over the windows
+ *
+ * Results are in raw units (LSB). Multiply amplitudes with the range dependent
+ * scale factor to get g or degrees/s.
+ *
+ * N is a template parameter (power of 2, 16...4096), all buffers are members.
+ * RAM: about 2 * N + 2 * N + N + 4 bytes, e.g. ~1.3 kB for N = 256.
+ *
+ * Example:
+ * ICM20948_Spectrum<256> spectrum(1125.0);
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_SPECTRUM_H_
+#define ICM20948_SPECTRUM_H_
+
+#include <Arduino.h>
+
+template <uint16_t N>
+class ICM20948_Spectrum {
+    static_assert((N >= 16) && (N <= 4096) && ((N & (N - 1)) == 0), "N must be a power of 2 (16...4096)");
+
+public:
+    static constexpr uint16_t BINS = N / 2 + 1;
+
+    /* Constructors */
+
+    ICM20948_Spectrum(float rate = 1125.0)
+    {
+        for (uint16_t k = 0; k <= N / 4; k++) {
+            sinTab[k] = (int16_t)(32767.0 * sin(2.0 * PI * k / N) + 0.5);
+        }
+        sampleRate = rate;
+        fill = 0;
+        resetAverage();
+    }
+
+    /* Settings */
+
+    void setSampleRate(float rate)
+    {
+        sampleRate = rate;
+    }
+
+    void resetAverage()
+    {
+        for (uint16_t k = 0; k < BINS; k++) {
+            power[k] = 0.0;
+        }
+        windows = 0;
+    }
+
+    /* Processing, returns the number of windows completed by this call */
+
+    uint16_t addSamples(const int16_t* data, uint16_t len, uint8_t stride = 1)
+    {
+        uint16_t completed = 0;
+        while (len--) {
+            buf[fill++] = *data;
+            data += stride;
+            if (fill == N) {
+                processWindow();
+                fill = 0;
+                completed++;
+            }
+        }
+        return completed;
+    }
+
+    /* Results */
+
+    uint32_t getWindowCount()
+    {
+        return windows;
+    }
+
+    float getBinFrequency(uint16_t bin)
+    {
+        return bin * sampleRate / N;
+    }
+
+    float getPower(uint16_t bin) // mean square in LSB^2
+    {
+        if ((windows == 0) || (bin >= BINS)) {
+            return 0.0;
+        }
+        return power[bin] / windows * (4.0 / 3.0);
+    }
+
+    float getAmplitude(uint16_t bin) // amplitude of a sine wave at the bin frequency
+    {
+        if ((windows == 0) || (bin >= BINS)) {
+            return 0.0;
+        }
+        return 2.0 * sqrt(power[bin] / windows);
+    }
+
+    float getBandRms(float fLow, float fHigh)
+    {
+        uint16_t first = (uint16_t)(fLow * N / sampleRate + 0.5);
+        uint16_t last = (uint16_t)(fHigh * N / sampleRate + 0.5);
+        if (first < 1) {
+            first = 1; // the mean value has been removed
+        }
+        if (last >= BINS) {
+            last = BINS - 1;
+        }
+        float sum = 0.0;
+        for (uint16_t k = first; k <= last; k++) {
+            sum += getPower(k);
+        }
+        return sqrt(sum);
+    }
+
+    /* Finds the strongest local maxima, sorted by amplitude. The frequency is
+     * interpolated between the bins. Returns the number of peaks found. */
+    uint8_t getPeaks(float* freq, float* amplitude, uint8_t maxPeaks)
+    {
+        uint8_t found = 0;
+        if (windows == 0) {
+            return 0;
+        }
+        for (uint16_t k = 1; k < BINS - 1; k++) {
+            if ((power[k] <= power[k - 1]) || (power[k] < power[k + 1])) {
+                continue;
+            }
+            float amp = getAmplitude(k);
+            uint8_t pos = found;
+            while ((pos > 0) && (amplitude[pos - 1] < amp)) {
+                if (pos < maxPeaks) {
+                    freq[pos] = freq[pos - 1];
+                    amplitude[pos] = amplitude[pos - 1];
+                }
+                pos--;
+            }
+            if (pos >= maxPeaks) {
+                continue;
+            }
+            /* parabolic interpolation of the log magnitudes */
+            float l = log(power[k - 1] + 1e-9);
+            float c = log(power[k] + 1e-9);
+            float r = log(power[k + 1] + 1e-9);
+            float denom = l - 2.0 * c + r;
+            float delta = (denom != 0.0) ? 0.5 * (l - r) / denom : 0.0;
+            freq[pos] = (k + delta) * sampleRate / N;
+            amplitude[pos] = amp;
+            if (found < maxPeaks) {
+                found++;
+            }
+        }
+        return found;
+    }
+
+private:
+    int16_t buf[N]; // samples, then N/2 complex values (re, im)
+    float power[BINS];
+    int16_t sinTab[N / 4 + 1]; // sin(2 * PI * k / N), Q15
+    float sampleRate;
+    uint16_t fill;
+    uint32_t windows; // averaged so far, 16 bit would wrap in long runs
+
+    int16_t sinQ15(uint16_t k) // k = 0...N/2
+    {
+        return (k <= N / 4) ? sinTab[k] : sinTab[N / 2 - k];
+    }
+
+    int16_t cosQ15(uint16_t k) // k = 0...N/2
+    {
+        return (k <= N / 4) ? sinTab[N / 4 - k] : -sinTab[k - N / 4];
+    }
+
+    static int16_t saturate16(int32_t val)
+    {
+        return (val > 32767) ? 32767 : ((val < -32768) ? -32768 : (int16_t)val);
+    }
+
+    void processWindow()
+    {
+        int32_t sum = 0;
+        for (uint16_t n = 0; n < N; n++) {
+            sum += buf[n];
+        }
+        int16_t mean = sum / (int32_t)N;
+        for (uint16_t n = 0; n < N; n++) {
+            int32_t hann = (32768L - cosQ15((n <= N / 2) ? n : N - n)) >> 1;
+            buf[n] = saturate16((((int32_t)buf[n] - mean) * hann) >> 15);
+        }
+
+        fft();
+
+        /* split step: spectrum of the real sequence from the N/2 point complex FFT */
+        const uint16_t M = N / 2;
+        for (uint16_t k = 0; k <= M; k++) {
+            uint16_t a = (k == M) ? 0 : k;
+            uint16_t b = (k == 0) ? 0 : M - k;
+            int32_t zkRe = buf[2 * a], zkIm = buf[2 * a + 1];
+            int32_t zmRe = buf[2 * b], zmIm = buf[2 * b + 1];
+            int32_t feRe = (zkRe + zmRe) >> 1;
+            int32_t feIm = (zkIm - zmIm) >> 1;
+            int32_t foRe = (zkRe - zmRe) >> 1;
+            int32_t foIm = (zkIm + zmIm) >> 1;
+            int32_t c = cosQ15(k);
+            int32_t s = sinQ15(k);
+            int32_t tRe = (c * foRe + s * foIm) >> 15;
+            int32_t tIm = (c * foIm - s * foRe) >> 15;
+            float re = feRe + tIm;
+            float im = feIm - tRe;
+            power[k] += re * re + im * im;
+        }
+        windows++;
+    }
+
+    void fft()
+    {
+        const uint16_t M = N / 2;
+        int16_t* z = buf;
+
+        for (uint16_t i = 1, j = 0; i < M; i++) {
+            uint16_t bit = M >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j |= bit;
+            if (i < j) {
+                int16_t tmp = z[2 * i];
+                z[2 * i] = z[2 * j];
+                z[2 * j] = tmp;
+                tmp = z[2 * i + 1];
+                z[2 * i + 1] = z[2 * j + 1];
+                z[2 * j + 1] = tmp;
+            }
+        }
+
+        for (uint16_t len = 2; len <= M; len <<= 1) {
+            uint16_t half = len >> 1;
+            uint16_t step = N / len;
+            for (uint16_t i = 0; i < M; i += len) {
+                for (uint16_t j = 0; j < half; j++) {
+                    int32_t c = cosQ15(j * step);
+                    int32_t s = sinQ15(j * step);
+                    int16_t* u = &z[2 * (i + j)];
+                    int16_t* v = &z[2 * (i + j + half)];
+                    int32_t vRe = (v[0] * c + v[1] * s) >> 15;
+                    int32_t vIm = (v[1] * c - v[0] * s) >> 15;
+                    int32_t uRe = u[0];
+                    int32_t uIm = u[1];
+                    u[0] = (uRe + vRe) >> 1;
+                    u[1] = (uIm + vIm) >> 1;
+                    v[0] = (uRe - vRe) >> 1;
+                    v[1] = (uIm - vIm) >> 1;
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,249 @@
+/********************************************************************
+ * Compact binary telemetry for the ICM20948 library.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ *********************************************************************/
+
+#include "ICM20948_Telemetry.h"
+
+uint16_t icm20948Crc16(const uint8_t* data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+///////////////////////////////////////////////
+// Encoder
+///////////////////////////////////////////////
+
+ICM20948_TelemetryEncoder::ICM20948_TelemetryEncoder(uint8_t channels)
+{
+    numChannels = (channels > ICM20948_TLM_MAX_CHANNELS) ? ICM20948_TLM_MAX_CHANNELS : channels;
+    sequence = 0;
+    resetStats();
+}
+
+uint16_t ICM20948_TelemetryEncoder::encode(const int16_t* data, uint8_t sets, uint8_t* packet, uint16_t maxLen)
+{
+    uint32_t start = micros();
+    int16_t prev[ICM20948_TLM_MAX_CHANNELS] = { 0 };
+    uint16_t pos = ICM20948_TLM_HEADER_LEN;
+    uint16_t limit = maxLen - ICM20948_TLM_CRC_LEN;
+
+    if ((maxLen < (ICM20948_TLM_HEADER_LEN + ICM20948_TLM_CRC_LEN)) || (sets > ICM20948_TLM_MAX_SETS)) {
+        return 0; // more sets than the decoder accepts
+    }
+
+    for (uint8_t s = 0; s < sets; s++) {
+        for (uint8_t c = 0; c < numChannels; c++) {
+            int32_t delta = (int32_t)*data - prev[c];
+            prev[c] = *data++;
+            uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+            do {
+                if (pos >= limit) {
+                    return 0; // packet buffer too small
+                }
+                uint8_t val = zigzag & 0x7F;
+                zigzag >>= 7;
+                packet[pos++] = zigzag ? (val | 0x80) : val;
+            } while (zigzag);
+        }
+    }
+
+    uint16_t payloadLen = pos - ICM20948_TLM_HEADER_LEN;
+    packet[0] = ICM20948_TLM_SYNC_1;
+    packet[1] = ICM20948_TLM_SYNC_2;
+    packet[2] = payloadLen & 0xFF;
+    packet[3] = payloadLen >> 8;
+    packet[4] = sequence++;
+    packet[5] = numChannels;
+    packet[6] = sets;
+    uint16_t crc = icm20948Crc16(&packet[2], pos - 2);
+    packet[pos++] = crc & 0xFF;
+    packet[pos++] = crc >> 8;
+
+    rawBytes += (uint32_t)sets * numChannels * 2;
+    encodedBytes += pos;
+    encodeMicros += micros() - start;
+    return pos;
+}
+
+uint16_t ICM20948_TelemetryEncoder::getMaxPacketSize(uint8_t channels, uint8_t sets)
+{
+    return ICM20948_TLM_HEADER_LEN + (uint16_t)channels * sets * ICM20948_TLM_MAX_VARINT_LEN + ICM20948_TLM_CRC_LEN;
+}
+
+float ICM20948_TelemetryEncoder::getCompressionRatio()
+{
+    if (encodedBytes == 0) {
+        return 0.0;
+    }
+    return (float)rawBytes / encodedBytes;
+}
+
+float ICM20948_TelemetryEncoder::getMicrosPerValue()
+{
+    if (rawBytes == 0) {
+        return 0.0;
+    }
+    return encodeMicros * 2.0 / rawBytes;
+}
+
+void ICM20948_TelemetryEncoder::resetStats()
+{
+    rawBytes = 0;
+    encodedBytes = 0;
+    encodeMicros = 0;
+}
+
+///////////////////////////////////////////////
+// Decoder
+///////////////////////////////////////////////
+
+ICM20948_TelemetryDecoder::ICM20948_TelemetryDecoder()
+{
+    packetPos = 0;
+    packetLen = 0;
+    numChannels = 0;
+    numSets = 0;
+    sequence = 0;
+    synced = false;
+    packetCount = 0;
+    crcErrors = 0;
+    formatErrors = 0;
+    lostPackets = 0;
+}
+
+bool ICM20948_TelemetryDecoder::push(uint8_t val)
+{
+    if ((packetPos == 0) && (val != ICM20948_TLM_SYNC_1)) {
+        return false;
+    }
+    if ((packetPos == 1) && (val != ICM20948_TLM_SYNC_2)) {
+        packetPos = (val == ICM20948_TLM_SYNC_1) ? 1 : 0;
+        return false;
+    }
+    packetBuf[packetPos++] = val;
+
+    if (packetPos == 4) {
+        packetLen = ICM20948_TLM_HEADER_LEN + (packetBuf[2] | (packetBuf[3] << 8)) + ICM20948_TLM_CRC_LEN;
+        if (packetLen > sizeof(packetBuf)) {
+            formatErrors++;
+            packetPos = 0; // not a valid packet, search next sync
+        }
+        return false;
+    }
+    if ((packetPos < ICM20948_TLM_HEADER_LEN) || (packetPos < packetLen)) {
+        return false;
+    }
+
+    packetPos = 0;
+    return decode(packetBuf, packetLen);
+}
+
+bool ICM20948_TelemetryDecoder::decode(const uint8_t* packet, uint16_t len)
+{
+    if ((len < (ICM20948_TLM_HEADER_LEN + ICM20948_TLM_CRC_LEN)) || (packet[0] != ICM20948_TLM_SYNC_1)
+        || (packet[1] != ICM20948_TLM_SYNC_2)) {
+        return false;
+    }
+    uint16_t payloadLen = packet[2] | (packet[3] << 8);
+    if (len < (ICM20948_TLM_HEADER_LEN + payloadLen + ICM20948_TLM_CRC_LEN)) {
+        return false;
+    }
+    uint16_t end = ICM20948_TLM_HEADER_LEN + payloadLen;
+    uint16_t crc = packet[end] | (packet[end + 1] << 8);
+    if (crc != icm20948Crc16(&packet[2], end - 2)) {
+        crcErrors++;
+        return false;
+    }
+    uint8_t channels = packet[5];
+    uint8_t sets = packet[6];
+    if ((channels > ICM20948_TLM_MAX_CHANNELS) || (sets > ICM20948_TLM_MAX_SETS)) {
+        formatErrors++;
+        return false;
+    }
+
+    int16_t prev[ICM20948_TLM_MAX_CHANNELS] = { 0 };
+    uint16_t pos = ICM20948_TLM_HEADER_LEN;
+    int16_t* out = values;
+    for (uint8_t s = 0; s < sets; s++) {
+        for (uint8_t c = 0; c < channels; c++) {
+            uint32_t zigzag = 0;
+            uint8_t shift = 0;
+            uint8_t val;
+            do {
+                if ((pos >= end) || (shift > 28)) { // truncated or longer than 5 bytes
+                    formatErrors++;
+                    return false;
+                }
+                val = packet[pos++];
+                zigzag |= (uint32_t)(val & 0x7F) << shift;
+                shift += 7;
+            } while (val & 0x80);
+            int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            prev[c] = (int16_t)(prev[c] + delta);
+            *out++ = prev[c];
+        }
+    }
+
+    if (synced) {
+        lostPackets += (uint8_t)(packet[4] - sequence - 1);
+    }
+    synced = true;
+    sequence = packet[4];
+    numChannels = channels;
+    numSets = sets;
+    packetCount++;
+    return true;
+}
+
+uint8_t ICM20948_TelemetryDecoder::getChannels()
+{
+    return numChannels;
+}
+
+uint8_t ICM20948_TelemetryDecoder::getSets()
+{
+    return numSets;
+}
+
+uint8_t ICM20948_TelemetryDecoder::getSequence()
+{
+    return sequence;
+}
+
+const int16_t* ICM20948_TelemetryDecoder::getData()
+{
+    return values;
+}
+
+uint32_t ICM20948_TelemetryDecoder::getPacketCount()
+{
+    return packetCount;
+}
+
+uint32_t ICM20948_TelemetryDecoder::getCrcErrors()
+{
+    return crcErrors;
+}
+
+uint32_t ICM20948_TelemetryDecoder::getFormatErrors()
+{
+    return formatErrors;
+}
+
+uint32_t ICM20948_TelemetryDecoder::getLostPackets()
+{
+    return lostPackets;
+}
@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ * Compact binary telemetry for raw ICM20948 data, e.g. from
+ * ICM20948::readFifoRawDataSets(). The encoder packs a batch of int16 data sets
+ * into one packet: each value is stored as difference to the previous value of
+ * the same channel, zigzag encoded (small negative and positive numbers become
+ * small positive numbers) and written as varint (7 bits per byte). Slowly
+ * changing signals need about one byte per value instead of two.
+ *
+ * Packet:
+ *   0xA5 0x5A            sync
+ *   length               2 bytes, little endian, number of payload bytes
+ *   sequence             1 byte, incremented with every packet
+ *   channels             1 byte, values per data set (1...6)
+ *   sets                 1 byte, number of data sets (max. ICM20948_TLM_MAX_SETS,
+ *                        encode() returns 0 for more)
+ *   payload              varints, data set by data set. The first data set is
+ *                        encoded relative to 0, so every packet can be decoded
+ *                        on its own.
+ *   crc                  2 bytes, CRC-16/CCITT over length ... payload
+ *
+ * The decoder runs on the receiving side (host or MCU) and can be fed byte by
+ * byte from a serial stream.
+ *
+ * Further information can be found on:
+ *
+ * https://wolles-elektronikkiste.de/icm-20948-9-achsensensor-teil-i (German)
+ * https://wolles-elektronikkiste.de/en/icm-20948-9-axis-sensor-part-i (English)
+ *
+ ******************************************************************************/
+
+#ifndef ICM20948_TELEMETRY_H_
+#define ICM20948_TELEMETRY_H_
+
+#include <Arduino.h>
+
+#define ICM20948_TLM_SYNC_1 0xA5
+#define ICM20948_TLM_SYNC_2 0x5A
+#define ICM20948_TLM_HEADER_LEN 7 // sync, length, sequence, channels, sets
+#define ICM20948_TLM_CRC_LEN 2
+#define ICM20948_TLM_MAX_CHANNELS 6
+#define ICM20948_TLM_MAX_SETS 64 // limit of the decoder buffer
+#define ICM20948_TLM_MAX_VARINT_LEN 3 // zigzag of a 16 bit difference fits into 17 bits
+
+class ICM20948_TelemetryEncoder {
+public:
+    /* Constructors */
+
+    ICM20948_TelemetryEncoder(uint8_t channels);
+
+    /* Encoding */
+
+    uint16_t encode(const int16_t* data, uint8_t sets, uint8_t* packet, uint16_t maxLen);
+    static uint16_t getMaxPacketSize(uint8_t channels, uint8_t sets);
+
+    /* Statistics */
+
+    float getCompressionRatio();
+    float getMicrosPerValue();
+    void resetStats();
+
+private:
+    uint8_t numChannels;
+    uint8_t sequence;
+    uint32_t rawBytes;
+    uint32_t encodedBytes;
+    uint32_t encodeMicros;
+};
+
+class ICM20948_TelemetryDecoder {
+public:
+    /* Constructors */
+
+    ICM20948_TelemetryDecoder();
+
+    /* Decoding */
+
+    bool push(uint8_t val);
+    bool decode(const uint8_t* packet, uint16_t len);
+    uint8_t getChannels();
+    uint8_t getSets();
+    uint8_t getSequence();
+    const int16_t* getData();
+
+    /* Statistics */
+
+    uint32_t getPacketCount();
+    uint32_t getCrcErrors();
+    uint32_t getFormatErrors(); // length, sets or channels out of range, truncated payload, varint > 5 bytes
+    uint32_t getLostPackets();
+
+private:
+    uint8_t packetBuf[ICM20948_TLM_HEADER_LEN + ICM20948_TLM_MAX_SETS * ICM20948_TLM_MAX_CHANNELS * ICM20948_TLM_MAX_VARINT_LEN
+        + ICM20948_TLM_CRC_LEN];
+    uint16_t packetPos;
+    uint16_t packetLen;
+    int16_t values[ICM20948_TLM_MAX_SETS * ICM20948_TLM_MAX_CHANNELS];
+    uint8_t numChannels;
+    uint8_t numSets;
+    uint8_t sequence;
+    bool synced; // at least one packet received, lost packets can be counted
+    uint32_t packetCount;
+    uint32_t crcErrors;
+    uint32_t formatErrors;
+    uint32_t lostPackets;
+};
+
+uint16_t icm20948Crc16(const uint8_t* data, uint16_t len);
+
+#endif